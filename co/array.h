@@ -21,6 +21,7 @@
 #define CO_ARRAY_H
 
 #include <co/types.h>
+#include <type_traits>
 
 namespace co
 {
@@ -42,6 +43,33 @@ namespace co
     template<> inline size_t Array< void >::getNumBytes() const { return num; }
     template<> inline size_t Array< const void >::getNumBytes() const
         { return num; }
+
+    /**
+     * Selects bulk (de)serialization for containers of T.
+     *
+     * Containers of flat types are streamed as one block of raw element
+     * bytes, instead of one stream operation per element. Arithmetic types
+     * except bool are flat. Other types are opted in by specializing this
+     * trait to std::true_type, which is only correct if T has no custom
+     * stream operators and is streamed as its raw bytes.
+     * @version 1.0
+     */
+    template< class T > struct IsFlat
+        : public std::integral_constant< bool, std::is_arithmetic< T >::value >
+    {};
+
+    /** std::vector< bool > has no contiguous storage. */
+    template<> struct IsFlat< bool > : public std::false_type {};
+
+    /**
+     * @internal Selects the varint encoding of single values of T in compact
+     * streams, see Node::setCompactData(). Containers of flat integers are
+     * still streamed as raw blocks.
+     */
+    template< class T > struct IsVarint
+        : public std::integral_constant< bool, ( std::is_integral< T >::value &&
+                                                 sizeof( T ) > 1 &&
+                                                 sizeof( T ) <= 8 ) > {};
 }
 
 #endif // CO_ARRAY_H
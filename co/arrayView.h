@@ -0,0 +1,78 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_ARRAYVIEW_H
+#define CO_ARRAYVIEW_H
+
+#include <co/buffer.h> // ConstBufferPtr member
+#include <lunchbox/debug.h>
+
+namespace co
+{
+    /**
+     * A read-only view on an array of items received by a DataIStream.
+     *
+     * The view references the data in place, in the received or decompressed
+     * buffer of the stream, and holds a reference on this buffer. The buffer
+     * stays valid, and is not reused for other data, for as long as any copy
+     * of the view exists, independent of the lifetime of the stream.
+     *
+     * @sa DataIStream::readView()
+     */
+    template< class T > class ArrayView
+    {
+    public:
+        typedef const T* const_iterator;
+
+        /** Construct an empty view. @version 1.0 */
+        ArrayView() : _data( 0 ), _num( 0 ) {}
+
+        /** @internal Construct a view on data held by the given buffer. */
+        ArrayView( const T* data, const size_t num, ConstBufferPtr buffer )
+            : _data( data ), _num( num ), _buffer( buffer ) {}
+
+        /** @return the items of this view. @version 1.0 */
+        const T* getData() const { return _data; }
+
+        /** @return the number of items in this view. @version 1.0 */
+        size_t getSize() const { return _num; }
+
+        /** @return the number of bytes of all items. @version 1.0 */
+        size_t getNumBytes() const { return _num * sizeof( T ); }
+
+        /** @return true if the view has no items. @version 1.0 */
+        bool isEmpty() const { return _num == 0; }
+
+        /** @return the item at the given index. @version 1.0 */
+        const T& operator[]( const size_t i ) const
+            { LBASSERT( i < _num ); return _data[ i ]; }
+
+        const_iterator begin() const { return _data; } //!< @version 1.0
+        const_iterator end() const { return _data + _num; } //!< @version 1.0
+
+        /** @internal @return the buffer holding the items. */
+        ConstBufferPtr getBuffer() const { return _buffer; }
+
+    private:
+        const T* _data;
+        size_t _num;
+        ConstBufferPtr _buffer;
+    };
+}
+
+#endif // CO_ARRAYVIEW_H
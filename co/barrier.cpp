@@ -142,12 +142,14 @@ void Barrier::attach( const UUID& id, const uint32_t instanceID )
     Object::attach( id, instanceID );
 
     LocalNodePtr node = getLocalNode();
-    CommandQueue* queue = node->getCommandThreadQueue();
+    CommandQueue* queue = node->getCommandPoolQueue();
 
     registerCommand( CMD_BARRIER_ENTER,
-                     CmdFunc( this, &Barrier::_cmdEnter ), queue );
+                     CmdFunc( this, &Barrier::_cmdEnter ), queue,
+                     COMMANDPRIORITY_HIGH );
     registerCommand( CMD_BARRIER_ENTER_REPLY,
-                     CmdFunc( this, &Barrier::_cmdEnterReply ), queue );
+                     CmdFunc( this, &Barrier::_cmdEnterReply ), queue,
+                     COMMANDPRIORITY_HIGH );
 
     if( _impl->masterID == NodeID( ))
         _impl->masterID = node->getNodeID();
@@ -0,0 +1,220 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "byteSwap.h"
+
+#include <lunchbox/debug.h>
+
+#include <string.h>
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ))
+#  define CO_BYTESWAP_X86
+#  include <immintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#  define CO_BYTESWAP_NEON
+#  include <arm_neon.h>
+#endif
+
+namespace co
+{
+namespace
+{
+// Arrays are swapped in blocks of this size, in parallel from the threshold
+// on. Below it, starting the OpenMP threads costs more than the swap itself.
+static const uint64_t _blockSize = LB_64KB;
+static const uint64_t _parallelThreshold = LB_1MB;
+
+typedef void ( *Kernel )( const uint8_t*, uint8_t*, const uint64_t,
+                          const size_t );
+
+template< size_t N >
+void _swapScalar( const uint8_t* in, uint8_t* out, const uint64_t size )
+{
+    for( uint64_t i = 0; i < size; i += N )
+    {
+        uint8_t word[ N ];
+        ::memcpy( word, in + i, N );
+        for( size_t j = 0; j < N; ++j )
+            out[ i + j ] = word[ N - 1 - j ];
+    }
+}
+
+void _swapScalar( const uint8_t* in, uint8_t* out, const uint64_t size,
+                  const size_t wordSize )
+{
+    switch( wordSize )
+    {
+    case 2: _swapScalar< 2 >( in, out, size ); return;
+    case 4: _swapScalar< 4 >( in, out, size ); return;
+    case 8: _swapScalar< 8 >( in, out, size ); return;
+    }
+
+    // other word sizes, e.g., long double, swap byte pairs to allow in == out
+    for( uint64_t i = 0; i < size; i += wordSize )
+    {
+        for( size_t j = 0; j < wordSize / 2; ++j )
+        {
+            const uint8_t first = in[ i + j ];
+            out[ i + j ] = in[ i + wordSize - 1 - j ];
+            out[ i + wordSize - 1 - j ] = first;
+        }
+        if( wordSize % 2 )
+            out[ i + wordSize / 2 ] = in[ i + wordSize / 2 ];
+    }
+}
+
+#ifdef CO_BYTESWAP_X86
+// pshufb masks reversing each word, repeated for both lanes of AVX2
+static const uint8_t _masks[3][32] = {
+    { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+      1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 },
+    { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },
+    { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+      7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 }};
+
+const uint8_t* _getMask( const size_t wordSize )
+{
+    switch( wordSize )
+    {
+    case 2:  return _masks[0];
+    case 4:  return _masks[1];
+    default:
+        LBASSERTINFO( wordSize == 8, wordSize );
+        return _masks[2];
+    }
+}
+
+__attribute__(( target( "ssse3" )))
+void _swapSSSE3( const uint8_t* in, uint8_t* out, const uint64_t size,
+                 const size_t wordSize )
+{
+    const __m128i mask = _mm_loadu_si128(
+        reinterpret_cast< const __m128i* >( _getMask( wordSize )));
+    uint64_t i = 0;
+    for( ; i + 16 <= size; i += 16 )
+    {
+        const __m128i data = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( in + i ));
+        _mm_storeu_si128( reinterpret_cast< __m128i* >( out + i ),
+                          _mm_shuffle_epi8( data, mask ));
+    }
+    _swapScalar( in + i, out + i, size - i, wordSize );
+}
+
+__attribute__(( target( "avx2" )))
+void _swapAVX2( const uint8_t* in, uint8_t* out, const uint64_t size,
+                const size_t wordSize )
+{
+    const __m256i mask = _mm256_loadu_si256(
+        reinterpret_cast< const __m256i* >( _getMask( wordSize )));
+    uint64_t i = 0;
+    for( ; i + 32 <= size; i += 32 )
+    {
+        const __m256i data = _mm256_loadu_si256(
+            reinterpret_cast< const __m256i* >( in + i ));
+        _mm256_storeu_si256( reinterpret_cast< __m256i* >( out + i ),
+                             _mm256_shuffle_epi8( data, mask ));
+    }
+    _swapScalar( in + i, out + i, size - i, wordSize );
+}
+#endif
+
+#ifdef CO_BYTESWAP_NEON
+template< size_t N > uint8x16_t _reverse( const uint8x16_t data );
+template<> uint8x16_t _reverse< 2 >( const uint8x16_t data )
+    { return vrev16q_u8( data ); }
+template<> uint8x16_t _reverse< 4 >( const uint8x16_t data )
+    { return vrev32q_u8( data ); }
+template<> uint8x16_t _reverse< 8 >( const uint8x16_t data )
+    { return vrev64q_u8( data ); }
+
+template< size_t N >
+void _swapNEON( const uint8_t* in, uint8_t* out, const uint64_t size )
+{
+    uint64_t i = 0;
+    for( ; i + 16 <= size; i += 16 )
+        vst1q_u8( out + i, _reverse< N >( vld1q_u8( in + i )));
+    _swapScalar< N >( in + i, out + i, size - i );
+}
+
+void _swapNEON( const uint8_t* in, uint8_t* out, const uint64_t size,
+                const size_t wordSize )
+{
+    switch( wordSize )
+    {
+    case 2: _swapNEON< 2 >( in, out, size ); return;
+    case 4: _swapNEON< 4 >( in, out, size ); return;
+    case 8: _swapNEON< 8 >( in, out, size ); return;
+    default:
+        LBUNIMPLEMENTED;
+    }
+}
+#endif
+
+Kernel _selectKernel()
+{
+#ifdef CO_BYTESWAP_X86
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "avx2" ))
+        return _swapAVX2;
+    if( __builtin_cpu_supports( "ssse3" ))
+        return _swapSSSE3;
+#elif defined( CO_BYTESWAP_NEON )
+    return _swapNEON;
+#endif
+    return _swapScalar;
+}
+
+Kernel _getKernel()
+{
+    static const Kernel kernel = _selectKernel();
+    return kernel;
+}
+}
+
+void swapWords( const void* in, void* out, const uint64_t size,
+                const size_t wordSize )
+{
+    LBASSERTINFO( size % wordSize == 0, size << " bytes of " << wordSize <<
+                  " byte words" );
+    if( wordSize < 2 )
+    {
+        if( in != out )
+            ::memcpy( out, in, size );
+        return;
+    }
+
+    // the vector kernels only handle 2, 4 and 8 byte words
+    Kernel kernel = _swapScalar;
+    if( wordSize == 2 || wordSize == 4 || wordSize == 8 )
+        kernel = _getKernel();
+    const uint8_t* const src = static_cast< const uint8_t* >( in );
+    uint8_t* const dst = static_cast< uint8_t* >( out );
+    const ssize_t nBlocks = ssize_t(( size + _blockSize - 1 ) / _blockSize );
+
+#pragma omp parallel for if( size >= _parallelThreshold )
+    for( ssize_t i = 0; i < nBlocks; ++i )
+    {
+        const uint64_t start = uint64_t( i ) * _blockSize;
+        kernel( src + start, dst + start, LB_MIN( _blockSize, size - start ),
+                wordSize );
+    }
+}
+
+}
@@ -0,0 +1,46 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_BYTESWAP_H
+#define CO_BYTESWAP_H
+
+#include <lunchbox/types.h>
+
+namespace co
+{
+    /**
+     * @internal Copy an array of words, reversing the byte order of each word.
+     *
+     * Uses SSSE3 or AVX2 shuffles on x86 and byte reversals on ARM NEON, as
+     * supported by the CPU, for 2, 4 and 8 byte words. Other word sizes and
+     * other CPUs use a scalar loop. Large
+     * arrays are swapped in parallel blocks if OpenMP is enabled.
+     *
+     * The input and output may be the same to swap in place, but may not
+     * overlap otherwise.
+     *
+     * @param in the input words.
+     * @param out the output words.
+     * @param size the number of bytes, a multiple of wordSize.
+     * @param wordSize the size of each word in bytes.
+     */
+    void swapWords( const void* in, void* out, const uint64_t size,
+                    const size_t wordSize );
+}
+
+#endif //CO_BYTESWAP_H
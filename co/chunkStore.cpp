@@ -0,0 +1,197 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "chunkStore.h"
+
+#include "flatHash.h"
+
+#include <lunchbox/debug.h>
+
+#include <string.h>
+
+namespace co
+{
+namespace
+{
+static const uint64_t _prime1 = 0x9e3779b185ebca87ull;
+static const uint64_t _prime2 = 0xc2b2ae3d27d4eb4full;
+
+inline uint64_t _rotate( const uint64_t value, const int bits )
+{
+    return ( value << bits ) | ( value >> ( 64 - bits ));
+}
+
+/** The MurmurHash3 finalizer. */
+inline uint64_t _mix( uint64_t value )
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+/**
+ * @return a 128 bit hash of the data, using two independent lanes over the
+ * 64 bit words. Not cryptographic, identical hashes are verified by
+ * comparing the data.
+ */
+uint128_t _hash( const uint8_t* data, const uint64_t size )
+{
+    uint64_t low = size * _prime1;
+    uint64_t high = ~size;
+    uint64_t i = 0;
+    for( ; i + 8 <= size; i += 8 )
+    {
+        uint64_t word;
+        ::memcpy( &word, data + i, 8 );
+        low = _rotate( low ^ ( word * _prime2 ), 31 ) * _prime1;
+        high = _rotate( high + word, 27 ) * _prime2;
+    }
+    if( i < size )
+    {
+        uint64_t word = 0;
+        ::memcpy( &word, data + i, size - i );
+        low = _rotate( low ^ ( word * _prime2 ), 31 ) * _prime1;
+        high = _rotate( high + word, 27 ) * _prime2;
+    }
+
+    low = _mix( low + high );
+    high = _mix( high + low );
+    return uint128_t( high, low );
+}
+}
+
+class ChunkStore::Chunk
+{
+public:
+    Chunk( const uint128_t& key_, const uint8_t* data_, const uint64_t size,
+           const bool shared_ )
+        : key( key_ ), nRefs( 0 ), shared( shared_ )
+    {
+        data.append( data_, size );
+    }
+
+    bool equals( const uint8_t* data_, const uint64_t size ) const
+    {
+        return data.getSize() == size &&
+               ::memcmp( data.getData(), data_, size ) == 0;
+    }
+
+    const uint128_t key;
+    lunchbox::Bufferb data;
+    size_t nRefs;
+    const bool shared; //!< registered under its key in the store
+};
+
+namespace detail
+{
+class ChunkStore
+{
+public:
+    ChunkStore() : size( 0 ), nChunks( 0 ) {}
+
+    FlatHash< uint128_t, co::ChunkStore::Chunk* > chunks;
+    uint64_t size;
+    size_t nChunks; //!< including unshared chunks with a conflicting hash
+};
+}
+
+ChunkStore::ChunkStore()
+    : _impl( new detail::ChunkStore )
+{}
+
+ChunkStore::~ChunkStore()
+{
+    LBASSERTINFO( _impl->nChunks == 0, _impl->nChunks << " chunks in use" );
+    delete _impl;
+}
+
+void ChunkStore::insert( const void* data, const uint64_t size,
+                         Chunks& chunks )
+{
+    const uint8_t* bytes = reinterpret_cast< const uint8_t* >( data );
+    for( uint64_t i = 0; i < size; i += CHUNK_SIZE )
+    {
+        const uint8_t* ptr = bytes + i;
+        const uint64_t chunkSize = size - i < CHUNK_SIZE ? size - i :
+                                                           CHUNK_SIZE;
+        const uint128_t key = _hash( ptr, chunkSize );
+
+        Chunk*& entry = _impl->chunks[ key ];
+        Chunk* chunk = entry;
+        if( !chunk || !chunk->equals( ptr, chunkSize ))
+        {
+            // new content, or a different chunk with the same hash
+            chunk = new Chunk( key, ptr, chunkSize, !entry );
+            if( !entry )
+                entry = chunk;
+            _impl->size += chunkSize;
+            ++_impl->nChunks;
+        }
+
+        ++chunk->nRefs;
+        chunks.push_back( chunk );
+    }
+}
+
+void ChunkStore::release( Chunks& chunks )
+{
+    for( Chunks::const_iterator i = chunks.begin(); i != chunks.end(); ++i )
+    {
+        Chunk* chunk = *i;
+        LBASSERT( chunk->nRefs > 0 );
+        if( --chunk->nRefs > 0 )
+            continue;
+
+        if( chunk->shared )
+            _impl->chunks.erase( chunk->key );
+        _impl->size -= chunk->data.getSize();
+        --_impl->nChunks;
+        delete chunk;
+    }
+    chunks.clear();
+}
+
+void ChunkStore::copy( const Chunks& chunks, lunchbox::Bufferb& buffer ) const
+{
+    uint64_t size = 0;
+    for( Chunks::const_iterator i = chunks.begin(); i != chunks.end(); ++i )
+        size += (*i)->data.getSize();
+
+    buffer.setSize( 0 );
+    buffer.reserve( size );
+    for( Chunks::const_iterator i = chunks.begin(); i != chunks.end(); ++i )
+    {
+        const lunchbox::Bufferb& data = (*i)->data;
+        buffer.append( data.getData(), data.getSize( ));
+    }
+}
+
+size_t ChunkStore::getNumChunks() const
+{
+    return _impl->nChunks;
+}
+
+uint64_t ChunkStore::getSize() const
+{
+    return _impl->size;
+}
+
+}
@@ -0,0 +1,74 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_CHUNKSTORE_H
+#define CO_CHUNKSTORE_H
+
+#include <co/api.h>
+#include <co/types.h>
+
+#include <lunchbox/buffer.h>      // used in API
+#include <lunchbox/nonCopyable.h> // base class
+
+namespace co
+{
+namespace detail { class ChunkStore; }
+
+    /**
+     * @internal A content-addressed store of reference-counted data chunks.
+     *
+     * Data is split into chunks of CHUNK_SIZE bytes. Chunks with the same
+     * content are stored once and shared by all data containing them, so that
+     * a set of similar data buffers only uses memory for the chunks in which
+     * they differ. Not thread-safe.
+     */
+    class ChunkStore : public lunchbox::NonCopyable
+    {
+    public:
+        class Chunk;
+        typedef std::vector< Chunk* > Chunks;
+
+        /** The size of all but the last chunk of some data. */
+        static const uint64_t CHUNK_SIZE = 65536;
+
+        CO_API ChunkStore();
+        CO_API ~ChunkStore();
+
+        /** Store the given data, appending its chunks to the given list. */
+        CO_API void insert( const void* data, const uint64_t size,
+                            Chunks& chunks );
+
+        /** Release and clear the given chunks, freeing unused chunks. */
+        CO_API void release( Chunks& chunks );
+
+        /** Replace the buffer content with the data of the given chunks. */
+        CO_API void copy( const Chunks& chunks,
+                          lunchbox::Bufferb& buffer ) const;
+
+        /** @return the number of stored chunks. */
+        CO_API size_t getNumChunks() const;
+
+        /** @return the number of bytes of all stored chunks. */
+        CO_API uint64_t getSize() const;
+
+    private:
+        detail::ChunkStore* const _impl;
+    };
+}
+
+#endif // CO_CHUNKSTORE_H
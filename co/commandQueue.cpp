@@ -21,19 +21,318 @@
 
 #include "iCommand.h"
 #include "exception.h"
+#include "global.h"
 #include "node.h"
 
-#include <lunchbox/mtQueue.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/lock.h>
+#include <lunchbox/scopedMutex.h>
+
+#ifdef __linux__
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#  include <climits>
+#  include <ctime>
+#else
+#  include <lunchbox/condition.h>
+#endif
+#ifdef _MSC_VER
+#  include <windows.h>
+#endif
+
+#include <limits>
 
 namespace co
 {
+namespace
+{
+/** Iterations a consumer polls before blocking on an empty queue. */
+static const size_t _spinCount = 4096;
+
+template< class T > inline T _exchange( T volatile* ptr, const T value )
+{
+#ifdef _MSC_VER
+    return static_cast< T >( InterlockedExchangePointer(
+                      reinterpret_cast< void* volatile* >( ptr ), value ));
+#else
+    return __sync_lock_test_and_set( ptr, value ); // acquire barrier only
+#endif
+}
+
+inline int32_t _add( int32_t volatile* ptr, const int32_t value )
+{
+#ifdef _MSC_VER
+    return InterlockedExchangeAdd( reinterpret_cast< volatile LONG* >( ptr ),
+                                   value ) + value;
+#else
+    return __sync_add_and_fetch( ptr, value );
+#endif
+}
+
+inline void _memoryBarrier()
+{
+#ifdef _MSC_VER
+    MemoryBarrier();
+#else
+    __sync_synchronize();
+#endif
+}
+}
+
 namespace detail
 {
+/**
+ * A lock-free, intrusive multi-producer, single-consumer FIFO of commands.
+ *
+ * Producers link new nodes at the head with one atomic exchange, the consumer
+ * unlinks from the tail without synchronization. The tail always points to a
+ * stub node whose successor is the front of the queue.
+ */
+class MPSCQueue
+{
+public:
+    /** A queued command and the time after which it is promoted. */
+    struct Node
+    {
+        Node() : next( 0 ), due( 0 ) {}
+        Node( const co::ICommand& command_, const int64_t due_ )
+            : next( 0 ), command( command_ ), due( due_ ) {}
+
+        Node* volatile next;
+        co::ICommand command;
+        int64_t due;
+    };
+
+    MPSCQueue() : _head( new Node ), _tail( _head ) {}
+    ~MPSCQueue()
+    {
+        while( pop( )) {}
+        delete _tail;
+    }
+
+    /** Enqueue a command. Thread-safe and wait-free. */
+    void push( Node* node )
+    {
+        Node* prev = _exchange( &_head, node );
+        _memoryBarrier();
+        prev->next = node; // publish to consumer
+    }
+
+    /** @return the front node, or 0 if empty. Consumer only. */
+    Node* front() const
+    {
+        Node* next = _tail->next;
+        _memoryBarrier();
+        return next;
+    }
+
+    /** Dequeue the front node into command. Consumer only. */
+    bool pop( co::ICommand& command )
+    {
+        Node* next = front();
+        if( !next )
+            return false;
+
+        command = next->command;
+        next->command = co::ICommand(); // release buffer, next is new stub
+        delete _tail;
+        _tail = next;
+        return true;
+    }
+
+    bool pop()
+    {
+        co::ICommand command;
+        return pop( command );
+    }
+
+private:
+    Node* volatile _head;
+    Node* _tail;
+};
+
 class CommandQueue
 {
 public:
-    /** Thread-safe buffer queue. */
-    lunchbox::MTQueue< co::ICommand > commands;
+    CommandQueue() : frontSize( 0 ), size( 0 ), waiters( 0 ), sequence( 0 )
+    {}
+
+    int64_t getDue( const co::ICommand& command ) const
+    {
+        const uint32_t deadline = command.getDeadline();
+        return clock.getTime64() + ( deadline ? deadline :
+                   Global::getIAttribute( Global::IATTR_COMMAND_QUEUE_MAX_AGE));
+    }
+
+    /** Account for a newly linked command and wake sleeping consumers. */
+    void notifyPush()
+    {
+        _add( &size, 1 ); // full barrier, pairs with wait()
+        if( waiters == 0 )
+            return;
+
+        _add( &sequence, 1 );
+#ifdef __linux__
+        ::syscall( SYS_futex, &sequence, FUTEX_WAKE_PRIVATE, INT_MAX, 0, 0, 0);
+#else
+        condition.lock();
+        condition.broadcast();
+        condition.unlock();
+#endif
+    }
+
+    /**
+     * @return the class holding the next command to consume, or
+     *         COMMANDPRIORITY_ALL if empty. Consumer only.
+     *
+     * Overdue commands are consumed first, oldest deadline first. Otherwise
+     * the front of the highest non-empty class is consumed.
+     */
+    size_t next() const
+    {
+        const int64_t now = clock.getTime64();
+        size_t result = COMMANDPRIORITY_ALL;
+        size_t overdue = COMMANDPRIORITY_ALL;
+        int64_t overdueDue = 0;
+
+        for( size_t i = 0; i < COMMANDPRIORITY_ALL; ++i )
+        {
+            const MPSCQueue::Node* node = items[i].front();
+            if( !node )
+                continue;
+            if( result == COMMANDPRIORITY_ALL )
+                result = i;
+
+            if( node->due <= now && ( overdue == COMMANDPRIORITY_ALL ||
+                                      node->due < overdueDue ))
+            {
+                overdue = i;
+                overdueDue = node->due;
+            }
+        }
+        return overdue == COMMANDPRIORITY_ALL ? result : overdue;
+    }
+
+    /** @return true if the next command is urgent. Consumer only. */
+    bool isUrgent() const
+    {
+        if( frontSize > 0 )
+            return true;
+
+        const size_t which = next();
+        if( which == COMMANDPRIORITY_ALL )
+            return false;
+        return which == COMMANDPRIORITY_HIGH ||
+               items[ which ].front()->due <= clock.getTime64();
+    }
+
+    /** Pop the next command, if any. Consumer only. */
+    bool pop( co::ICommand& command )
+    {
+        if( popFront( command ))
+            return true;
+
+        const size_t which = next();
+        return which != COMMANDPRIORITY_ALL && pop( which, command );
+    }
+
+    /** Pop the last pushFront() command, if any. Consumer only. */
+    bool popFront( co::ICommand& command )
+    {
+        if( frontSize <= 0 ) // common case, no lock needed
+            return false;
+
+        lunchbox::ScopedWrite mutex( frontLock );
+        if( front.empty( ))
+            return false;
+
+        command = front.front();
+        front.pop_front();
+        _add( &frontSize, -1 );
+        _add( &size, -1 );
+        return true;
+    }
+
+    /** Pop the front of the given class. Consumer only. */
+    bool pop( const size_t which, co::ICommand& command )
+    {
+        if( !items[ which ].pop( command ))
+            return false;
+        _add( &size, -1 );
+        return true;
+    }
+
+    /** Wait for a non-empty queue, spinning briefly before blocking. */
+    bool wait( const uint32_t timeout )
+    {
+        for( size_t i = 0; i < _spinCount; ++i )
+            if( size > 0 )
+                return true;
+
+        const int64_t start = clock.getTime64();
+        while( true )
+        {
+            const int32_t seq = sequence;
+            _add( &waiters, 1 ); // full barrier, pairs with notifyPush()
+            if( size > 0 )
+            {
+                _add( &waiters, -1 );
+                return true;
+            }
+
+            uint32_t remaining = LB_TIMEOUT_INDEFINITE;
+            if( timeout != LB_TIMEOUT_INDEFINITE )
+            {
+                const int64_t elapsed = clock.getTime64() - start;
+                remaining = elapsed >= timeout ? 0 : timeout - elapsed;
+            }
+
+            if( remaining > 0 )
+            {
+#ifdef __linux__
+                timespec spec;
+                spec.tv_sec = remaining / 1000;
+                spec.tv_nsec = ( remaining % 1000 ) * 1000000;
+                ::syscall( SYS_futex, &sequence, FUTEX_WAIT_PRIVATE, seq,
+                           remaining == LB_TIMEOUT_INDEFINITE ? 0 : &spec,
+                           0, 0 );
+#else
+                condition.lock();
+                if( size <= 0 && sequence == seq )
+                {
+                    if( remaining == LB_TIMEOUT_INDEFINITE )
+                        condition.wait();
+                    else
+                        condition.timedWait( remaining );
+                }
+                condition.unlock();
+#endif
+            }
+            _add( &waiters, -1 );
+
+            if( size > 0 )
+                return true;
+            if( remaining == 0 )
+                return false;
+        }
+    }
+
+    lunchbox::Clock clock;
+    MPSCQueue items[ COMMANDPRIORITY_ALL ];
+    std::deque< co::ICommand > front; //!< pushFront() commands, lock held
+
+    /** Protects front, pushFront() may be called from any thread. */
+    lunchbox::Lock frontLock;
+    int32_t volatile frontSize; //!< size of front, read without the lock
+
+    int32_t volatile size; //!< may be transiently negative
+    int32_t volatile waiters; //!< number of blocked consumers
+    int32_t volatile sequence; //!< futex word, incremented on wakeup
+
+#ifndef __linux__
+    lunchbox::Condition condition;
+#endif
 };
 }
 
@@ -53,28 +352,41 @@ void CommandQueue::flush()
     if( !isEmpty( ))
         LBWARN << "Flushing non-empty command queue" << std::endl;
 
-    _impl->commands.clear();
+    ICommand command;
+    while( _impl->pop( command ))
+        ;
 }
 
 bool CommandQueue::isEmpty() const
 {
-    return _impl->commands.isEmpty();
+    return getSize() == 0;
 }
 
 size_t CommandQueue::getSize() const
 {
-    return _impl->commands.getSize();
+    const int32_t size = _impl->size;
+    return size > 0 ? size : 0;
 }
 
 void CommandQueue::push( const ICommand& command )
 {
-    _impl->commands.push( command );
+    const CommandPriority priority = command.getPriority();
+    LBASSERT( priority < COMMANDPRIORITY_ALL );
+
+    _impl->items[ priority ].push( new detail::MPSCQueue::Node( command,
+                                                  _impl->getDue( command )));
+    _impl->notifyPush();
 }
 
 void CommandQueue::pushFront( const ICommand& command )
 {
     LBASSERT( command.isValid( ));
-    _impl->commands.pushFront( command );
+    {
+        lunchbox::ScopedWrite mutex( _impl->frontLock );
+        _impl->front.push_front( command );
+        _add( &_impl->frontSize, 1 );
+    }
+    _impl->notifyPush();
 }
 
 ICommand CommandQueue::pop( const uint32_t timeout )
@@ -82,26 +394,64 @@ ICommand CommandQueue::pop( const uint32_t timeout )
     LB_TS_THREAD( _thread );
 
     ICommand command;
-    if( !_impl->commands.timedPop( timeout, command ))
-        throw Exception( Exception::TIMEOUT_COMMANDQUEUE );
+    while( true )
+    {
+        if( !_impl->wait( timeout ))
+            throw Exception( Exception::TIMEOUT_COMMANDQUEUE );
 
-    return command;
+        if( _impl->pop( command ))
+            return command;
+        // else producer still linking
+    }
 }
 
 ICommands CommandQueue::popAll( const uint32_t timeout )
 {
-    const ICommands& result = _impl->commands.timedPopRange( timeout );
+    ICommands result;
+    while( result.empty( ))
+    {
+        if( !_impl->wait( timeout ))
+            throw Exception( Exception::TIMEOUT_COMMANDQUEUE );
 
-    if( result.empty( ))
-        throw Exception( Exception::TIMEOUT_COMMANDQUEUE );
+        result.reserve( getSize( ));
+
+        // overdue commands first, then the whole most urgent class
+        ICommand command;
+        while( _impl->isUrgent() && _impl->pop( command ))
+            result.push_back( command );
+
+        const size_t which = _impl->next();
+        if( which != COMMANDPRIORITY_ALL )
+            while( _impl->pop( which, command ))
+                result.push_back( command );
+    }
     return result;
 }
 
 ICommand CommandQueue::tryPop()
 {
     LB_TS_THREAD( _thread );
+
+    ICommand command;
+    if( getSize() > 0 )
+        _impl->pop( command );
+    return command;
+}
+
+ICommand CommandQueue::tryPopUrgent( const CommandPriority priority )
+{
+    LB_TS_THREAD( _thread );
+
     ICommand command;
-    _impl->commands.tryPop( command );
+    if( getSize() == 0 )
+        return command;
+
+    if( _impl->popFront( command ))
+        return command;
+
+    for( size_t i = 0; i < size_t( priority ) && i < COMMANDPRIORITY_ALL; ++i )
+        if( _impl->pop( i, command ))
+            break;
     return command;
 }
 
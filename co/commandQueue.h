@@ -21,6 +21,7 @@
 #define CO_COMMANDQUEUE_H
 
 #include <co/api.h>
+#include <co/commands.h> // CommandPriority
 #include <co/types.h>
 #include <lunchbox/thread.h>
 
@@ -28,7 +29,14 @@ namespace co
 {
 namespace detail { class CommandQueue; }
 
-    /** A thread-safe queue for ICommand buffers. */
+    /**
+     * A thread-safe queue for ICommand buffers.
+     *
+     * Commands are consumed by their CommandPriority, as set during
+     * Dispatcher::registerCommand(), and in FIFO order within one priority
+     * class. Commands waiting longer than their deadline are consumed first.
+     * Any thread may push commands, but only one thread consumes them.
+     */
     class CommandQueue : public lunchbox::NonCopyable
     {
     public:
@@ -63,6 +71,9 @@ namespace detail { class CommandQueue; }
         /**
          * Pop all, but at least one command from the queue.
          *
+         * Returns all overdue commands and all commands of the most urgent
+         * non-empty priority class, in the order they have to be consumed.
+         *
          * @param timeout the time in ms to wait for the operation.
          * @return one or more commands in the queue.
          * @throw Exception on timeout.
@@ -79,6 +90,18 @@ namespace detail { class CommandQueue; }
          */
         CO_API virtual ICommand tryPop();
 
+        /**
+         * Try to pop a command of a higher priority class than the given one.
+         *
+         * Used to run urgent commands in between a batch of less urgent
+         * commands. Commands are not promoted by their deadline.
+         *
+         * @param priority the priority class to preempt.
+         * @return the next more urgent command, or an invalid command.
+         * @version 1.1
+         */
+        CO_API ICommand tryPopUrgent( const CommandPriority priority );
+
         /**
          * @return <code>true</code> if the command queue is empty,
          *         <code>false</code> if not.
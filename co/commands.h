@@ -41,6 +41,20 @@ namespace co
         CMD_INVALID = 0xFFFFFFFFu //!< @internal
     };
 
+    /**
+     * Scheduling class of a command queued to a CommandQueue.
+     *
+     * Commands are consumed in order of their priority, and in FIFO order
+     * within one priority class.
+     */
+    enum CommandPriority
+    {
+        COMMANDPRIORITY_HIGH,   //!< Latency-critical control commands
+        COMMANDPRIORITY_NORMAL, //!< Default for all commands
+        COMMANDPRIORITY_LOW,    //!< Bulk data transfers
+        COMMANDPRIORITY_ALL     //!< @internal number of priority classes
+    };
+
     /** @internal Minimal packet size sent by DataOStream / read by LocalNode */
     static const size_t COMMAND_MINSIZE = 256;
 
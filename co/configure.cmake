@@ -36,6 +36,10 @@ if(UDT_FOUND)
   list(APPEND COLLAGE_DEFINES CO_USE_UDT)
 endif(UDT_FOUND)
 
+if(URING_FOUND)
+  list(APPEND COLLAGE_DEFINES CO_USE_URING)
+endif()
+
 if(LUNCHBOX_USE_DNSSD)
   list(APPEND COLLAGE_DEFINES CO_USE_SERVUS)
 endif()
@@ -44,6 +48,10 @@ if(COLLAGE_AGGRESSIVE_CACHING)
   list(APPEND COLLAGE_DEFINES CO_AGGRESSIVE_CACHING)
 endif()
 
+if(COLLAGE_RSP_SIMULATE_LOSS)
+  list(APPEND COLLAGE_DEFINES CO_RSP_SIMULATE_LOSS)
+endif()
+
 if(COLLAGE_BIGENDIAN)
   list(APPEND COLLAGE_DEFINES COLLAGE_BIGENDIAN)
 endif()
@@ -23,8 +23,12 @@
 #include "buffer.h"
 #include "connectionDescription.h"
 #include "connectionListener.h"
+#include "global.h"
 #include "log.h"
+#include "nodeCommand.h"
+#include "oCommand.h"
 #include "pipeConnection.h"
+#include "relayConnection.h"
 #include "socketConnection.h"
 #include "rspConnection.h"
 
@@ -44,8 +48,15 @@
 #  include "udtConnection.h"
 #endif
 
+#include <lunchbox/atomic.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/condition.h>
 #include <lunchbox/scopedMutex.h>
+#include <lunchbox/sleep.h>
 #include <lunchbox/stdExt.h>
+#include <lunchbox/thread.h>
+
+#include <deque>
 
 //#define STATISTICS
 #ifdef STATISTICS
@@ -75,6 +86,164 @@ namespace co
 {
 namespace detail
 {
+/** Writes the asynchronously sent data of one connection. */
+class SendThread : public lunchbox::Thread
+{
+public:
+    SendThread( co::Connection& connection, const uint64_t size )
+        : maxSize( size )
+        , _connection( connection )
+        , _size( 0 )
+        , _failed( false )
+        , _stopped( false )
+    {}
+
+    ~SendThread()
+    {
+        LBASSERT( _stopped );
+        _queue.insert( _queue.end(), _free.begin(), _free.end( ));
+        _queue.insert( _queue.end(), _retained.begin(), _retained.end( ));
+        for( std::deque< lunchbox::Bufferb* >::const_iterator i =
+                 _queue.begin(); i != _queue.end(); ++i )
+        {
+            delete *i;
+        }
+    }
+
+    /** Queue a copy of the data, blocks while the queue is full. */
+    bool push( const void* data, const uint64_t bytes )
+    {
+        _condition.lock();
+        while( _size > 0 && _size + bytes > maxSize && !_failed && !_stopped )
+            _condition.wait();
+        if( _failed || _stopped )
+        {
+            _condition.unlock();
+            return false;
+        }
+
+        // coalesce small sends into the last queued buffer
+        lunchbox::Bufferb* buffer = 0;
+        if( !_queue.empty() && _queue.back()->getSize() + bytes <= _coalesce )
+            buffer = _queue.back();
+        else
+        {
+            if( _free.empty( ))
+                buffer = new lunchbox::Bufferb;
+            else
+            {
+                buffer = _free.back();
+                _free.pop_back();
+            }
+            _queue.push_back( buffer );
+        }
+
+        buffer->append( static_cast< const uint8_t* >( data ), bytes );
+        _size += bytes;
+        _condition.signal();
+        _condition.unlock();
+        return true;
+    }
+
+    /** Wait until all queued data is written. */
+    bool finish()
+    {
+        _condition.lock();
+        while( _size > 0 && !_failed && !_stopped )
+            _condition.wait();
+        const bool ok = !_failed;
+        _condition.unlock();
+        return ok;
+    }
+
+    /** Stop writing, discarding all queued data. */
+    void stop()
+    {
+        _condition.lock();
+        _stopped = true;
+        _condition.broadcast();
+        _condition.unlock();
+    }
+
+    void run() override
+    {
+        setName( "Send" );
+        while( true )
+        {
+            _condition.lock();
+            // recycle written buffers while idle, or when too many are held
+            if( !_retained.empty() &&
+                ( _queue.empty() || _retained.size() >= _maxFree ))
+            {
+                _condition.unlock();
+                const bool ok = _connection.releaseWriteBuffers();
+                _condition.lock();
+                _recycle();
+                if( !ok )
+                {
+                    _failed = true;
+                    _condition.broadcast();
+                }
+            }
+            while( _queue.empty() && !_stopped )
+                _condition.wait();
+            if( _stopped )
+            {
+                _condition.unlock();
+                return;
+            }
+
+            lunchbox::Bufferb* buffer = _queue.front();
+            _queue.pop_front();
+            _condition.unlock();
+
+            const bool ok = _connection._write( buffer->getData(),
+                                                buffer->getSize(),
+                                                true /* retained */ );
+
+            _condition.lock();
+            _size -= buffer->getSize();
+            _retained.push_back( buffer );
+            if( !ok )
+                _failed = true;
+            _condition.broadcast();
+            _condition.unlock();
+        }
+    }
+
+    const uint64_t maxSize;
+
+private:
+    static const uint64_t _coalesce = LB_64KB;
+    static const size_t _maxFree = 4;
+
+    /** Move the released written buffers to the free list, lock held. */
+    void _recycle()
+    {
+        for( std::vector< lunchbox::Bufferb* >::const_iterator i =
+                 _retained.begin(); i != _retained.end(); ++i )
+        {
+            if( _free.size() < _maxFree )
+            {
+                (*i)->setSize( 0 );
+                _free.push_back( *i );
+            }
+            else
+                delete *i;
+        }
+        _retained.clear();
+    }
+
+    co::Connection& _connection;
+    lunchbox::Condition _condition;
+    std::deque< lunchbox::Bufferb* > _queue;
+    std::vector< lunchbox::Bufferb* > _free;
+    std::vector< lunchbox::Bufferb* > _retained; //!< written, not released
+    uint64_t _size;
+    bool _failed;
+    bool _stopped;
+};
+
 class Connection
 {
 public:
@@ -86,14 +255,27 @@ public:
 
     BufferPtr buffer; //!< Current async read buffer
     uint64_t bytes; //!< Current read request size
+    bool partial; //!< Current read request completes on any data
 
     /** The listeners on state changes */
     ConnectionListeners listeners;
 
+    /** Pending small commands, framed as one CMD_NODE_BATCH command. */
+    lunchbox::Bufferb batch;
+    lunchbox::a_uint64_t batchSize; //!< max batch size, 0 if disabled
+    int64_t batchTime; //!< time of the first batched command
+    lunchbox::Clock clock;
+
+    SendThread* sendThread; //!< asynchronous send queue, 0 if synchronous
+
     Connection()
             : state( co::Connection::STATE_CLOSED )
             , description( new ConnectionDescription )
             , bytes( 0 )
+            , partial( false )
+            , batchSize( 0 )
+            , batchTime( 0 )
+            , sendThread( 0 )
     {
         description->type = CONNECTIONTYPE_NONE;
     }
@@ -106,6 +288,24 @@ public:
 
         LBASSERTINFO( !buffer,
                       "Pending read operation during connection destruction" );
+        exitSendThread();
+    }
+
+    void stopSendThread()
+    {
+        if( !sendThread )
+            return;
+        sendThread->stop();
+        if( !sendThread->isCurrent( )) // failed writes close from within
+            sendThread->join();
+    }
+
+    void exitSendThread()
+    {
+        stopSendThread();
+        LBASSERT( !sendThread || !sendThread->isCurrent( ));
+        delete sendThread;
+        sendThread = 0;
     }
 
     void fireStateChanged( co::Connection* connection )
@@ -117,6 +317,286 @@ public:
         }
     }
 };
+
+/**
+ * Flushes aged send batches of all batching connections. Holds a reference to
+ * each registered connection, so that a connection can't be destroyed during
+ * its flush. Sleeps until a connection starts a new batch.
+ */
+class BatchFlusher : public lunchbox::Thread
+{
+public:
+    BatchFlusher() : _pending( false ), _started( false ), _running( false ) {}
+
+    void add( co::Connection* connection )
+    {
+        _condition.lock();
+        if( connection->isClosed() || _find( connection ) != _connections.end())
+        {
+            _condition.unlock();
+            return;
+        }
+
+        _connections.push_back( connection );
+        if( !_running )
+        {
+            if( _started )
+                join();
+            _started = true;
+            _running = true;
+            start();
+        }
+        _condition.unlock();
+    }
+
+    void remove( co::Connection* connection )
+    {
+        ConnectionPtr removed; // released unlocked, may delete the connection
+        _condition.lock();
+        const ConnectionsIter i = _find( connection );
+        if( i != _connections.end( ))
+        {
+            removed = *i;
+            _connections.erase( i );
+            if( _connections.empty( ))
+                _condition.signal(); // let the thread exit
+        }
+        _condition.unlock();
+    }
+
+    /** Wake up the thread to flush a new batch after the batch delay. */
+    void notify()
+    {
+        _condition.lock();
+        _pending = true;
+        _condition.signal();
+        _condition.unlock();
+    }
+
+    /** Release all connections and stop the thread. */
+    void exit()
+    {
+        Connections connections; // released unlocked
+        _condition.lock();
+        connections.swap( _connections );
+        const bool started = _started;
+        _started = false;
+        _condition.signal();
+        _condition.unlock();
+
+        if( started )
+            join();
+    }
+
+    void run() override
+    {
+        setName( "BatchFlush" );
+        Connections connections;
+        while( true )
+        {
+            _condition.lock();
+            while( !_pending && !_connections.empty( ))
+                _condition.wait();
+            if( _connections.empty( ))
+            {
+                _running = false;
+                _condition.unlock();
+                return;
+            }
+            _pending = false; // batches started from now on notify again
+            _condition.unlock();
+
+            const int64_t delay =
+                Global::getIAttribute( Global::IATTR_NODE_SEND_BATCH_DELAY );
+            lunchbox::sleep( uint32_t( LB_MAX( delay, 1 )));
+
+            _condition.lock();
+            connections = _connections;
+            _condition.unlock();
+
+            // Flush unlocked, a failed send closes and removes the connection.
+            // The references keep removed connections valid until cleared.
+            for( ConnectionsCIter i = connections.begin();
+                 i != connections.end(); ++i )
+            {
+                ConnectionPtr connection = *i;
+                connection->flushSendBatch( delay );
+            }
+            connections.clear();
+        }
+    }
+
+private:
+    lunchbox::Condition _condition;
+    Connections _connections;
+    bool _pending; //!< a batch was started since the last wakeup
+    bool _started;
+    bool _running;
+
+    ConnectionsIter _find( const co::Connection* connection )
+    {
+        for( ConnectionsIter i = _connections.begin();
+             i != _connections.end(); ++i )
+        {
+            // compare pointers, a connection in its destructor has no refs
+            if( i->get() == connection )
+                return i;
+        }
+        return _connections.end();
+    }
+};
+
+static BatchFlusher _batchFlusher;
+
+/** Sends one buffer to many connections using a pool of helper threads. */
+class SendPool
+{
+public:
+    SendPool() : _stopped( false ) {}
+
+    /** Stop and delete all workers, restarted on demand by send(). */
+    void exit()
+    {
+        std::vector< Worker* > workers;
+        _condition.lock();
+        _stopped = true;
+        _condition.broadcast();
+        workers.swap( _workers );
+        _condition.unlock();
+
+        for( std::vector< Worker* >::const_iterator i = workers.begin();
+             i != workers.end(); ++i )
+        {
+            if( (*i)->started )
+                (*i)->join();
+            delete *i;
+        }
+
+        _condition.lock();
+        _stopped = false;
+        _condition.unlock();
+    }
+
+    bool send( const Connections& connections, const void* buffer,
+               const uint64_t bytes, const bool isLocked, const size_t nThreads )
+    {
+        Job job( connections, buffer, bytes, isLocked );
+
+        _condition.lock();
+        _startWorkers( LB_MIN( nThreads, connections.size() - 1 ));
+        _jobs.push_back( &job );
+        _condition.broadcast();
+
+        // help out, then wait for the connections taken by the workers
+        while( job.next < connections.size( ))
+            _process( job );
+        while( job.done < connections.size( ))
+            _condition.wait();
+        _condition.unlock();
+        return job.ok;
+    }
+
+private:
+    struct Job
+    {
+        Job( const Connections& connections_, const void* buffer_,
+             const uint64_t bytes_, const bool isLocked_ )
+            : connections( connections_ ), buffer( buffer_ ), bytes( bytes_ )
+            , isLocked( isLocked_ ), next( 0 ), done( 0 ), ok( true ) {}
+
+        const Connections& connections;
+        const void* const buffer;
+        const uint64_t bytes;
+        const bool isLocked;
+        size_t next; //!< next connection to send to
+        size_t done; //!< number of finished sends
+        bool ok;
+    };
+
+    class Worker : public lunchbox::Thread
+    {
+    public:
+        explicit Worker( SendPool& pool )
+            : started( false ), running( false ), _pool( pool ) {}
+
+        void run() override
+        {
+            setName( "SendPool" );
+            _pool._work( *this );
+        }
+
+        bool started;
+        bool running;
+
+    private:
+        SendPool& _pool;
+    };
+
+    lunchbox::Condition _condition;
+    std::deque< Job* > _jobs; //!< jobs with connections left to send to
+    std::vector< Worker* > _workers;
+    bool _stopped;
+
+    /** Start idle workers, condition locked. */
+    void _startWorkers( const size_t nThreads )
+    {
+        while( _workers.size() < nThreads )
+            _workers.push_back( new Worker( *this ));
+
+        for( size_t i = 0; i < nThreads; ++i )
+        {
+            Worker* worker = _workers[i];
+            if( worker->running )
+                continue;
+            if( worker->started )
+                worker->join();
+            worker->started = true;
+            worker->running = worker->start();
+        }
+    }
+
+    /** Send to the next connection of the job, condition locked. */
+    void _process( Job& job )
+    {
+        LBASSERT( job.next < job.connections.size( ));
+        const size_t index = job.next++;
+        if( job.next == job.connections.size( ))
+            _jobs.erase( std::find( _jobs.begin(), _jobs.end(), &job ));
+        _condition.unlock();
+
+        ConnectionPtr connection = job.connections[ index ];
+        const bool ok = connection->send( job.buffer, job.bytes,
+                                          job.isLocked );
+
+        _condition.lock();
+        if( !ok )
+            job.ok = false;
+        if( ++job.done == job.connections.size( ))
+            _condition.broadcast();
+    }
+
+    void _work( Worker& worker )
+    {
+        _condition.lock();
+        while( true )
+        {
+            // exit when idle, restarted on demand by _startWorkers()
+            while( _jobs.empty( ))
+            {
+                if( _stopped ||
+                    ( !_condition.timedWait( 1000 ) && _jobs.empty( )))
+                {
+                    worker.running = false;
+                    _condition.unlock();
+                    return;
+                }
+            }
+            _process( *_jobs.front( ));
+        }
+    }
+};
+
+static SendPool _sendPool;
 }
 
 Connection::Connection()
@@ -170,6 +650,9 @@ ConnectionPtr Connection::create( ConnectionDescriptionPtr description )
         case CONNECTIONTYPE_RSP:
             connection = new RSPConnection;
             break;
+        case CONNECTIONTYPE_RELAY:
+            connection = new RelayConnection;
+            break;
 
 #ifdef CO_USE_OFED
         case CONNECTIONTYPE_RDMA:
@@ -214,6 +697,11 @@ void Connection::_setState( const State state )
     if( _impl->state == state )
         return;
     _impl->state = state;
+    if( state == STATE_CLOSING || state == STATE_CLOSED )
+    {
+        detail::_batchFlusher.remove( this );
+        _impl->stopSendThread(); // a closed connection discards queued data
+    }
     _impl->fireStateChanged( this );
 }
 
@@ -254,10 +742,22 @@ void Connection::recvNB( BufferPtr buffer, const uint64_t bytes )
 
     _impl->buffer = buffer;
     _impl->bytes = bytes;
+    _impl->partial = false;
     buffer->reserve( buffer->getSize() + bytes );
     readNB( buffer->getData() + buffer->getSize(), bytes );
 }
 
+void Connection::recvAvailableNB( BufferPtr buffer, const uint64_t bytes )
+{
+    recvNB( buffer, bytes );
+    _impl->partial = true;
+}
+
+bool Connection::isRecvAvailable() const
+{
+    return _impl->partial;
+}
+
 bool Connection::recvSync( BufferPtr& outBuffer, const bool block )
 {
     LBASSERT( _impl->buffer );
@@ -265,8 +765,10 @@ bool Connection::recvSync( BufferPtr& outBuffer, const bool block )
     // reset async IO data
     outBuffer = _impl->buffer;
     const uint64_t bytes = _impl->bytes;
+    const bool partial = _impl->partial;
     _impl->buffer = 0;
     _impl->bytes = 0;
+    _impl->partial = false;
 
     if( _impl->state != STATE_CONNECTED || !outBuffer || bytes == 0 )
         return false;
@@ -287,6 +789,7 @@ bool Connection::recvSync( BufferPtr& outBuffer, const bool block )
     {
         _impl->buffer = outBuffer;
         _impl->bytes = bytes;
+        _impl->partial = partial;
         outBuffer = 0;
         return true;
     }
@@ -313,6 +816,11 @@ bool Connection::recvSync( BufferPtr& outBuffer, const bool block )
                 return false;
             LBVERB << "Zero bytes read" << std::endl;
         }
+        if( partial && got > 0 ) // take what we got
+        {
+            outBuffer->resize( outBuffer->getSize() + got );
+            return true;
+        }
         if( bytesLeft > static_cast< uint64_t >( got )) // partial read
         {
             ptr += got;
@@ -360,6 +868,7 @@ BufferPtr Connection::resetRecvData()
     BufferPtr buffer = _impl->buffer;
     _impl->buffer = 0;
     _impl->bytes = 0;
+    _impl->partial = false;
     return buffer;
 }
 
@@ -374,14 +883,20 @@ bool Connection::send( const void* buffer, const uint64_t bytes,
     if( bytes == 0 )
         return true;
 
-    const uint8_t* ptr = static_cast< const uint8_t* >( buffer );
-
     // possible OPT: We need to lock here to guarantee an atomic transmission of
     // the buffer. Possible improvements are:
     // 1) Disassemble buffer into 'small enough' pieces and use a header to
     //    reassemble correctly on the other side (aka reliable UDP)
-    // 2) Introduce a send thread with a thread-safe task queue
+    // 2) Use asynchronous sends, see setSendQueueSize()
     lunchbox::ScopedMutex<> mutex( isLocked ? 0 : &_impl->sendLock );
+    if( !_impl->batch.isEmpty() && !_sendBatch( )) // keep command order
+        return false;
+    return _send( buffer, bytes );
+}
+
+bool Connection::_send( const void* buffer, const uint64_t bytes )
+{
+    const uint8_t* ptr = static_cast< const uint8_t* >( buffer );
 
 #ifndef NDEBUG
     if( bytes <= 1024 && ( lunchbox::Log::topics & LOG_PACKETS ))
@@ -402,12 +917,23 @@ bool Connection::send( const void* buffer, const uint64_t bytes,
     }
 #endif
 
+    if( _impl->sendThread )
+        return _impl->sendThread->push( buffer, bytes );
+    return _write( buffer, bytes );
+}
+
+bool Connection::_write( const void* buffer, const uint64_t bytes,
+                         const bool retained )
+{
+    const uint8_t* ptr = static_cast< const uint8_t* >( buffer );
     uint64_t bytesLeft = bytes;
     while( bytesLeft )
     {
         try
         {
-            const int64_t wrote = this->write( ptr, bytesLeft );
+            const int64_t wrote = retained ?
+                                      this->writeRetained( ptr, bytesLeft ) :
+                                      this->write( ptr, bytesLeft );
             if( wrote == -1 ) // error
             {
                 LBERROR << "Error during write after " << bytes - bytesLeft
@@ -433,6 +959,148 @@ bool Connection::send( const void* buffer, const uint64_t bytes,
     return true;
 }
 
+bool Connection::send( const Connections& connections, const void* buffer,
+                       const uint64_t bytes, const bool isLocked )
+{
+    const size_t nThreads =
+        Global::getIAttribute( Global::IATTR_SEND_POOL_SIZE );
+    if( connections.size() > 1 && nThreads > 0 && bytes >= LB_16KB )
+        return detail::_sendPool.send( connections, buffer, bytes, isLocked,
+                                       nThreads );
+
+    bool ok = true;
+    for( ConnectionsCIter i = connections.begin(); i != connections.end(); ++i )
+    {
+        ConnectionPtr connection = *i;
+        if( !connection->send( buffer, bytes, isLocked ))
+            ok = false;
+    }
+    return ok;
+}
+
+void Connection::setSendQueueSize( const uint64_t size )
+{
+    lunchbox::ScopedMutex<> mutex( _impl->sendLock );
+    detail::SendThread* thread = _impl->sendThread;
+    if( thread )
+    {
+        if( thread->maxSize == size )
+            return;
+        thread->finish();
+        _impl->exitSendThread();
+    }
+
+    if( size == 0 )
+        return;
+
+    _impl->sendThread = new detail::SendThread( *this, size );
+    if( !_impl->sendThread->start( ))
+    {
+        LBWARN << "Can't start send thread, using synchronous sends"
+               << std::endl;
+        _impl->exitSendThread();
+    }
+}
+
+uint64_t Connection::getSendQueueSize() const
+{
+    return _impl->sendThread ? _impl->sendThread->maxSize : 0;
+}
+
+void Connection::finish()
+{
+    lunchbox::ScopedMutex<> mutex( _impl->sendLock );
+    if( !_impl->batch.isEmpty( ))
+        _sendBatch();
+    if( _impl->sendThread )
+        _impl->sendThread->finish();
+}
+
+void Connection::setSendBatchSize( const uint64_t size )
+{
+    {
+        lunchbox::ScopedMutex<> mutex( _impl->sendLock );
+        if( !_impl->batch.isEmpty() && !_sendBatch( ))
+            LBWARN << "Pending send batch lost, connection failed" << std::endl;
+        _impl->batchSize = size;
+    }
+
+    if( size > 0 )
+        detail::_batchFlusher.add( this );
+    else
+        detail::_batchFlusher.remove( this );
+}
+
+bool Connection::sendBatched( const void* command, const uint64_t bytes )
+{
+    const uint64_t headerSize = OCommand::getSize();
+    if( bytes + headerSize > _impl->batchSize )
+        return false;
+
+    lunchbox::ScopedMutex<> mutex( _impl->sendLock );
+    const uint64_t batchSize = _impl->batchSize; // re-read locked
+    if( bytes + headerSize > batchSize )
+        return false;
+
+    // a failed send closes the connection, the caller's send reports it
+    if( _impl->batch.getSize() + bytes > batchSize && !_sendBatch( ))
+        return false;
+    if( _impl->batch.isEmpty( ))
+    {
+        // header: size, type, command
+        const uint32_t type = COMMANDTYPE_NODE;
+        const uint32_t cmd = CMD_NODE_BATCH;
+        _impl->batch.reserve( batchSize );
+        _impl->batch.resize( sizeof( uint64_t ));
+        _impl->batch.append( reinterpret_cast< const uint8_t* >( &type ),
+                             sizeof( type ));
+        _impl->batch.append( reinterpret_cast< const uint8_t* >( &cmd ),
+                             sizeof( cmd ));
+        _impl->batchTime = _impl->clock.getTime64();
+        detail::_batchFlusher.notify();
+    }
+
+    _impl->batch.append( static_cast< const uint8_t* >( command ), bytes );
+    if( _impl->batch.getSize() + headerSize > batchSize )
+        return _sendBatch();
+    return true;
+}
+
+void Connection::flushSendBatch( const int64_t age )
+{
+    lunchbox::ScopedMutex<> mutex( _impl->sendLock );
+    if( _impl->state == STATE_CONNECTED && !_impl->batch.isEmpty() &&
+        _impl->clock.getTime64() - _impl->batchTime >= age )
+    {
+        _sendBatch();
+    }
+}
+
+bool Connection::_sendBatch()
+{
+    lunchbox::Bufferb& batch = _impl->batch;
+    const uint64_t size = batch.getSize();
+    LBASSERT( size > OCommand::getSize( ));
+
+    *reinterpret_cast< uint64_t* >( batch.getData( )) = size;
+    if( size < COMMAND_MINSIZE ) // Fill send to minimal size
+        batch.resize( COMMAND_MINSIZE );
+
+    const bool ok = _send( batch.getData(), batch.getSize( ));
+    batch.setSize( 0 );
+    return ok;
+}
+
+void Connection::exitBatchFlusher()
+{
+    detail::_batchFlusher.exit();
+}
+
+void Connection::exitSendPool()
+{
+    detail::_sendPool.exit();
+}
+
 bool Connection::isMulticast() const
 {
     return getDescription()->type >= CONNECTIONTYPE_MULTICAST;
@@ -38,7 +38,7 @@
 
 namespace co
 {
-namespace detail { class Connection; }
+namespace detail { class Connection; class SendThread; }
 
     /**
      * An interface definition for communication between hosts.
@@ -186,6 +186,23 @@ namespace detail { class Connection; }
          */
         CO_API void recvNB( BufferPtr buffer, const uint64_t bytes );
 
+        /**
+         * Start a read operation for all available data on the connection.
+         *
+         * Like recvNB(), but the following recvSync() returns as soon as at
+         * least one byte and at most the given number of bytes have been
+         * received, without blocking for the remaining data.
+         *
+         * @param buffer the buffer receiving the data.
+         * @param bytes the maximum number of bytes to read.
+         * @sa recvSync()
+         * @version 1.1
+         */
+        CO_API void recvAvailableNB( BufferPtr buffer, const uint64_t bytes );
+
+        /** @internal @return true if the pending read is a partial read. */
+        CO_API bool isRecvAvailable() const;
+
         /**
          * Finish reading data from the connection.
          *
@@ -226,14 +243,87 @@ namespace detail { class Connection; }
         CO_API bool send( const void* buffer, const uint64_t bytes,
                           const bool isLocked = false );
 
+        /**
+         * Send data to many connections in parallel.
+         *
+         * Larger sends to multiple connections use up to
+         * Global::IATTR_SEND_POOL_SIZE helper threads, so that the send
+         * time approaches the one of the slowest connection instead of the
+         * sum of all connections. Other sends are performed sequentially.
+         *
+         * @param connections the connections to send the data to.
+         * @param buffer the buffer containing the message.
+         * @param bytes the number of bytes to send.
+         * @param isLocked true if all connections are locked externally.
+         * @return true if the data was sent to all connections.
+         * @version 1.1
+         */
+        CO_API static bool send( const Connections& connections,
+                                 const void* buffer, const uint64_t bytes,
+                                 const bool isLocked = false );
+
         /** Lock the connection, no other thread can send data. @version 1.0 */
         CO_API void lockSend() const;
 
         /** Unlock the connection. @version 1.0 */
         CO_API void unlockSend() const;
 
-        /** @internal Finish all pending send operations. */
-        virtual void finish() {}
+        /**
+         * @internal Finish all pending send operations.
+         *
+         * Blocks until all data queued by asynchronous sends is written.
+         */
+        CO_API virtual void finish();
+
+        /**
+         * Enable asynchronous sends.
+         *
+         * With a non-zero queue size, send() copies the data into a bounded
+         * queue and returns immediately. The queue is written by a dedicated
+         * send thread of this connection. If more than the given number of
+         * bytes are queued, send() blocks until the send thread has caught
+         * up. A failed write closes the connection, and all subsequent sends
+         * fail. Closing the connection discards queued data, use finish() for
+         * an orderly shutdown.
+         *
+         * @param size the maximum number of queued bytes, 0 for synchronous
+         *             sends.
+         * @sa finish()
+         * @version 1.1
+         */
+        CO_API void setSendQueueSize( const uint64_t size );
+
+        /** @return the maximum number of queued bytes. @version 1.1 */
+        CO_API uint64_t getSendQueueSize() const;
+
+        /**
+         * @internal Enable the coalescing of small commands into batches.
+         *
+         * Commands passed to sendBatched() are accumulated and sent as one
+         * CMD_NODE_BATCH command when the batch is full, when it is older than
+         * Global::IATTR_NODE_SEND_BATCH_DELAY, on flushSendBatch() or before
+         * any other data is sent on this connection.
+         *
+         * @param size the maximum batch size in bytes, 0 disables batching.
+         */
+        CO_API void setSendBatchSize( const uint64_t size );
+
+        /**
+         * @internal Add a complete command to the send batch.
+         * @return false if the command was not batched or sending the batch
+         *         failed. The command has to be sent then, which reports the
+         *         failure.
+         */
+        bool sendBatched( const void* command, const uint64_t bytes );
+
+        /** @internal Send the pending batch if it is older than age ms. */
+        CO_API void flushSendBatch( const int64_t age = 0 );
+
+        /** @internal Stop the thread flushing the batches, used by exit(). */
+        static void exitBatchFlusher();
+
+        /** @internal Stop the threads of the send pool, used by exit(). */
+        static void exitSendPool();
         //@}
 
         /**
@@ -307,6 +397,25 @@ namespace detail { class Connection; }
          * @return the number of bytes written, or -1 upon error.
          */
         virtual int64_t write( const void* buffer, const uint64_t bytes ) = 0;
+
+        /**
+         * @internal Write data from a buffer which is kept unmodified until
+         * releaseWriteBuffers() returns.
+         *
+         * Used by the asynchronous send queue, which owns its buffers. Allows
+         * implementations to send without copying the data into the kernel.
+         */
+        virtual int64_t writeRetained( const void* buffer,
+                                       const uint64_t bytes )
+            { return write( buffer, bytes ); }
+
+        /**
+         * @internal Wait until no buffer given to writeRetained() is used.
+         *
+         * Called by the send thread, implementations must not throw.
+         * @return false on error or timeout.
+         */
+        virtual bool releaseWriteBuffers() { return true; }
         //@}
 
         /** @internal @name State Changes */
@@ -322,6 +431,14 @@ namespace detail { class Connection; }
 
     private:
         detail::Connection* const _impl;
+
+        friend class detail::SendThread;
+
+        bool _send( const void* buffer, const uint64_t bytes ); //!< unlocked
+        /** Write all data, through writeRetained() if retained is set. */
+        bool _write( const void* buffer, const uint64_t bytes,
+                     const bool retained = false );
+        bool _sendBatch(); //!< send pending batch, send lock held
     };
 
     CO_API std::ostream& operator << ( std::ostream&, const Connection& );
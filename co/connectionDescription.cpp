@@ -44,6 +44,8 @@ static ConnectionType _getConnectionType( const std::string& string )
         return CONNECTIONTYPE_IB;
     if( string == "RSP" )
         return CONNECTIONTYPE_RSP;
+    if( string == "RELAY" )
+        return CONNECTIONTYPE_RELAY;
     if( string == "RDMA" )
         return CONNECTIONTYPE_RDMA;
     if( string == "UDT" )
@@ -52,6 +54,20 @@ static ConnectionType _getConnectionType( const std::string& string )
     LBWARN << "Unknown connection type: " << string;
     return CONNECTIONTYPE_NONE;
 }
+
+static bool _getSocketProfile( const std::string& string,
+                               SocketProfile& profile )
+{
+    if( string == "DEFAULT" )
+        profile = SOCKETPROFILE_DEFAULT;
+    else if( string == "LATENCY" )
+        profile = SOCKETPROFILE_LATENCY;
+    else if( string == "THROUGHPUT" )
+        profile = SOCKETPROFILE_THROUGHPUT;
+    else
+        return false;
+    return true;
+}
 }
 
 ConnectionDescription::ConnectionDescription( std::string& data )
@@ -59,6 +75,8 @@ ConnectionDescription::ConnectionDescription( std::string& data )
         , bandwidth( 0 )
         , port( 0 )
         , filename( "default" )
+        , profile( SOCKETPROFILE_DEFAULT )
+        , cpu( -1 )
 {
     fromString( data );
     LBASSERTINFO( data.empty(), data );
@@ -76,6 +94,10 @@ void ConnectionDescription::serialize( std::ostream& os ) const
     os << type << SEPARATOR << bandwidth << SEPARATOR << hostname  << SEPARATOR
        << interfacename << SEPARATOR << port << SEPARATOR << filename
        << SEPARATOR;
+
+    // optional, omitted for peers not knowing about tuning
+    if( profile != SOCKETPROFILE_DEFAULT || cpu >= 0 )
+        os << int( profile ) << SEPARATOR << cpu << SEPARATOR;
 }
 
 bool ConnectionDescription::fromString( std::string& data )
@@ -105,6 +127,13 @@ bool ConnectionDescription::fromString( std::string& data )
 
                 if( !token.empty() && isdigit( token[0] )) // port
                     port = atoi( token.c_str( ));
+                else if( _getSocketProfile( token, profile ))
+                    continue;
+                else if( token.size() > 3 && token.compare( 0, 3, "CPU" ) == 0
+                         && isdigit( token[3] ))
+                {
+                    cpu = atoi( token.c_str() + 3 );
+                }
                 else
                 {
                     type = _getConnectionType( token );
@@ -166,6 +195,26 @@ bool ConnectionDescription::fromString( std::string& data )
 
         filename = data.substr( 0, nextPos );
         data = data.substr( nextPos + 1 );
+
+        // optional tuning, the next description starts with its type name
+        if( data.empty() || !isdigit( data[0] ))
+            return true;
+
+        nextPos = data.find( SEPARATOR );
+        if( nextPos == std::string::npos )
+            goto error;
+
+        const std::string profileStr = data.substr( 0, nextPos );
+        data = data.substr( nextPos + 1 );
+        profile = SocketProfile( atoi( profileStr.c_str( )));
+
+        nextPos = data.find( SEPARATOR );
+        if( nextPos == std::string::npos )
+            goto error;
+
+        const std::string cpuStr = data.substr( 0, nextPos );
+        data = data.substr( nextPos + 1 );
+        cpu = atoi( cpuStr.c_str( ));
     }
     return true;
 
@@ -216,7 +265,8 @@ bool ConnectionDescription::operator == ( const ConnectionDescription& rhs )
 {
     return type == rhs.type && bandwidth == rhs.bandwidth &&
            port == rhs.port && hostname == rhs.hostname &&
-           interfacename == rhs.interfacename && filename == rhs.filename;
+           interfacename == rhs.interfacename && filename == rhs.filename &&
+           profile == rhs.profile && cpu == rhs.cpu;
 }
 
 std::string serialize( const ConnectionDescriptions& descriptions )
@@ -297,6 +347,12 @@ std::ostream& operator << ( std::ostream& os,
     if( desc.bandwidth != 0 )
         os << "bandwidth     " << desc.bandwidth << std::endl;
 
+    if( desc.profile != SOCKETPROFILE_DEFAULT )
+        os << "profile       " << desc.profile << std::endl;
+
+    if( desc.cpu >= 0 )
+        os << "cpu           " << desc.cpu << std::endl;
+
     return os << lunchbox::exdent << "}" << lunchbox::enableHeader
               << lunchbox::enableFlush << std::endl;
 }
@@ -50,12 +50,23 @@ namespace co
         /** The filename used for named pipes. @version 1.0 */
         std::string filename;
 
+        /** The socket tuning profile (TCPIP, SDP). @version 1.1 */
+        SocketProfile profile;
+
+        /**
+         * The CPU processing incoming data (TCPIP), -1 for any.
+         * @version 1.1
+         */
+        int32_t cpu;
+
         /** Construct a new, default description. @version 1.0 */
         ConnectionDescription()
                 : type( CONNECTIONTYPE_TCPIP )
                 , bandwidth( 0 )
                 , port( 0 )
                 , filename( "default" )
+                , profile( SOCKETPROFILE_DEFAULT )
+                , cpu( -1 )
             {}
 
         /**
@@ -81,11 +92,13 @@ namespace co
          * The string is consumed as the description is parsed. Two different
          * formats are recognized, a human-readable and a machine-readable. The
          * human-readable version has the format
-         * <code>hostname[:port][:type]</code> or
+         * <code>hostname[:port][:type][:profile][:CPUn]</code> or
          * <code>filename:PIPE</code>. The <code>type</code> parameter can be
-         * TCPIP, SDP, IB, MCIP, UDT or RSP. The machine-readable format
-         * contains all connection description parameters, is not documented and
-         * subject to change.
+         * TCPIP, SDP, IB, MCIP, UDT, RSP or RELAY, the <code>profile</code>
+         * LATENCY or THROUGHPUT, and <code>CPUn</code> selects the CPU
+         * processing the incoming data of a socket. The machine-readable
+         * format contains all connection description parameters, is not
+         * documented and subject to change.
          *
          * @param data the string containing the connection description.
          * @return true if the information was read correctly, false if not.
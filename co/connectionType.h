@@ -37,7 +37,8 @@ namespace co
         CONNECTIONTYPE_RDMA,      //!< Infiniband RDMA CM
         CONNECTIONTYPE_UDT,       //!< UDT connection
         CONNECTIONTYPE_MULTICAST = 0x100, //!< @internal MC types after this:
-        CONNECTIONTYPE_RSP        //!< UDP-based reliable stream protocol
+        CONNECTIONTYPE_RSP,       //!< UDP-based reliable stream protocol
+        CONNECTIONTYPE_RELAY      //!< TCP-based relay tree
     };
 
     /** @internal */
@@ -52,6 +53,7 @@ namespace co
             case CONNECTIONTYPE_NAMEDPIPE: return os << "PIPE";
             case CONNECTIONTYPE_IB: return os << "IB";
             case CONNECTIONTYPE_RSP: return os << "RSP";
+            case CONNECTIONTYPE_RELAY: return os << "RELAY";
             case CONNECTIONTYPE_NONE: return os << "NONE";
             case CONNECTIONTYPE_RDMA: return os << "RDMA";
             case CONNECTIONTYPE_UDT: return os << "UDT";
@@ -62,6 +64,33 @@ namespace co
         }
         return os;
     }
+
+    /** The socket tuning profiles of TCPIP and SDP connections. */
+    enum SocketProfile
+    {
+        SOCKETPROFILE_DEFAULT = 0, //!< No delay, system buffer sizes
+        /** Immediate acks, busy polling and a small unsent queue */
+        SOCKETPROFILE_LATENCY,
+        /** Large socket buffers and zero-copy asynchronous large sends */
+        SOCKETPROFILE_THROUGHPUT
+    };
+
+    /** @internal */
+    inline std::ostream& operator << ( std::ostream& os,
+                                       const SocketProfile& profile )
+    {
+        switch( profile )
+        {
+            case SOCKETPROFILE_DEFAULT: return os << "DEFAULT";
+            case SOCKETPROFILE_LATENCY: return os << "LATENCY";
+            case SOCKETPROFILE_THROUGHPUT: return os << "THROUGHPUT";
+
+            default:
+                LBASSERTINFO( false, "Not implemented" );
+                return os << "ERROR";
+        }
+        return os;
+    }
 }
 
 #endif // CO_CONNECTIONTYPE_H
@@ -20,9 +20,12 @@
 
 #include "dataIStream.h"
 
-#include "global.h"
+#include "buffer.h"
+#include "byteSwap.h"
+#include "decompressorPool.h"
 #include "log.h"
 #include "node.h"
+#include "varint.h"
 
 #include <lunchbox/buffer.h>
 #include <lunchbox/debug.h>
@@ -35,6 +38,12 @@ namespace co
 {
 namespace detail
 {
+/** A buffer deleting itself when the last reference is released. */
+class ViewBuffer : public co::Buffer
+{
+    void notifyFree() override { delete this; }
+};
+
 class DataIStream
 {
 public:
@@ -54,18 +63,23 @@ public:
     /** The current read position in the buffer */
     uint64_t position;
 
+    /** The buffer holding the input, if known */
+    ConstBufferPtr buffer;
+
     lunchbox::Decompressor decompressor; //!< current decompressor
-    lunchbox::Bufferb data; //!< decompressed buffer
+    BufferPtr data; //!< decompressed buffer, shared with views
     bool swap; //!< Invoke endian conversion
 };
 }
 
 DataIStream::DataIStream( const bool swap_ )
         : _impl( new detail::DataIStream( swap_ ))
+        , _compact( false )
 {}
 
 DataIStream::DataIStream( const DataIStream& rhs )
         : _impl( new detail::DataIStream( rhs._impl->swap ))
+        , _compact( rhs._compact )
 {}
 
 DataIStream::~DataIStream()
@@ -78,6 +92,7 @@ DataIStream& DataIStream::operator = ( const DataIStream& rhs )
 {
     _reset();
     setSwapping( rhs.isSwapping( ));
+    setCompact( rhs.isCompact( ));
     return *this;
 }
 
@@ -97,15 +112,17 @@ void DataIStream::_reset()
     _impl->inputSize = 0;
     _impl->position  = 0;
     _impl->swap      = false;
+    _compact         = false;
+    _impl->buffer    = 0;
 }
 
-void DataIStream::_read( void* data, uint64_t size )
+const uint8_t* DataIStream::_consume( const uint64_t size )
 {
     if( !_checkBuffer( ))
     {
         LBUNREACHABLE;
         LBERROR << "No more input data" << std::endl;
-        return;
+        return 0;
     }
 
     LBASSERT( _impl->input );
@@ -118,11 +135,81 @@ void DataIStream::_read( void* data, uint64_t size )
         LBUNREACHABLE;
         // TODO: Allow reads which are asymmetric to writes by reading from
         // multiple blocks here?
-        return;
+        return 0;
     }
 
-    memcpy( data, _impl->input + _impl->position, size );
     _impl->position += size;
+    return _impl->input + _impl->position - size;
+}
+
+const void* DataIStream::_readView( const uint64_t size,
+                                   const size_t alignment,
+                                   ConstBufferPtr& buffer )
+{
+    const uint8_t* data = _consume( size );
+    if( data && reinterpret_cast< uintptr_t >( data ) % alignment == 0 )
+        buffer = _impl->buffer;
+    else
+        buffer = 0;
+    return data;
+}
+
+BufferPtr DataIStream::_copyView( const void* data, const uint64_t size )
+{
+    BufferPtr buffer = new detail::ViewBuffer;
+    buffer->replace( data, size );
+    return buffer;
+}
+
+void DataIStream::_read( void* data, uint64_t size )
+{
+    const uint8_t* input = _consume( size );
+    if( input )
+        memcpy( data, input, size );
+}
+
+void DataIStream::_readSwapped( void* data, uint64_t size,
+                                const size_t wordSize )
+{
+    const uint8_t* input = _consume( size );
+    if( input )
+        swapWords( input, data, size, wordSize );
+}
+
+void DataIStream::_readVarint( void* value, const size_t size,
+                               const bool isSigned )
+{
+    if( !_checkBuffer( ))
+    {
+        LBUNREACHABLE;
+        LBERROR << "No more input data" << std::endl;
+        return;
+    }
+
+    // a write is never split across buffers, see getRemainingBuffer()
+    uint64_t bits = 0;
+    const size_t varintSize = decodeVarint( _impl->input + _impl->position,
+                                            _impl->inputSize - _impl->position,
+                                            bits );
+    if( varintSize == 0 )
+    {
+        LBERROR << "Malformed varint in input buffer, "
+                << _impl->inputSize - _impl->position << " bytes left"
+                << std::endl;
+        LBUNREACHABLE;
+        return;
+    }
+    _impl->position += varintSize;
+
+    if( isSigned )
+        bits = uint64_t( zigzagDecode( bits ));
+    switch( size )
+    {
+    case 2: *static_cast< uint16_t* >( value ) = uint16_t( bits ); break;
+    case 4: *static_cast< uint32_t* >( value ) = uint32_t( bits ); break;
+    case 8: *static_cast< uint64_t* >( value ) = bits; break;
+    default: LBUNIMPLEMENTED;
+    }
 }
 
 const void* DataIStream::getRemainingBuffer( const uint64_t size )
@@ -154,11 +241,16 @@ bool DataIStream::_checkBuffer()
         uint32_t nChunks = 0;
         const void* data = 0;
 
+        _impl->buffer = 0;
         if( !getNextBuffer( compressor, nChunks, &data, _impl->inputSize ))
             return false;
 
         _impl->input = _decompress( data, compressor, nChunks,
                                     _impl->inputSize );
+        if( compressor == EQ_COMPRESSOR_NONE )
+            _impl->buffer = getCurrentBuffer();
+        else
+            _impl->buffer = _impl->data;
         _impl->position = 0;
     }
     return true;
@@ -168,39 +260,21 @@ const uint8_t* DataIStream::_decompress( const void* data, const uint32_t name,
                                          const uint32_t nChunks,
                                          const uint64_t dataSize )
 {
-    const uint8_t* src = reinterpret_cast< const uint8_t* >( data );
     if( name == EQ_COMPRESSOR_NONE )
-        return src;
+        return reinterpret_cast< const uint8_t* >( data );
 
     LBASSERT( name > EQ_COMPRESSOR_NONE );
+    // views on the previous data keep it, decompress into a new buffer
+    if( !_impl->data || _impl->data->getRefCount() > 1 )
+        _impl->data = new detail::ViewBuffer;
 #ifndef CO_AGGRESSIVE_CACHING
-    _impl->data.clear();
+    _impl->data->clear();
 #endif
-    _impl->data.reset( dataSize );
-
-    _impl->decompressor.setup( Global::getPluginRegistry(), name );
-    LBASSERT( _impl->decompressor.uses( name ));
-
-    uint64_t outDim[2] = { 0, dataSize };
-    uint64_t* chunkSizes = static_cast< uint64_t* >(
-                                alloca( nChunks * sizeof( uint64_t )));
-    void** chunks = static_cast< void ** >(
-                                alloca( nChunks * sizeof( void* )));
-
-    for( uint32_t i = 0; i < nChunks; ++i )
-    {
-        const uint64_t size = *reinterpret_cast< const uint64_t* >( src );
-        chunkSizes[ i ] = size;
-        src += sizeof( uint64_t );
-
-        // The plugin API uses non-const source buffers for in-place operations
-        chunks[ i ] = const_cast< uint8_t* >( src );
-        src += size;
-    }
+    _impl->data->reset( dataSize );
 
-    _impl->decompressor.decompress( chunks, chunkSizes, nChunks,
-                                    _impl->data.getData(), outDim );
-    return _impl->data.getData();
+    DecompressorPool::decompress( _impl->decompressor, data, name, nChunks,
+                                  _impl->data->getData(), dataSize );
+    return _impl->data->getData();
 }
 
 }
@@ -24,10 +24,12 @@
 
 #include <co/api.h>
 #include <co/array.h> // used inline
+#include <co/arrayView.h> // used inline
 #include <co/types.h>
 
 #include <lunchbox/stdExt.h>
 
+#include <cstring>
 #include <map>
 #include <set>
 #include <vector>
@@ -49,14 +51,21 @@ public:
     virtual void reset() { _reset(); } //!< @internal
     void setSwapping( const bool onOff ); //!< @internal enable endian swap
     CO_API bool isSwapping() const; //!< @internal
+    void setCompact( const bool onOff ) { _compact = onOff; } //!< @internal
+    bool isCompact() const { return _compact; } //!< @internal
     DataIStream& operator = ( const DataIStream& rhs ); //!< @internal
     //@}
 
     /** @name Data input */
     //@{
-    /** Read a plain data item. @version 1.0 */
+    /**
+     * Read a plain data item.
+     *
+     * Integers are read as varints if the stream uses the compact encoding.
+     * @version 1.0
+     */
     template< class T > DataIStream& operator >> ( T& value )
-        { _read( &value, sizeof( value )); _swap( value ); return *this; }
+        { _readPlain( value, IsVarint< T >( )); return *this; }
 
     /** Read a C array. @version 1.0 */
     template< class T > DataIStream& operator >> ( Array< T > array );
@@ -81,6 +90,12 @@ public:
     /** Read a stde::hash_set of serializable items. @version 1.0 */
     template< class T > DataIStream& operator >> ( stde::hash_set< T >& );
 
+    /**
+     * Read a std::vector of flat items in place, see readView().
+     * @version 1.0
+     */
+    template< class T > DataIStream& operator >> ( ArrayView< T >& );
+
     /**
      * @define CO_IGNORE_BYTESWAP: If set, no byteswapping of transmitted data
      * is performed. Enable when you get unresolved symbols for
@@ -136,6 +151,24 @@ public:
      */
     CO_API uint64_t getRemainingBufferSize();
 
+    /**
+     * Read an array of flat items without copying them.
+     *
+     * The returned view references the items in the buffer they were
+     * received or decompressed into, and keeps this buffer alive. Like for
+     * getRemainingBuffer(), the items have to be written by a single write
+     * operation, e.g., a std::vector or Array of the same size.
+     *
+     * The items are copied into a new buffer if they are not aligned for T,
+     * need to be byte-swapped, or if the stream implementation does not
+     * provide the buffer holding its data.
+     *
+     * @param num the number of items to read.
+     * @return the view on the items.
+     * @version 1.0
+     */
+    template< class T > ArrayView< T > readView( const uint64_t num );
+
     /** @return true if not all data has been read. @version 1.0 */
     bool hasData() { return _checkBuffer(); }
 
@@ -152,19 +185,63 @@ protected:
 
     virtual bool getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
                                 const void** chunkData, uint64_t& size )=0;
+
+    /**
+     * @return the buffer holding the data of the last getNextBuffer(), or 0
+     *         if it is not held by a Buffer.
+     */
+    virtual ConstBufferPtr getCurrentBuffer() const
+        { return ConstBufferPtr(); }
     //@}
 
 private:
     detail::DataIStream* const _impl;
+    bool _compact; //!< Decode varints, inline for the raw integer path
 
     /** Read a number of bytes from the stream into a buffer. */
     CO_API void _read( void* data, uint64_t size );
 
+    /**
+     * Read a number of bytes from the stream into a buffer, reversing the
+     * byte order of each word of the given size while copying.
+     */
+    CO_API void _readSwapped( void* data, uint64_t size,
+                              const size_t wordSize );
+
+    /** Read an integer encoded as a varint. */
+    CO_API void _readVarint( void* value, const size_t size,
+                             const bool isSigned );
+
+    /** Read a plain data item or an integer. */
+    template< class T > void _readPlain( T& value, const std::false_type& )
+        { _read( &value, sizeof( value )); _swap( value ); }
+    template< class T > void _readPlain( T& value, const std::true_type& )
+    {
+        if( _compact )
+            _readVarint( &value, sizeof( value ), std::is_signed< T >::value );
+        else
+            _readPlain( value, std::false_type( ));
+    }
+
     /**
      * Check that the current buffer has data left, get the next buffer is
      * necessary, return false if no data is left.
      */
     CO_API bool _checkBuffer();
+
+    /** @return the next size bytes of the current buffer, or 0 on error. */
+    const uint8_t* _consume( const uint64_t size );
+
+    /**
+     * Read size bytes in place. The buffer holding them is returned if they
+     * are aligned and the buffer is known, otherwise it is set to 0.
+     */
+    CO_API const void* _readView( const uint64_t size, const size_t alignment,
+                                  ConstBufferPtr& buffer );
+
+    /** @return a new, self-deleting buffer holding a copy of the data. */
+    CO_API static BufferPtr _copyView( const void* data,
+                                       const uint64_t size );
     CO_API void _reset();
 
     const uint8_t* _decompress( const void* data, const uint32_t name,
@@ -185,16 +262,59 @@ private:
             return *this;
         }
 
+    /** Read a std::vector of flat or serializable items. */
+    template< class T >
+    DataIStream& _readVector( std::vector< T >& value, const std::true_type& )
+        { return _readFlatVector( value ); }
+    template< class T >
+    DataIStream& _readVector( std::vector< T >& value, const std::false_type& );
+
+    /** Read a set of flat items, from one block if possible. */
+    template< class C >
+    DataIStream& _readSet( C& value, const std::true_type& );
+    template< class C >
+    DataIStream& _readSet( C& value, const std::false_type& );
+
+    /** Read a map of flat keys and values, from one block if possible. */
+    template< class C > DataIStream& _readMap( C& map, const std::true_type& );
+    template< class C > DataIStream& _readMap( C& map, const std::false_type& );
+
+    /** Reserve space for the elements of hash containers. */
+    template< class C > static void _reserve( C&, const uint64_t ) {}
+    template< class K, class V >
+    static void _reserve( stde::hash_map< K, V >& map, const uint64_t nElems )
+        { map.reserve( size_t( nElems )); }
+    template< class T >
+    static void _reserve( stde::hash_set< T >& set, const uint64_t nElems )
+        { set.reserve( size_t( nElems )); }
+
     /** Byte-swap a plain data item. @version 1.0 */
     template< class T > void _swap( T& value ) const
         { if( isSwapping( )) swap( value ); }
 
+    /**
+     * The size of the words to byte-swap in an array of T, 0 if the items
+     * have to be swapped one by one. Only 2, 4 and 8 byte words are swapped
+     * as arrays, other sizes such as long double are swapped per item.
+     */
+#  ifdef CO_IGNORE_BYTESWAP
+    template< class T, bool = false >
+    struct SwapWord : public std::integral_constant< size_t, 0 > {};
+#  else
+    template< class T, bool = std::is_arithmetic< T >::value >
+    struct SwapWord : public std::integral_constant< size_t, 0 > {};
+    template< class T > struct SwapWord< T, true >
+        : public std::integral_constant< size_t,
+              sizeof( T ) == 2 || sizeof( T ) == 4 || sizeof( T ) == 8 ?
+                  sizeof( T ) : 0 > {};
+#  endif
+
     /** Byte-swap a C array. @version 1.0 */
     template< class T > void _swap( Array< T > array ) const
         {
             if( !isSwapping( ))
                 return;
-#pragma omp parallel for
+#pragma omp parallel for if( array.getNumBytes() >= LB_1MB )
             for( ssize_t i = 0; i < ssize_t( array.num ); ++i )
                 swap( array.data[i] );
         }
@@ -39,6 +39,26 @@ namespace co
         return *this;
     }
 
+    /** Read a uint128_t, written as two varints if compact. */
+    template<>
+    inline DataIStream& DataIStream::operator >> ( uint128_t& value )
+    {
+        if( _compact )
+            return *this >> value.high() >> value.low();
+        _read( &value, sizeof( value ));
+        _swap( value );
+        return *this;
+    }
+
+    /** Read an object version, the identifier is never compacted. */
+    template<>
+    inline DataIStream& DataIStream::operator >> ( ObjectVersion& value )
+    {
+        _read( &value.identifier, sizeof( value.identifier ));
+        _swap( value.identifier );
+        return *this >> value.version;
+    }
+
     /** Deserialize an object (id+version). */
     template<> inline DataIStream& DataIStream::operator >> ( Object*& object )
     {
@@ -53,11 +73,50 @@ namespace co
     template< class T > inline DataIStream&
     DataIStream::operator >> ( Array< T > array )
     {
+        if( SwapWord< T >::value > 1 && isSwapping( ))
+        {
+            _readSwapped( array.data, array.getNumBytes(),
+                          SwapWord< T >::value );
+            return *this;
+        }
         _read( array.data, array.getNumBytes( ));
         _swap( array );
         return *this;
     }
 
+    template< class T > inline DataIStream&
+    DataIStream::operator >> ( ArrayView< T >& view )
+    {
+        uint64_t nElems = 0;
+        *this >> nElems;
+        LBASSERTINFO( nElems < LB_BIT48,
+                    "Out-of-sync co::DataIStream: " << nElems << " elements?" );
+        view = readView< T >( nElems );
+        return *this;
+    }
+
+    template< class T > inline ArrayView< T >
+    DataIStream::readView( const uint64_t num )
+    {
+        static_assert( IsFlat< T >::value, "ArrayView needs flat items" );
+        if( num == 0 )
+            return ArrayView< T >();
+
+        const uint64_t size = num * sizeof( T );
+        ConstBufferPtr buffer;
+        const void* data = _readView( size, alignof( T ), buffer );
+        if( !data )
+            return ArrayView< T >();
+        if( buffer && !isSwapping( ))
+            return ArrayView< T >( static_cast< const T* >( data ), num,
+                                   buffer );
+
+        BufferPtr copy = _copyView( data, size );
+        T* items = reinterpret_cast< T* >( copy->getData( ));
+        _swap( Array< T >( items, num ));
+        return ArrayView< T >( items, num, copy );
+    }
+
     template< class T > inline DataIStream&
     DataIStream::operator >> ( lunchbox::Buffer< T >& buffer )
     {
@@ -72,6 +131,40 @@ namespace co
 
     template< class T > inline DataIStream&
     DataIStream::operator >> ( std::vector< T >& value )
+    {
+        return _readVector( value, IsFlat< T >( ));
+    }
+
+    template< class K, class V > inline DataIStream&
+    DataIStream::operator >> ( std::map< K, V >& map )
+    {
+        typedef std::integral_constant< bool, IsFlat< K >::value &&
+                                              IsFlat< V >::value > Flat;
+        return _readMap( map, Flat( ));
+    }
+
+    template< class T > inline DataIStream&
+    DataIStream::operator >> ( std::set< T >& value )
+    {
+        return _readSet( value, IsFlat< T >( ));
+    }
+
+    template< class K, class V > inline DataIStream&
+    DataIStream::operator >> ( stde::hash_map< K, V >& map )
+    {
+        typedef std::integral_constant< bool, IsFlat< K >::value &&
+                                              IsFlat< V >::value > Flat;
+        return _readMap( map, Flat( ));
+    }
+
+    template< class T > inline DataIStream&
+    DataIStream::operator >> ( stde::hash_set< T >& value )
+    {
+        return _readSet( value, IsFlat< T >( ));
+    }
+
+    template< class T > inline DataIStream&
+    DataIStream::_readVector( std::vector< T >& value, const std::false_type& )
     {
         uint64_t nElems = 0;
         *this >> nElems;
@@ -81,64 +174,123 @@ namespace co
         return *this;
     }
 
-    template< class K, class V > inline DataIStream&
-    DataIStream::operator >> ( std::map< K, V >& map )
+    template< class C > inline DataIStream&
+    DataIStream::_readSet( C& value, const std::true_type& )
     {
-        map.clear();
+        typedef typename C::value_type T;
+        value.clear();
         uint64_t nElems = 0;
         *this >> nElems;
-        for( uint64_t i = 0; i < nElems; ++i )
+        if( nElems == 0 )
+            return *this;
+
+        _reserve( value, nElems );
+        const uint64_t size = nElems * sizeof( T );
+        if( getRemainingBufferSize() < size ) // written item by item
         {
-            typename std::map< K, V >::key_type key;
-            typename std::map< K, V >::mapped_type value;
-            *this >> key >> value;
-            map.insert( std::make_pair( key, value ));
+            for( uint64_t i = 0; i < nElems; ++i )
+            {
+                T item;
+                _readPlain( item, std::false_type( ));
+                value.insert( item );
+            }
+            return *this;
+        }
+
+        const uint8_t* data = static_cast< const uint8_t* >(
+            getRemainingBuffer( size ));
+        LBASSERTINFO( data,
+                    "Out-of-sync co::DataIStream: " << nElems << " elements?" );
+        if( !data )
+            return *this;
+
+        for( uint64_t i = 0; i < nElems; ++i, data += sizeof( T ))
+        {
+            T item;
+            ::memcpy( &item, data, sizeof( T ));
+            _swap( item );
+            value.insert( item );
         }
         return *this;
     }
 
-    template< class T > inline DataIStream&
-    DataIStream::operator >> ( std::set< T >& value )
+    template< class C > inline DataIStream&
+    DataIStream::_readSet( C& value, const std::false_type& )
     {
         value.clear();
         uint64_t nElems = 0;
         *this >> nElems;
+        _reserve( value, nElems );
         for( uint64_t i = 0; i < nElems; ++i )
         {
-            T item;
+            typename C::value_type item;
             *this >> item;
             value.insert( item );
         }
         return *this;
     }
 
-    template< class K, class V > inline DataIStream&
-    DataIStream::operator >> ( stde::hash_map< K, V >& map )
+    template< class C > inline DataIStream&
+    DataIStream::_readMap( C& map, const std::true_type& )
     {
+        typedef typename C::key_type K;
+        typedef typename C::mapped_type V;
         map.clear();
         uint64_t nElems = 0;
         *this >> nElems;
+        if( nElems == 0 )
+            return *this;
+
+        _reserve( map, nElems );
+        const uint64_t size = nElems * ( sizeof( K ) + sizeof( V ));
+        if( getRemainingBufferSize() < size ) // written item by item
+        {
+            for( uint64_t i = 0; i < nElems; ++i )
+            {
+                K key;
+                V value;
+                _readPlain( key, std::false_type( ));
+                _readPlain( value, std::false_type( ));
+                map.insert( std::make_pair( key, value ));
+            }
+            return *this;
+        }
+
+        const uint8_t* data = static_cast< const uint8_t* >(
+            getRemainingBuffer( size ));
+        LBASSERTINFO( data,
+                    "Out-of-sync co::DataIStream: " << nElems << " elements?" );
+        if( !data )
+            return *this;
+
         for( uint64_t i = 0; i < nElems; ++i )
         {
-            typename stde::hash_map< K, V >::key_type key;
-            typename stde::hash_map< K, V >::mapped_type value;
-            *this >> key >> value;
+            K key;
+            V value;
+            ::memcpy( &key, data, sizeof( K ));
+            data += sizeof( K );
+            ::memcpy( &value, data, sizeof( V ));
+            data += sizeof( V );
+            _swap( key );
+            _swap( value );
             map.insert( std::make_pair( key, value ));
         }
         return *this;
     }
 
-    template< class T > inline DataIStream&
-    DataIStream::operator >> ( stde::hash_set< T >& value )
+    template< class C > inline DataIStream&
+    DataIStream::_readMap( C& map, const std::false_type& )
     {
-        value.clear();
+        map.clear();
         uint64_t nElems = 0;
         *this >> nElems;
+        _reserve( map, nElems );
         for( uint64_t i = 0; i < nElems; ++i )
         {
-            T item;
-            *this >> item;
-            value.insert( item );
+            typename C::key_type key;
+            typename C::mapped_type value;
+            *this >> key >> value;
+            map.insert( std::make_pair( key, value ));
         }
         return *this;
     }
@@ -159,6 +311,12 @@ namespace co
 
     template<> inline void DataIStream::_swap( Array< void > ) const { /*NOP*/ }
 
+#ifndef CO_IGNORE_BYTESWAP
+    /** uint128_t is swapped as two 64 bit words, see lunchbox::byteswap */
+    template<> struct DataIStream::SwapWord< uint128_t, false >
+        : public std::integral_constant< size_t, 8 > {};
+#endif
+
     template< typename O, typename C > inline void
     DataIStream::deserializeChildren( O* object, const std::vector< C* >& old_,
                                       std::vector< C* >& result )
@@ -272,6 +430,10 @@ namespace co
     /** Optimized specialization to read a std::vector of ObjectVersion. */
     template<> inline DataIStream&
     DataIStream::operator >> ( std::vector< ObjectVersion >& value )
-    { return _readFlatVector( value ); }
+    {
+        if( _compact )
+            return _readVector( value, std::false_type( ));
+        return _readFlatVector( value );
+    }
     //@}
 }
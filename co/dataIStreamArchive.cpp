@@ -40,25 +40,34 @@ namespace co
 DataIStreamArchive::DataIStreamArchive( DataIStream& stream )
     : Super( 0 )
     , _stream( stream )
+    , _native( false )
 {
     using namespace boost::archive;
 
-    if( _loadSignedChar() != magicByte )
-        throw archive_exception( archive_exception::invalid_signature );
-    else
+    const signed char magic = _loadSignedChar();
+    if( magic == nativeMagicByte )
     {
+        uint32_t layout = 0;
+        _stream >> layout;
+        if( layout != getNativeLayout( ))
+            throw archive_exception(
+                archive_exception::incompatible_native_format );
+        _native = true;
+    }
+    else if( magic != magicByte )
+        throw archive_exception( archive_exception::invalid_signature );
+
 #if BOOST_VERSION < 104400
-        version_type libraryVersion;
+    version_type libraryVersion;
 #else
-        library_version_type libraryVersion;
+    library_version_type libraryVersion;
 #endif
-        operator>>( libraryVersion );
+    operator>>( libraryVersion );
 
-        if( libraryVersion > BOOST_ARCHIVE_VERSION( ))
-            throw archive_exception( archive_exception::unsupported_version );
-        else
-            set_library_version( libraryVersion );
-    }
+    if( libraryVersion > BOOST_ARCHIVE_VERSION( ))
+        throw archive_exception( archive_exception::unsupported_version );
+    else
+        set_library_version( libraryVersion );
 }
 
 void DataIStreamArchive::load_binary( void* data, std::size_t size )
@@ -74,7 +83,7 @@ void DataIStreamArchive::load( bool& b )
         b = false;
         break;
     case 1:
-        b = _loadSignedChar();
+        b = _native ? true : _loadSignedChar();
         break;
     default:
         throw DataStreamArchiveException( c );
@@ -51,7 +51,15 @@
 
 namespace co
 {
-/** A boost.serialization input archive reading from a co::DataIStream. */
+/**
+ * A boost.serialization input archive reading from a co::DataIStream.
+ *
+ * Reads the portable and the native format of DataOStreamArchive. Native
+ * archives written on a platform with different sizes of the fundamental
+ * types are rejected with an incompatible_native_format archive_exception. A
+ * native long which does not fit into the long of this platform throws a
+ * DataStreamArchiveException.
+ */
 class DataIStreamArchive
     : public boost::archive::basic_binary_iarchive< DataIStreamArchive >
     , public boost::archive::detail::shared_ptr_helper
@@ -144,9 +152,17 @@ private:
     CO_API void load( boost::archive::version_type& version );
 #endif
 
+    /** Load t written by DataOStreamArchive::_toNative(). */
+    template< typename T > void _loadNative( T& t ) { _stream >> t; }
+    void _loadNative( long& t ) { _loadNative< long, int64_t >( t ); }
+    void _loadNative( unsigned long& t )
+        { _loadNative< unsigned long, uint64_t >( t ); }
+    template< typename T, typename W > void _loadNative( T& t );
+
     CO_API signed char _loadSignedChar();
 
     DataIStream& _stream;
+    bool _native;
 };
 
 }
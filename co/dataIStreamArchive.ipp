@@ -47,6 +47,12 @@ DataIStreamArchive::load( T& t )
     namespace bs = boost::spirit::detail;
 #endif
 
+    if( _native )
+    {
+        _loadNative( t );
+        return;
+    }
+
     // get the number of bytes in the stream
     if( signed char size = _loadSignedChar( ))
     {
@@ -88,8 +94,13 @@ DataIStreamArchive::load( T& t )
     BOOST_STATIC_ASSERT( sizeof(bits) == sizeof(T));
     BOOST_STATIC_ASSERT( std::numeric_limits<T>::is_iec559 );
 
-    load( bits );
-    traits::set_bits( t, bits );
+    if( _native )
+        _stream >> t;
+    else
+    {
+        load( bits );
+        traits::set_bits( t, bits );
+    }
 
     // if the no_infnan flag is set we must throw here
     if( get_flags() & serialization::no_infnan && !fp::isfinite( t ))
@@ -105,4 +116,17 @@ DataIStreamArchive::load( T& t )
     }
 }
 
+template< typename T, typename W >
+void DataIStreamArchive::_loadNative( T& t )
+{
+    W value;
+    _stream >> value;
+    t = T( value );
+
+    // e.g. a long written on LP64 exceeding the 32 bit long of LLP64
+    if( W( t ) != value )
+        throw DataStreamArchiveException( static_cast< signed char >(
+                                             sizeof( W )));
+}
+
 }
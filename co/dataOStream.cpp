@@ -29,6 +29,7 @@
 #include "log.h"
 #include "node.h"
 #include "types.h"
+#include "varint.h"
 
 #include <lunchbox/compressor.h>
 #include <lunchbox/plugins/compressor.h>
@@ -90,6 +91,13 @@ public:
     /** Save all sent data */
     bool save;
 
+    /** Use the compact encoding after the next enable */
+    bool nextCompact;
+
+    /** All receivers read native archives, latched on enable */
+    bool nativeArchive;
+    bool nextNativeArchive;
+
     DataOStream()
             : state( STATE_UNCOMPRESSED )
             , bufferStart( 0 )
@@ -97,6 +105,9 @@ public:
             , enabled( false )
             , dataSent( false )
             , save( false )
+            , nextCompact( false )
+            , nativeArchive( false )
+            , nextNativeArchive( false )
         {}
 
     DataOStream( const DataOStream& rhs )
@@ -106,6 +117,9 @@ public:
         , enabled( rhs.enabled )
         , dataSent( rhs.dataSent )
         , save( rhs.save )
+        , nextCompact( rhs.nextCompact )
+        , nativeArchive( rhs.nativeArchive )
+        , nextNativeArchive( rhs.nextNativeArchive )
     {}
 
     uint32_t getCompressor() const
@@ -192,11 +206,13 @@ public:
 
 DataOStream::DataOStream()
         : _impl( new detail::DataOStream )
+        , _compact( false )
 {}
 
 DataOStream::DataOStream( DataOStream& rhs )
     : lunchbox::NonCopyable()
     , _impl( new detail::DataOStream( *rhs._impl ))
+    , _compact( rhs._compact )
 {
     _setupConnections( rhs.getConnections( ));
     getBuffer().swap( rhs.getBuffer( ));
@@ -228,6 +244,8 @@ void DataOStream::_enable()
     _impl->dataSent    = false;
     _impl->dataSize    = 0;
     _impl->enabled     = true;
+    _compact           = _impl->nextCompact;
+    _impl->nativeArchive = _impl->nextNativeArchive;
     _impl->buffer.setSize( 0 );
 #ifdef CO_AGGRESSIVE_CACHING
     _impl->buffer.reserve( COMMAND_ALLOCSIZE );
@@ -236,9 +254,30 @@ void DataOStream::_enable()
 #endif
 }
 
+bool DataOStream::isNativeArchive() const
+{
+    return _impl->nativeArchive;
+}
+
+void DataOStream::_setCompact( const bool compact )
+{
+    _impl->nextCompact = compact;
+}
+
 void DataOStream::_setupConnections( const Nodes& receivers )
 {
     gatherConnections( receivers, _impl->connections );
+
+    // multicast connections share the data, so all receivers have to agree
+    bool compact = !receivers.empty();
+    bool native = !receivers.empty();
+    for( NodesCIter i = receivers.begin(); i != receivers.end(); ++i )
+    {
+        compact = compact && (*i)->isCompactData();
+        native = native && (*i)->isNativeArchive();
+    }
+    _setCompact( compact );
+    _impl->nextNativeArchive = native;
 }
 
 void DataOStream::_setupConnections( const Connections& connections )
@@ -250,6 +289,8 @@ void DataOStream::_setupConnection( NodePtr node, const bool useMulticast )
 {
     LBASSERT( _impl->connections.empty( ));
     _impl->connections.push_back( node->getConnection( useMulticast ));
+    _setCompact( node->isCompactData( ));
+    _impl->nextNativeArchive = node->isNativeArchive();
 }
 
 void DataOStream::_setupConnection( ConnectionPtr connection )
@@ -267,6 +308,29 @@ void DataOStream::_resend()
     sendData( _impl->buffer.getData(), _impl->dataSize, true );
 }
 
+uint64_t DataOStream::_getSavedSize() const
+{
+    if( _impl->enabled || !_impl->save ||
+        _impl->buffer.getSize() != _impl->dataSize )
+    {
+        return 0;
+    }
+    return _impl->dataSize;
+}
+
+void DataOStream::_releaseSaved()
+{
+    LBASSERT( !_impl->enabled );
+    _impl->buffer.clear();
+    if( _impl->state == STATE_UNCOMPRESSIBLE )
+        return; // remember to not compress again
+
+    _impl->state = STATE_UNCOMPRESSED;
+    _impl->compressedDataSize = 0;
+    if( _impl->compressor.isGood( ))
+        _impl->compressor.realloc(); // free compressed results
+}
+
 void DataOStream::_clearConnections()
 {
     _impl->connections.clear();
@@ -350,6 +414,50 @@ void DataOStream::_write( const void* data, uint64_t size )
     _impl->buffer.append( static_cast< const uint8_t* >( data ), size );
 }
 
+void DataOStream::_writeVarint( const void* value, const size_t size,
+                                const bool isSigned )
+{
+    uint64_t bits = 0;
+    switch( size )
+    {
+    case 2:
+        bits = isSigned ? uint64_t( *static_cast< const int16_t* >( value )) :
+                          *static_cast< const uint16_t* >( value );
+        break;
+    case 4:
+        bits = isSigned ? uint64_t( *static_cast< const int32_t* >( value )) :
+                          *static_cast< const uint32_t* >( value );
+        break;
+    case 8:
+        bits = *static_cast< const uint64_t* >( value );
+        break;
+    default:
+        LBUNIMPLEMENTED;
+    }
+    if( isSigned )
+        bits = zigzagEncode( int64_t( bits ));
+
+    uint8_t bytes[ VARINT_MAXSIZE ];
+    _write( bytes, encodeVarint( bits, bytes ));
+}
+
+uint8_t* DataOStream::_reserve( const uint64_t size )
+{
+    LBASSERT( _impl->enabled );
+#ifdef EQ_INSTRUMENT_DATAOSTREAM
+    nBytes += size;
+#endif
+
+    if( _impl->buffer.getSize() - _impl->bufferStart >
+        Global::getObjectBufferSize( ))
+    {
+        flush( false );
+    }
+    const uint64_t position = _impl->buffer.getSize();
+    _impl->buffer.resize( position + size );
+    return _impl->buffer.getData() + position;
+}
+
 void DataOStream::flush( const bool last )
 {
     LBASSERT( _impl->enabled );
@@ -421,14 +529,15 @@ DataOStream& DataOStream::streamDataHeader( DataOStream& os )
     return os;
 }
 
-void DataOStream::sendBody( ConnectionPtr connection, const uint64_t dataSize )
+void DataOStream::sendBody( const Connections& connections,
+                            const uint64_t dataSize )
 {
     const uint32_t compressor = _impl->getCompressor();
     if( compressor == EQ_COMPRESSOR_NONE )
     {
         if( dataSize > 0 )
-            LBCHECK( connection->send( _impl->buffer.getData(), dataSize,
-                                       true ));
+            LBCHECK( Connection::send( connections, _impl->buffer.getData(),
+                                       dataSize, true ));
         return;
     }
 
@@ -450,8 +559,10 @@ void DataOStream::sendBody( ConnectionPtr connection, const uint64_t dataSize )
 
     for( size_t j = 0; j < nChunks; ++j )
     {
-        LBCHECK( connection->send( &chunkSizes[j], sizeof( uint64_t ), true ));
-        LBCHECK( connection->send( chunks[j], chunkSizes[j], true ));
+        LBCHECK( Connection::send( connections, &chunkSizes[j],
+                                   sizeof( uint64_t ), true ));
+        LBCHECK( Connection::send( connections, chunks[j], chunkSizes[j],
+                                   true ));
     }
 }
 
@@ -28,6 +28,7 @@
 #include <lunchbox/nonCopyable.h> // base class
 #include <lunchbox/stdExt.h>
 
+#include <cstring>
 #include <map>
 #include <set>
 #include <vector>
@@ -66,18 +67,34 @@ namespace DataStreamTest { class Sender; }
         /** @internal Stream the data header (compressor, nChunks). */
         DataOStream& streamDataHeader( DataOStream& os );
 
-        /** @internal Send the (compressed) data using the given connection. */
-        void sendBody( ConnectionPtr connection, const uint64_t dataSize );
+        /** @internal Send the (compressed) data to the locked connections. */
+        void sendBody( const Connections& connections,
+                       const uint64_t dataSize );
 
         /** @internal @return the compressed data size, 0 if uncompressed.*/
         uint64_t getCompressedDataSize() const;
+
+        /** @internal @return true if the data uses the compact encoding. */
+        bool isCompact() const { return _compact; }
+
+        /**
+         * @internal @return true if all receivers read native archives, see
+         *           Node::isNativeArchive().
+         */
+        CO_API bool isNativeArchive() const;
         //@}
 
         /** @name Data output */
         //@{
-        /** Write a plain data item by copying it to the stream. @version 1.0 */
+        /**
+         * Write a plain data item by copying it to the stream.
+         *
+         * Integers are written as varints, zigzag-encoded if signed, if the
+         * stream uses the compact encoding.
+         * @version 1.0
+         */
         template< class T > DataOStream& operator << ( const T& value )
-            { _write( &value, sizeof( value )); return *this; }
+            { _writePlain( value, IsVarint< T >( )); return *this; }
 
         /** Write a C array. @version 1.0 */
         template< class T > DataOStream& operator << ( Array< T > array )
@@ -131,6 +148,13 @@ namespace DataStreamTest { class Sender; }
         /** @internal Enable output. */
         CO_API void _enable();
 
+        /**
+         * @internal Use the compact encoding for the data written after the
+         * next enable. Set by the node setup functions below from
+         * Node::isCompactData() of all receivers.
+         */
+        CO_API void _setCompact( const bool compact );
+
         /** @internal Flush remaining data in the buffer. */
         void flush( const bool last );
 
@@ -152,6 +176,18 @@ namespace DataStreamTest { class Sender; }
         /** @internal Resend the saved buffer to all enabled connections. */
         void _resend();
 
+        /**
+         * @internal @return the size of the saved data if the saved buffer
+         *           holds all of it uncompressed, 0 otherwise.
+         */
+        uint64_t _getSavedSize() const;
+
+        /**
+         * @internal Free the saved buffer and the compressed data. The
+         * subclass has to refill the saved buffer before the next _resend().
+         */
+        void _releaseSaved();
+
         void _clearConnections(); //!< @internal
 
         /** @internal @name Data sending, used by the subclasses */
@@ -166,6 +202,7 @@ namespace DataStreamTest { class Sender; }
 
     private:
         detail::DataOStream* const _impl;
+        bool _compact; //!< Encode varints, inline for the raw integer path
 
         /** Collect compressed data. */
         CO_API uint64_t _getCompressedData( void** chunks,
@@ -174,6 +211,24 @@ namespace DataStreamTest { class Sender; }
         /** Write a number of bytes from data into the stream. */
         CO_API void _write( const void* data, uint64_t size );
 
+        /** Write an integer encoded as a varint. */
+        CO_API void _writeVarint( const void* value, const size_t size,
+                                  const bool isSigned );
+
+        /** Write a plain data item or an integer. */
+        template< class T >
+        void _writePlain( const T& value, const std::false_type& )
+            { _write( &value, sizeof( value )); }
+        template< class T >
+        void _writePlain( const T& value, const std::true_type& )
+        {
+            if( _compact )
+                _writeVarint( &value, sizeof( value ),
+                              std::is_signed< T >::value );
+            else
+                _write( &value, sizeof( value ));
+        }
+
         /** Helper function preparing data for sendData() as needed. */
         void _sendData( const void* data, const uint64_t size );
 
@@ -185,11 +240,35 @@ namespace DataStreamTest { class Sender; }
         DataOStream& _writeFlatVector( const std::vector< T >& value )
         {
             const uint64_t nElems = value.size();
-            _write( &nElems, sizeof( nElems ));
+            *this << nElems;
             if( nElems > 0 )
                 _write( &value.front(), nElems * sizeof( T ));
             return *this;
         }
+
+        /** Append size uninitialized bytes to the stream. */
+        CO_API uint8_t* _reserve( const uint64_t size );
+
+        /** Write a std::vector of flat or serializable items. */
+        template< class T >
+        DataOStream& _writeVector( const std::vector< T >& value,
+                                   const std::true_type& )
+            { return _writeFlatVector( value ); }
+        template< class T >
+        DataOStream& _writeVector( const std::vector< T >& value,
+                                   const std::false_type& );
+
+        /** Write a set of flat items with one copy per item. */
+        template< class C >
+        DataOStream& _writeSet( const C& value, const std::true_type& );
+        template< class C >
+        DataOStream& _writeSet( const C& value, const std::false_type& );
+
+        /** Write a map of flat keys and values with one copy per item. */
+        template< class C >
+        DataOStream& _writeMap( const C& value, const std::true_type& );
+        template< class C >
+        DataOStream& _writeMap( const C& value, const std::false_type& );
         /** Send the trailing data (command) to the receivers */
         void _sendFooter( const void* buffer, const uint64_t size );
     };
@@ -27,13 +27,31 @@ namespace co
     inline DataOStream& DataOStream::operator << ( const std::string& str )
     {
         const uint64_t nElems = str.length();
-        _write( &nElems, sizeof( nElems ));
+        *this << nElems;
         if ( nElems > 0 )
             _write( str.c_str(), nElems );
 
         return *this;
     }
 
+    /** Write a uint128_t, as two varints if compact. */
+    template<> inline DataOStream&
+    DataOStream::operator << ( const uint128_t& value )
+    {
+        if( _compact )
+            return *this << value.high() << value.low();
+        _write( &value, sizeof( value ));
+        return *this;
+    }
+
+    /** Write an object version, the identifier is never compacted. */
+    template<> inline DataOStream&
+    DataOStream::operator << ( const ObjectVersion& value )
+    {
+        _write( &value.identifier, sizeof( value.identifier ));
+        return *this << value.version;
+    }
+
     /** Write an object identifier and version. */
     template<> inline DataOStream&
     DataOStream::operator << ( const Object* const& object )
@@ -53,6 +71,41 @@ namespace co
 
     template< class T > inline DataOStream&
     DataOStream::operator << ( const std::vector< T >& value )
+    {
+        return _writeVector( value, IsFlat< T >( ));
+    }
+
+    template< class K, class V > inline DataOStream&
+    DataOStream::operator << ( const std::map< K, V >& value )
+    {
+        typedef std::integral_constant< bool, IsFlat< K >::value &&
+                                              IsFlat< V >::value > Flat;
+        return _writeMap( value, Flat( ));
+    }
+
+    template< class T > inline DataOStream&
+    DataOStream::operator << ( const std::set< T >& value )
+    {
+        return _writeSet( value, IsFlat< T >( ));
+    }
+
+    template< class K, class V > inline DataOStream&
+    DataOStream::operator << ( const stde::hash_map< K, V >& value )
+    {
+        typedef std::integral_constant< bool, IsFlat< K >::value &&
+                                              IsFlat< V >::value > Flat;
+        return _writeMap( value, Flat( ));
+    }
+
+    template< class T > inline DataOStream&
+    DataOStream::operator << ( const stde::hash_set< T >& value )
+    {
+        return _writeSet( value, IsFlat< T >( ));
+    }
+
+    template< class T > inline DataOStream&
+    DataOStream::_writeVector( const std::vector< T >& value,
+                               const std::false_type& )
     {
         const uint64_t nElems = value.size();
         *this << nElems;
@@ -61,54 +114,69 @@ namespace co
         return *this;
     }
 
-    template< class K, class V > inline DataOStream&
-    DataOStream::operator << ( const std::map< K, V >& value )
+    template< class C > inline DataOStream&
+    DataOStream::_writeSet( const C& value, const std::true_type& )
     {
+        typedef typename C::value_type T;
         const uint64_t nElems = value.size();
         *this << nElems;
-        for( typename std::map< K, V >::const_iterator it = value.begin();
-             it != value.end(); ++it )
+        if( nElems == 0 )
+            return *this;
+
+        uint8_t* data = _reserve( nElems * sizeof( T ));
+        for( typename C::const_iterator it = value.begin(); it != value.end();
+             ++it, data += sizeof( T ))
         {
-            *this << it->first << it->second;
+            ::memcpy( data, &*it, sizeof( T ));
         }
         return *this;
     }
 
-    template< class T > inline DataOStream&
-    DataOStream::operator << ( const std::set< T >& value )
+    template< class C > inline DataOStream&
+    DataOStream::_writeSet( const C& value, const std::false_type& )
     {
         const uint64_t nElems = value.size();
         *this << nElems;
-        for( typename std::set< T >::const_iterator it = value.begin();
-             it != value.end(); ++it )
+        for( typename C::const_iterator it = value.begin(); it != value.end();
+             ++it )
         {
             *this << *it;
         }
         return *this;
     }
 
-    template< class K, class V > inline DataOStream&
-    DataOStream::operator << ( const stde::hash_map< K, V >& value )
+    template< class C > inline DataOStream&
+    DataOStream::_writeMap( const C& value, const std::true_type& )
     {
+        typedef typename C::key_type K;
+        typedef typename C::mapped_type V;
         const uint64_t nElems = value.size();
         *this << nElems;
-        for( typename stde::hash_map< K, V >::const_iterator it = value.begin();
-             it != value.end(); ++it )
+        if( nElems == 0 )
+            return *this;
+
+        // same layout as streaming each key and value
+        uint8_t* data = _reserve( nElems * ( sizeof( K ) + sizeof( V )));
+        for( typename C::const_iterator it = value.begin(); it != value.end();
+             ++it )
         {
-            *this << it->first << it->second;
+            ::memcpy( data, &it->first, sizeof( K ));
+            data += sizeof( K );
+            ::memcpy( data, &it->second, sizeof( V ));
+            data += sizeof( V );
         }
         return *this;
     }
 
-    template< class T > inline DataOStream&
-    DataOStream::operator << ( const stde::hash_set< T >& value )
+    template< class C > inline DataOStream&
+    DataOStream::_writeMap( const C& value, const std::false_type& )
     {
         const uint64_t nElems = value.size();
         *this << nElems;
-        for( typename stde::hash_set< T >::const_iterator it = value.begin();
-             it != value.end(); ++it )
+        for( typename C::const_iterator it = value.begin(); it != value.end();
+             ++it )
         {
-            *this << *it;
+            *this << it->first << it->second;
         }
         return *this;
     }
@@ -178,6 +246,10 @@ namespace co
     /** Optimized specialization to write a std::vector of ObjectVersion. */
     template<> inline DataOStream&
     DataOStream::operator << ( const std::vector< ObjectVersion >& value )
-    { return _writeFlatVector( value ); }
+    {
+        if( _compact )
+            return _writeVector( value, std::false_type( ));
+        return _writeFlatVector( value );
+    }
     //@}
 }
@@ -37,11 +37,32 @@ namespace co
 DataOStreamArchive::DataOStreamArchive( DataOStream& stream )
     : Super( 0 )
     , _stream( stream )
+    , _native( stream.isNativeArchive( ))
+{
+    _saveHeader();
+}
+
+DataOStreamArchive::DataOStreamArchive( DataOStream& stream,
+                                        const bool native )
+    : Super( 0 )
+    , _stream( stream )
+    , _native( native )
+{
+    _saveHeader();
+}
+
+void DataOStreamArchive::_saveHeader()
 {
     // write our minimalistic header (magic byte plus version)
     // the boost archives write a string instead - by calling
     // boost::archive::basic_binary_oarchive<derived_t>::init()
-    _saveSignedChar( magicByte );
+    if( _native )
+    {
+        _saveSignedChar( nativeMagicByte );
+        _stream << getNativeLayout();
+    }
+    else
+        _saveSignedChar( magicByte );
 
     using namespace boost::archive;
 
@@ -61,6 +82,8 @@ void DataOStreamArchive::save_binary( const void* data, std::size_t size )
 void DataOStreamArchive::save( bool b )
 {
     _saveSignedChar( b );
+    if( _native )
+        return;
     if( b )
         _saveSignedChar( 'T' );
 }
@@ -53,16 +53,47 @@
 namespace co
 {
 
-/** A boost.serialization output archive writing to a co::DataOStream. */
+/**
+ * A boost.serialization output archive writing to a co::DataOStream.
+ *
+ * The archive uses one of two formats, both read by DataIStreamArchive. The
+ * portable format encodes integers with a variable number of bytes and
+ * floating point numbers by their bit pattern, independent of the platform.
+ * The native format copies all primitives raw into the stream, which is
+ * considerably faster. The DataIStream on the receiving side already swaps
+ * the byte order for nodes of different endianness, and long is written with
+ * 64 bits to be independent of the LP64 and LLP64 data models. Native archives
+ * can be read by all nodes running this version which share the size of the
+ * other fundamental types, which is verified when the archive is opened. Older
+ * versions do not read native archives, and the format is therefore only used
+ * if all receivers of the stream announced to read it when connecting.
+ */
 class DataOStreamArchive
     : public boost::archive::basic_binary_oarchive< DataOStreamArchive >
 {
     typedef boost::archive::basic_binary_oarchive< DataOStreamArchive > Super;
 
 public:
-    /** Construct a new serialization archive. @version 1.0 */
+    /**
+     * Construct a new serialization archive.
+     *
+     * Uses the native format if all receiving nodes of the stream read it,
+     * and the portable format otherwise. Streams without receivers, e.g., the
+     * initial instance data of a registered object, are saved in the portable
+     * format, since the data is resent unchanged to nodes mapping it later.
+     * @version 1.0
+     */
     CO_API DataOStreamArchive( DataOStream& stream );
 
+    /**
+     * Construct a new serialization archive in the given format.
+     *
+     * @param stream the output stream.
+     * @param native true for the native, false for the portable format.
+     * @version 1.0
+     */
+    CO_API DataOStreamArchive( DataOStream& stream, const bool native );
+
     /** @internal archives are expected to support this function. */
     CO_API void save_binary( const void* data, std::size_t size );
 
@@ -146,9 +177,17 @@ private:
     CO_API void save( const boost::archive::version_type& version );
 #endif
 
+    /** @return the value written for t in the native format. */
+    template< typename T > static const T& _toNative( const T& t )
+        { return t; }
+    static int64_t _toNative( const long t ) { return t; }
+    static uint64_t _toNative( const unsigned long t ) { return t; }
+
     CO_API void _saveSignedChar( const signed char& c );
+    void _saveHeader();
 
     DataOStream& _stream;
+    const bool _native;
 };
 
 #include "dataOStreamArchive.ipp" // template implementation
@@ -41,6 +41,12 @@ DataOStreamArchive::save( const T& t )
     namespace bs = boost::spirit::detail;
 #endif
 
+    if( _native )
+    {
+        _stream << _toNative( t );
+        return;
+    }
+
     if( T temp = t )
     {
         // examine the number of bytes
@@ -82,6 +88,13 @@ DataOStreamArchive::save( const T& t )
     if( get_flags() & serialization::no_infnan && !fp::isfinite( t ))
         throw DataStreamArchiveException( t );
 
+    if( _native )
+    {
+        BOOST_STATIC_ASSERT( sizeof( T ) <= sizeof( uint64_t ));
+        _stream << t;
+        return;
+    }
+
     // if you end here there are three possibilities:
     // 1. you're serializing a long double which is not portable
     // 2. you're serializing a double but have no 64 bit integer
@@ -20,10 +20,26 @@
 #ifndef CO_DATASTREAMARCHIVE_H
 #define CO_DATASTREAMARCHIVE_H
 
+#include <lunchbox/types.h>
+
 namespace co
 {
 // @internal this value is written to the top of the stream
 const signed char magicByte = 'c' | 'o';
+
+// @internal written instead of magicByte by archives in native format
+const signed char nativeMagicByte = 'C' | 'O';
+
+/**
+ * @internal @return the sizes of the fundamental types whose size depends on
+ *                   the platform, which have to match for native archives.
+ *                   long is always written with 64 bits and not part of it.
+ */
+inline uint32_t getNativeLayout()
+{
+    return uint32_t( sizeof( short ) | sizeof( int ) << 4 |
+                     sizeof( long long ) << 12 | sizeof( wchar_t ) << 16 );
+}
 }
 
 #endif //CO_DATASTREAMARCHIVE_H
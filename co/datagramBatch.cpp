@@ -0,0 +1,468 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "datagramBatch.h"
+
+#include "log.h"
+
+#include <lunchbox/os.h>
+
+#ifdef __linux__
+#  include <netinet/in.h>
+#  include <netinet/udp.h>
+#  include <sys/socket.h>
+#  include <sys/uio.h>
+#  include <errno.h>
+#  include <string.h>
+#  include <vector>
+#endif
+
+namespace co
+{
+#ifdef __linux__
+namespace
+{
+// Maximum number of GSO segments per send (UDP_MAX_SEGMENTS)
+static const size_t _maxSegments = 64;
+// Maximum UDP payload of one GSO super packet over IPv4
+static const size_t _maxGSOBytes = 65507;
+// Receive buffer size when GRO is used, fits any coalesced packet
+static const size_t _groBufferSize = 65535;
+// GRO packets coalesce up to 64 datagrams, so few receive buffers suffice
+static const size_t _maxGROBuffers = 8;
+}
+
+namespace detail
+{
+class DatagramBatch
+{
+public:
+    DatagramBatch( const int readFD_, const int writeFD_, const uint32_t mtu_,
+                   const uint32_t size_ )
+        : readFD( readFD_ )
+        , writeFD( writeFD_ )
+        , mtu( mtu_ )
+        , size( size_ )
+        , gso( false )
+        , gro( false )
+        , nRecvBuffers( 0 )
+        , recvBuffers( 0 )
+        , nReceived( 0 )
+        , current( 0 )
+        , offset( 0 )
+    {
+        sendIOVs.reserve( size );
+
+        // Multicast loopback is disabled, but datagrams sent through the
+        // loopback interface are still received by our own socket.
+        selfLength = sizeof( self );
+        if( ::getsockname( writeFD, reinterpret_cast< sockaddr* >( &self ),
+                           &selfLength ) != 0 || self.ss_family != AF_INET ||
+            ( ntohl( reinterpret_cast< const sockaddr_in& >( self ).
+                     sin_addr.s_addr ) >> 24 ) != 127 )
+        {
+            selfLength = 0; // not on the loopback interface
+        }
+
+#ifdef UDP_SEGMENT
+        // probe for GSO support, it is only worth it for at least two segments
+        const int zero = 0;
+        gso = 2 * mtu <= _maxGSOBytes &&
+              ::setsockopt( writeFD, IPPROTO_UDP, UDP_SEGMENT, &zero,
+                            sizeof( zero )) == 0;
+#endif
+#ifdef UDP_GRO
+        const int one = 1;
+        gro = ::setsockopt( readFD, IPPROTO_UDP, UDP_GRO, &one,
+                            sizeof( one )) == 0;
+#endif
+
+        nRecvBuffers = gro ? LB_MIN( size, _maxGROBuffers ) : size;
+        recvBuffers = new lunchbox::Bufferb[ nRecvBuffers ];
+        for( size_t i = 0; i < nRecvBuffers; ++i )
+            recvBuffers[i].reserve( gro ? _groBufferSize : mtu );
+
+        recvIOVs.resize( nRecvBuffers );
+        recvMsgs.resize( nRecvBuffers );
+        recvAddrs.resize( nRecvBuffers );
+        if( gro )
+            recvControl.resize( nRecvBuffers * CMSG_SPACE( sizeof( int )));
+
+        LBVERB << "Batching " << size << " datagrams, GSO "
+               << ( gso ? "on" : "off" ) << ", GRO " << ( gro ? "on" : "off" )
+               << std::endl;
+    }
+
+    ~DatagramBatch()
+    {
+        delete [] recvBuffers;
+    }
+
+    bool flush()
+    {
+        const size_t n = sendIOVs.size();
+        size_t i = 0;
+        bool ok = true;
+
+        while( gso && i < n )
+        {
+            const size_t nSegments = _getSegments( i );
+            if( !_sendSegments( i, nSegments ))
+            {
+                if( !gso ) // not supported for this route, retry with mmsg
+                    break;
+                ok = false;
+            }
+            i += nSegments;
+        }
+
+        if( i < n )
+        {
+            sendMsgs.resize( n );
+            for( size_t j = i; j < n; ++j )
+            {
+                ::memset( &sendMsgs[j], 0, sizeof( mmsghdr ));
+                sendMsgs[j].msg_hdr.msg_iov = &sendIOVs[j];
+                sendMsgs[j].msg_hdr.msg_iovlen = 1;
+            }
+        }
+
+        while( i < n )
+        {
+            const int sent = ::sendmmsg( writeFD, &sendMsgs[i],
+                                         unsigned( n - i ), 0 );
+            if( sent < 0 )
+            {
+                if( errno == EINTR )
+                    continue;
+                LBWARN << "Error sending " << n - i << " datagrams: "
+                       << lunchbox::sysError << std::endl;
+                ok = false;
+                break;
+            }
+            i += sent;
+        }
+
+        sendIOVs.clear();
+        return ok;
+    }
+
+    size_t read()
+    {
+        const size_t controlSize = gro ? CMSG_SPACE( sizeof( int )) : 0;
+        for( size_t i = 0; i < nRecvBuffers; ++i )
+        {
+            recvIOVs[i].iov_base = recvBuffers[i].getData();
+            recvIOVs[i].iov_len = recvBuffers[i].getMaxSize();
+
+            msghdr& msg = recvMsgs[i].msg_hdr;
+            ::memset( &msg, 0, sizeof( msghdr ));
+            msg.msg_iov = &recvIOVs[i];
+            msg.msg_iovlen = 1;
+            msg.msg_name = &recvAddrs[i];
+            msg.msg_namelen = sizeof( sockaddr_storage );
+            if( gro )
+            {
+                msg.msg_control = &recvControl[ i * controlSize ];
+                msg.msg_controllen = controlSize;
+            }
+        }
+
+        int received = -1;
+        while( received < 0 )
+        {
+            received = ::recvmmsg( readFD, &recvMsgs[0],
+                                   unsigned( nRecvBuffers ), MSG_DONTWAIT, 0 );
+            if( received >= 0 || errno == EINTR )
+                continue;
+
+            if( errno != EAGAIN && errno != EWOULDBLOCK )
+                LBWARN << "Error receiving datagrams: " << lunchbox::sysError
+                       << std::endl;
+            received = 0;
+        }
+
+        nReceived = size_t( received );
+        current = 0;
+        offset = 0;
+        return nReceived;
+    }
+
+    bool next( lunchbox::Bufferb& buffer, size_t& bytes )
+    {
+        while( current < nReceived )
+        {
+            const mmsghdr& msg = recvMsgs[ current ];
+            const size_t length = msg.msg_len;
+
+            if( _isSelf( msg.msg_hdr ))
+            {
+                ++current;
+                continue;
+            }
+
+            if( msg.msg_hdr.msg_flags & MSG_TRUNC )
+            {
+                LBWARN << "Dropping truncated datagram, larger than "
+                       << recvBuffers[ current ].getMaxSize() << " bytes"
+                       << std::endl;
+                ++current;
+                offset = 0;
+                continue;
+            }
+
+            if( !gro )
+            {
+                LBASSERT( buffer.getMaxSize() ==
+                          recvBuffers[ current ].getMaxSize( ));
+                buffer.swap( recvBuffers[ current ] );
+                bytes = length;
+                ++current;
+                return true;
+            }
+
+            if( offset >= length )
+            {
+                ++current;
+                offset = 0;
+                continue;
+            }
+
+            size_t segment = _getGROSize( msg.msg_hdr );
+            if( segment == 0 )
+                segment = length;
+
+            const size_t start = offset;
+            bytes = LB_MIN( segment, length - offset );
+            offset += segment;
+            if( bytes > buffer.getMaxSize( ))
+            {
+                LBWARN << "Dropping " << bytes << " byte datagram larger than "
+                       << "the MTU of " << mtu << " bytes" << std::endl;
+                continue;
+            }
+
+            const uint8_t* data = recvBuffers[ current ].getData() + start;
+            ::memcpy( buffer.getData(), data, bytes );
+            return true;
+        }
+        return false;
+    }
+
+    const int readFD;
+    const int writeFD;
+    const size_t mtu;
+    const size_t size;
+    bool gso;
+    bool gro;
+
+    std::vector< iovec > sendIOVs;
+    std::vector< mmsghdr > sendMsgs;
+
+    size_t nRecvBuffers;
+    lunchbox::Bufferb* recvBuffers;
+    std::vector< iovec > recvIOVs;
+    std::vector< mmsghdr > recvMsgs;
+    std::vector< sockaddr_storage > recvAddrs;
+    std::vector< uint8_t > recvControl;
+
+    size_t nReceived; //!< datagrams returned by the last read()
+    size_t current;   //!< the next datagram returned by next()
+    size_t offset;    //!< the next GRO segment in the current datagram
+
+    sockaddr_storage self; //!< local address of a loopback write socket
+    socklen_t selfLength;
+
+private:
+    /** @return the number of datagrams starting at i for one GSO send. */
+    size_t _getSegments( const size_t i ) const
+    {
+        const size_t segment = sendIOVs[i].iov_len;
+        size_t bytes = segment;
+        size_t nSegments = 1;
+
+        // All segments but the last one need to have the same size
+        for( size_t j = i + 1; j < sendIOVs.size(); ++j )
+        {
+            const size_t length = sendIOVs[j].iov_len;
+            if( length > segment || nSegments == _maxSegments ||
+                bytes + length > _maxGSOBytes )
+            {
+                break;
+            }
+
+            bytes += length;
+            ++nSegments;
+            if( length < segment )
+                break;
+        }
+        return nSegments;
+    }
+
+    bool _sendSegments( const size_t i, const size_t nSegments )
+    {
+        msghdr msg;
+        ::memset( &msg, 0, sizeof( msg ));
+        msg.msg_iov = &sendIOVs[i];
+        msg.msg_iovlen = nSegments;
+
+#ifdef UDP_SEGMENT
+        uint8_t control[ CMSG_SPACE( sizeof( uint16_t )) ];
+        if( nSegments > 1 )
+        {
+            ::memset( control, 0, sizeof( control ));
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof( control );
+
+            cmsghdr* cmsg = CMSG_FIRSTHDR( &msg );
+            cmsg->cmsg_level = IPPROTO_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN( sizeof( uint16_t ));
+            const uint16_t segment = uint16_t( sendIOVs[i].iov_len );
+            ::memcpy( CMSG_DATA( cmsg ), &segment, sizeof( segment ));
+        }
+#endif
+
+        while( ::sendmsg( writeFD, &msg, 0 ) < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+
+            // EIO: no checksum offload, EINVAL: segment exceeds route MTU
+            if( nSegments > 1 && ( errno == EIO || errno == EINVAL ))
+            {
+                LBINFO << "Disabling UDP GSO: " << lunchbox::sysError
+                       << std::endl;
+                gso = false;
+                return false;
+            }
+
+            LBWARN << "Error sending " << nSegments << " datagrams: "
+                   << lunchbox::sysError << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /** @return true if the datagram was sent by our own write socket. */
+    bool _isSelf( const msghdr& msg ) const
+    {
+        if( selfLength == 0 || msg.msg_namelen < sizeof( sockaddr_in ))
+            return false;
+
+        const sockaddr_in& local = reinterpret_cast< const sockaddr_in& >(self);
+        const sockaddr_in& from =
+            *reinterpret_cast< const sockaddr_in* >( msg.msg_name );
+        return from.sin_family == AF_INET && from.sin_port == local.sin_port &&
+               from.sin_addr.s_addr == local.sin_addr.s_addr;
+    }
+
+    static size_t _getGROSize( const msghdr& msg )
+    {
+#ifdef UDP_GRO
+        for( cmsghdr* cmsg = CMSG_FIRSTHDR( &msg ); cmsg;
+             cmsg = CMSG_NXTHDR( const_cast< msghdr* >( &msg ), cmsg ))
+        {
+            if( cmsg->cmsg_level == IPPROTO_UDP &&
+                cmsg->cmsg_type == UDP_GRO )
+            {
+                int segment = 0;
+                ::memcpy( &segment, CMSG_DATA( cmsg ), sizeof( segment ));
+                return size_t( segment );
+            }
+        }
+#endif
+        return 0;
+    }
+};
+}
+
+DatagramBatch::DatagramBatch()
+    : _impl( 0 )
+{}
+
+DatagramBatch::~DatagramBatch()
+{
+    exit();
+}
+
+bool DatagramBatch::init( const int readFD, const int writeFD,
+                          const uint32_t mtu, const uint32_t size )
+{
+    LBASSERT( !_impl );
+    LBASSERT( size > 0 );
+    _impl = new detail::DatagramBatch( readFD, writeFD, mtu, size );
+    return true;
+}
+
+void DatagramBatch::exit()
+{
+    delete _impl;
+    _impl = 0;
+}
+
+bool DatagramBatch::isValid() const
+{
+    return _impl != 0;
+}
+
+bool DatagramBatch::isFull() const
+{
+    return _impl->sendIOVs.size() >= _impl->size;
+}
+
+void DatagramBatch::add( const void* data, const uint32_t size )
+{
+    LBASSERT( !isFull( ));
+    iovec iov;
+    iov.iov_base = const_cast< void* >( data );
+    iov.iov_len = size;
+    _impl->sendIOVs.push_back( iov );
+}
+
+bool DatagramBatch::flush()
+{
+    return _impl->flush();
+}
+
+size_t DatagramBatch::read()
+{
+    return _impl->read();
+}
+
+bool DatagramBatch::next( lunchbox::Bufferb& buffer, size_t& bytes )
+{
+    return _impl->next( buffer, bytes );
+}
+
+#else // !__linux__
+
+DatagramBatch::DatagramBatch() : _impl( 0 ) {}
+DatagramBatch::~DatagramBatch() {}
+bool DatagramBatch::init( const int, const int, const uint32_t,
+                          const uint32_t ) { return false; }
+void DatagramBatch::exit() {}
+bool DatagramBatch::isValid() const { return false; }
+bool DatagramBatch::isFull() const { return true; }
+void DatagramBatch::add( const void*, const uint32_t ) { LBDONTCALL; }
+bool DatagramBatch::flush() { return true; }
+size_t DatagramBatch::read() { return 0; }
+bool DatagramBatch::next( lunchbox::Bufferb&, size_t& ) { return false; }
+
+#endif
+}
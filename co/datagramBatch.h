@@ -0,0 +1,107 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_DATAGRAMBATCH_H
+#define CO_DATAGRAMBATCH_H
+
+#include <lunchbox/buffer.h>
+#include <lunchbox/types.h>
+
+namespace co
+{
+namespace detail { class DatagramBatch; }
+
+    /**
+     * @internal Sends and receives multiple UDP datagrams per system call.
+     *
+     * Uses sendmmsg and recvmmsg on Linux. Where the kernel supports it,
+     * consecutive datagrams of equal size are sent as one UDP GSO super
+     * packet, and received UDP GRO packets are split back into the original
+     * datagrams. On other platforms init() fails and the caller uses its
+     * unbatched code path.
+     *
+     * Not thread safe, the sockets are owned by the caller.
+     */
+    class DatagramBatch
+    {
+    public:
+        DatagramBatch();
+        ~DatagramBatch();
+
+        /**
+         * Set up batching for the given sockets.
+         *
+         * @param readFD the socket to receive from.
+         * @param writeFD the connected socket to send to.
+         * @param mtu the maximum datagram size.
+         * @param size the maximum number of datagrams per system call.
+         * @return true if batching is supported, false otherwise.
+         */
+        bool init( const int readFD, const int writeFD, const uint32_t mtu,
+                   const uint32_t size );
+
+        /** Release all resources. Queued datagrams are discarded. */
+        void exit();
+
+        /** @return true if batching is set up. */
+        bool isValid() const;
+
+        /** @return true if no more datagrams can be queued before flush(). */
+        bool isFull() const;
+
+        /**
+         * Queue a datagram for the next flush().
+         *
+         * The data is not copied and has to stay valid until flush().
+         */
+        void add( const void* data, const uint32_t size );
+
+        /** Send all queued datagrams. @return false on send errors. */
+        bool flush();
+
+        /**
+         * Receive all pending datagrams without blocking.
+         *
+         * @return the number of received datagrams, before GRO splitting.
+         */
+        size_t read();
+
+        /**
+         * Retrieve the next datagram received by read().
+         *
+         * The buffer has to have a maximum size of the mtu. It is swapped with
+         * the receive buffer when possible, otherwise the data is copied.
+         * On the loopback interface, datagrams sent from the write socket
+         * itself are skipped. Datagrams larger than the mtu are dropped with a
+         * warning.
+         *
+         * @param buffer the buffer receiving the datagram.
+         * @param bytes returns the datagram size.
+         * @return false if all received datagrams have been retrieved.
+         */
+        bool next( lunchbox::Bufferb& buffer, size_t& bytes );
+
+    private:
+        detail::DatagramBatch* _impl;
+
+        DatagramBatch( const DatagramBatch& );
+        DatagramBatch& operator = ( const DatagramBatch& );
+    };
+}
+
+#endif //CO_DATAGRAMBATCH_H
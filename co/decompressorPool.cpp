@@ -0,0 +1,271 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "decompressorPool.h"
+
+#include "global.h"
+
+#include <lunchbox/condition.h>
+#include <lunchbox/debug.h>
+#include <lunchbox/decompressor.h>
+#include <lunchbox/plugins/compressor.h>
+#include <lunchbox/thread.h>
+
+#include <algorithm>
+#include <deque>
+
+namespace co
+{
+namespace
+{
+typedef DecompressorPool::Job Job;
+typedef DecompressorPool::JobPtr JobPtr;
+
+void _run( lunchbox::Decompressor& decompressor, Job& job )
+{
+    job.reset( job.size );
+    DecompressorPool::decompress( decompressor, job.data, job.compressor,
+                                  job.nChunks, job.getData(), job.size );
+    job.input = 0; // release the compressed data early
+}
+
+class Pool
+{
+public:
+    Pool() : _stopped( false ) {}
+
+    ~Pool() { exit(); }
+
+    /** Stop all workers, queued jobs are decompressed by finish(). */
+    void exit()
+    {
+        _condition.lock();
+        _stopped = true;
+        _condition.broadcast();
+        _condition.unlock();
+
+        for( std::vector< Worker* >::const_iterator i = _workers.begin();
+             i != _workers.end(); ++i )
+        {
+            if( (*i)->started )
+                (*i)->join();
+            delete *i;
+        }
+
+        _condition.lock();
+        _workers.clear();
+        _stopped = false;
+        _condition.unlock();
+    }
+
+    void push( JobPtr job, const size_t nThreads )
+    {
+        _condition.lock();
+        _startWorkers( nThreads );
+        _jobs.push_back( job );
+        _condition.signal();
+        _condition.unlock();
+    }
+
+    void finish( JobPtr job )
+    {
+        _condition.lock();
+        switch( job->state )
+        {
+        case Job::STATE_QUEUED: // help out
+            _take( job );
+            // no break
+        case Job::STATE_CANCELLED:
+            job->state = Job::STATE_RUNNING;
+            _condition.unlock();
+            {
+                lunchbox::Decompressor decompressor;
+                _run( decompressor, *job );
+            }
+            _condition.lock();
+            job->state = Job::STATE_DONE;
+            break;
+
+        case Job::STATE_RUNNING:
+        case Job::STATE_DONE:
+            break;
+        }
+
+        while( job->state != Job::STATE_DONE )
+            _condition.wait();
+        _condition.unlock();
+    }
+
+    void cancel( JobPtr job )
+    {
+        _condition.lock();
+        if( job->state == Job::STATE_QUEUED )
+        {
+            _take( job );
+            job->state = Job::STATE_CANCELLED;
+        }
+        _condition.unlock();
+    }
+
+private:
+    class Worker : public lunchbox::Thread
+    {
+    public:
+        explicit Worker( Pool& pool )
+            : started( false ), running( false ), _pool( pool ) {}
+
+        void run() override
+        {
+            setName( "DecompressorPool" );
+            _pool._work( *this );
+        }
+
+        bool started;
+        bool running;
+        lunchbox::Decompressor decompressor;
+
+    private:
+        Pool& _pool;
+    };
+
+    lunchbox::Condition _condition;
+    std::deque< JobPtr > _jobs; //!< jobs not yet taken by a thread
+    std::vector< Worker* > _workers;
+    bool _stopped;
+
+    /** Start idle workers, condition locked. */
+    void _startWorkers( const size_t nThreads )
+    {
+        while( _workers.size() < nThreads )
+            _workers.push_back( new Worker( *this ));
+
+        for( size_t i = 0; i < nThreads; ++i )
+        {
+            Worker* worker = _workers[i];
+            if( worker->running )
+                continue;
+            if( worker->started )
+                worker->join();
+            worker->started = true;
+            worker->running = worker->start();
+        }
+    }
+
+    /** Remove a queued job, condition locked. */
+    void _take( JobPtr job )
+    {
+        LBASSERT( job->state == Job::STATE_QUEUED );
+        _jobs.erase( std::find( _jobs.begin(), _jobs.end(), job ));
+    }
+
+    void _work( Worker& worker )
+    {
+        _condition.lock();
+        while( true )
+        {
+            // exit when idle, restarted on demand by _startWorkers()
+            while( _jobs.empty( ))
+            {
+                if( _stopped ||
+                    ( !_condition.timedWait( 1000 ) && _jobs.empty( )))
+                {
+                    worker.running = false;
+                    _condition.unlock();
+                    return;
+                }
+            }
+
+            JobPtr job = _jobs.front();
+            _take( job );
+            job->state = Job::STATE_RUNNING;
+            _condition.unlock();
+
+            _run( worker.decompressor, *job );
+
+            _condition.lock();
+            job->state = Job::STATE_DONE;
+            _condition.broadcast();
+        }
+    }
+};
+
+static Pool _pool;
+}
+
+DecompressorPool::JobPtr DecompressorPool::push( ConstBufferPtr input,
+                                                 const void* data,
+                                                 const uint32_t compressor,
+                                                 const uint32_t nChunks,
+                                                 const uint64_t size )
+{
+    const int32_t nThreads =
+        Global::getIAttribute( Global::IATTR_DECOMPRESSOR_POOL_SIZE );
+    if( nThreads <= 0 )
+        return 0;
+
+    JobPtr job = new Job( input, data, compressor, nChunks, size );
+    _pool.push( job, size_t( nThreads ));
+    return job;
+}
+
+void DecompressorPool::finish( JobPtr job )
+{
+    _pool.finish( job );
+}
+
+void DecompressorPool::cancel( JobPtr job )
+{
+    _pool.cancel( job );
+}
+
+void DecompressorPool::exit()
+{
+    _pool.exit();
+}
+
+void DecompressorPool::decompress( lunchbox::Decompressor& decompressor,
+                                   const void* data, const uint32_t compressor,
+                                   const uint32_t nChunks, void* out,
+                                   const uint64_t size )
+{
+    LBASSERT( compressor > EQ_COMPRESSOR_NONE );
+    decompressor.setup( Global::getPluginRegistry(), compressor );
+    LBASSERT( decompressor.uses( compressor ));
+
+    const uint8_t* src = reinterpret_cast< const uint8_t* >( data );
+    uint64_t outDim[2] = { 0, size };
+    uint64_t* chunkSizes = static_cast< uint64_t* >(
+                                alloca( nChunks * sizeof( uint64_t )));
+    void** chunks = static_cast< void ** >(
+                                alloca( nChunks * sizeof( void* )));
+
+    for( uint32_t i = 0; i < nChunks; ++i )
+    {
+        const uint64_t chunkSize = *reinterpret_cast< const uint64_t* >( src );
+        chunkSizes[ i ] = chunkSize;
+        src += sizeof( uint64_t );
+
+        // The plugin API uses non-const source buffers for in-place operations
+        chunks[ i ] = const_cast< uint8_t* >( src );
+        src += chunkSize;
+    }
+
+    decompressor.decompress( chunks, chunkSizes, nChunks, out, outDim );
+}
+
+}
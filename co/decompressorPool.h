@@ -0,0 +1,98 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_DECOMPRESSORPOOL_H
+#define CO_DECOMPRESSORPOOL_H
+
+#include <co/buffer.h> // base class
+
+namespace lunchbox { class Decompressor; }
+
+namespace co
+{
+    /**
+     * @internal Decompresses object data on background threads.
+     *
+     * ObjectDataIStream queues the data of each compressed command as it
+     * arrives, so that most of it is decompressed by the time the application
+     * reads the stream. Up to Global::IATTR_DECOMPRESSOR_POOL_SIZE threads are
+     * started on demand, and exit when idle or at co::exit().
+     */
+    class DecompressorPool
+    {
+    public:
+        /** The decompression of one command, holding the result. */
+        class Job : public Buffer
+        {
+        public:
+            Job( ConstBufferPtr input_, const void* data_,
+                 const uint32_t compressor_, const uint32_t nChunks_,
+                 const uint64_t size_ )
+                : input( input_ ), data( data_ ), compressor( compressor_ )
+                , nChunks( nChunks_ ), size( size_ ), state( STATE_QUEUED ) {}
+
+            ConstBufferPtr input; //!< holds the compressed data
+            const void* const data;
+            const uint32_t compressor;
+            const uint32_t nChunks;
+            const uint64_t size; //!< decompressed size
+
+            enum State
+            {
+                STATE_QUEUED,    //!< waiting for a worker
+                STATE_CANCELLED, //!< removed from the queue, not started
+                STATE_RUNNING,
+                STATE_DONE
+            };
+            State state;
+
+        private:
+            void notifyFree() override { delete this; }
+        };
+        typedef lunchbox::RefPtr< Job > JobPtr;
+
+        /**
+         * Queue the decompression of the data of one command.
+         *
+         * @return the job, or 0 if background decompression is disabled.
+         */
+        static JobPtr push( ConstBufferPtr input, const void* data,
+                            const uint32_t compressor, const uint32_t nChunks,
+                            const uint64_t size );
+
+        /**
+         * Wait for a job to finish, decompressing it on the calling thread if
+         * no worker has started it yet.
+         */
+        static void finish( JobPtr job );
+
+        /** Remove a job from the queue if no worker has taken it yet. */
+        static void cancel( JobPtr job );
+
+        /** Stop all threads, before the compressor plugins are unloaded. */
+        static void exit();
+
+        /** Decompress the chunks of one command into the given memory. */
+        static void decompress( lunchbox::Decompressor& decompressor,
+                                const void* data, const uint32_t compressor,
+                                const uint32_t nChunks, void* out,
+                                const uint64_t size );
+    };
+}
+
+#endif //CO_DECOMPRESSORPOOL_H
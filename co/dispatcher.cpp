@@ -33,11 +33,24 @@ namespace detail
 class Dispatcher
 {
 public:
-    /** The command handler function table. */
-    std::vector< co::Dispatcher::Func > fTable;
-
-    /** Defines a queue to which commands are dispatched from the recv. */
-    std::vector< co::CommandQueue* > qTable;
+    /** The handler, queue and scheduling of one command. */
+    struct Entry
+    {
+        Entry( const co::Dispatcher::Func& func_, co::CommandQueue* queue_,
+               const CommandPriority priority_, const uint32_t deadline_,
+               const co::Dispatcher::Handler handler_ )
+            : func( func_ ), handler( handler_ ), queue( queue_ )
+            , priority( priority_ ), deadline( deadline_ ) {}
+
+        co::Dispatcher::Func func; //!< The command handler function
+        co::Dispatcher::Handler handler; //!< Compile-time bound func, or 0
+        co::CommandQueue* queue; //!< The queue commands are dispatched to
+        CommandPriority priority; //!< The queue scheduling class
+        uint32_t deadline; //!< The maximum queueing time in ms, or 0
+    };
+
+    /** The flat command table, indexed by command. */
+    std::vector< Entry > table;
 };
 }
 
@@ -58,28 +71,28 @@ Dispatcher::~Dispatcher()
 // command handling
 //===========================================================================
 void Dispatcher::_registerCommand( const uint32_t command, const Func& func,
-                                   CommandQueue* destinationQueue )
+                                   CommandQueue* destinationQueue,
+                                   const CommandPriority priority,
+                                   const uint32_t deadline,
+                                   const Handler handler )
 {
-    LBASSERT( _impl->fTable.size() == _impl->qTable.size( ));
+    LBASSERT( priority < COMMANDPRIORITY_ALL );
 
-    if( _impl->fTable.size() <= command )
+    const detail::Dispatcher::Entry entry( func, destinationQueue, priority,
+                                           deadline, handler );
+    if( _impl->table.size() <= command )
     {
-        while( _impl->fTable.size() < command )
-        {
-            _impl->fTable.push_back( Func( this, &Dispatcher::_cmdUnknown ));
-            _impl->qTable.push_back( 0 );
-        }
-
-        _impl->fTable.push_back( func );
-        _impl->qTable.push_back( destinationQueue );
-
-        LBASSERT( _impl->fTable.size() == command + 1 );
+        const detail::Dispatcher::Entry unknown(
+            Func( this, &Dispatcher::_cmdUnknown ), 0, COMMANDPRIORITY_NORMAL,
+            0, 0 );
+        _impl->table.reserve( command + 1 );
+        _impl->table.resize( command, unknown );
+        _impl->table.push_back( entry );
+
+        LBASSERT( _impl->table.size() == command + 1 );
     }
     else
-    {
-        _impl->fTable[command] = func;
-        _impl->qTable[command] = destinationQueue;
-    }
+        _impl->table[command] = entry;
 }
 
 
@@ -92,26 +105,34 @@ bool Dispatcher::dispatchCommand( ICommand& command )
 
     const uint32_t which = command.getCommand();
 #ifndef NDEBUG
-    if( which >= _impl->qTable.size( ))
+    if( which >= _impl->table.size( ))
     {
         LBABORT( "ICommand " << command
                  << " higher than number of registered command handlers ("
-                 << _impl->qTable.size() << ") for object of type "
+                 << _impl->table.size() << ") for object of type "
                  << lunchbox::className( this ) << std::endl );
         return false;
     }
 #endif
 
-    CommandQueue* queue = _impl->qTable[ which ];
-    if( queue )
+    detail::Dispatcher::Entry& entry = _impl->table[ which ];
+    if( entry.queue )
     {
-        command.setDispatchFunction( _impl->fTable[ which ] );
-        queue->push( command );
+        command.setDispatchFunction( entry.func );
+        command.setPriority( entry.priority, entry.deadline );
+        entry.queue->push( command );
         return true;
     }
     // else
 
-    LBCHECK( _impl->fTable[ which ]( command ));
+    if( entry.handler )
+    {
+        LBCHECK( entry.handler( entry.func._object, command ));
+    }
+    else
+    {
+        LBCHECK( entry.func( command ));
+    }
     return true;
 }
 
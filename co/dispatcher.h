@@ -23,6 +23,7 @@
 
 #include <co/api.h>
 #include <co/commandFunc.h> // used inline
+#include <co/commands.h>    // CommandPriority default parameter
 #include <co/types.h>
 
 namespace co
@@ -41,6 +42,12 @@ namespace detail { class Dispatcher; }
         /** The signature of the base Dispatcher callback. @version 1.0 */
         typedef CommandFunc< Dispatcher > Func;
 
+        /**
+         * @internal A command handler bound at compile time, called with the
+         * object of the registered Func.
+         */
+        typedef bool ( *Handler )( Dispatcher*, ICommand& );
+
         /** @internal NOP assignment operator. */
         const Dispatcher& operator = ( const Dispatcher& ) { return *this; }
 
@@ -51,14 +58,81 @@ namespace detail { class Dispatcher; }
          * directly upon dispatch, otherwise it is pushed to the given queue and
          * invoked during the processing of the command queue.
          *
+         * Queued commands are consumed in the order of their priority. A
+         * command waiting longer than its deadline, or by default longer than
+         * Global::IATTR_COMMAND_QUEUE_MAX_AGE, is promoted to the highest
+         * priority to prevent starvation.
+         *
          * @param command the command.
          * @param func the functor to handle the command.
          * @param queue the queue to which the the command is dispatched
+         * @param priority the scheduling class of the queued command.
+         * @param deadline the maximum time in ms the command may wait in the
+         *                 queue before it is promoted, 0 for the default.
          * @version 1.0
          */
         template< typename T > void
         registerCommand( const uint32_t command, const CommandFunc< T >& func,
-                         CommandQueue* queue );
+                         CommandQueue* queue,
+                         const CommandPriority priority =
+                             COMMANDPRIORITY_NORMAL,
+                         const uint32_t deadline = 0 );
+
+        /**
+         * Register a command member function of this dispatcher for a command.
+         *
+         * Convenience overload binding the given member function of the
+         * derived class T directly to this instance, e.g.
+         * registerCommand( CMD_FOO, &Foo::_cmdFoo, queue ).
+         *
+         * @sa registerCommand( const uint32_t, const CommandFunc< T >&,
+         *                      CommandQueue*, const CommandPriority,
+         *                      const uint32_t )
+         * @version 1.1
+         */
+        template< typename T > void
+        registerCommand( const uint32_t command,
+                         bool ( T::*func )( ICommand& ), CommandQueue* queue,
+                         const CommandPriority priority =
+                             COMMANDPRIORITY_NORMAL,
+                         const uint32_t deadline = 0 );
+
+        /**
+         * Register a command member function bound at compile time.
+         *
+         * The member function of the derived class T is a template argument,
+         * e.g. registerCommand< Foo, &Foo::_cmdFoo >( CMD_FOO, queue ). Direct
+         * dispatches call it through a static function of the table, in which
+         * the member function call is resolved and inlined by the compiler.
+         *
+         * @sa registerCommand( const uint32_t, const CommandFunc< T >&,
+         *                      CommandQueue*, const CommandPriority,
+         *                      const uint32_t )
+         * @version 1.1
+         */
+        template< typename T, bool ( T::*func )( ICommand& ) > void
+        registerCommand( const uint32_t command, CommandQueue* queue,
+                         const CommandPriority priority =
+                             COMMANDPRIORITY_NORMAL,
+                         const uint32_t deadline = 0 );
+
+        /**
+         * Register a command member function of another object bound at
+         * compile time.
+         *
+         * Used by helpers dispatching their commands through this dispatcher,
+         * e.g. registerCommand< Bar, &Bar::_cmdBar >( CMD_BAR, bar, queue ).
+         *
+         * @sa registerCommand( const uint32_t, CommandQueue*,
+         *                      const CommandPriority, const uint32_t )
+         * @version 1.1
+         */
+        template< typename T, bool ( T::*func )( ICommand& ) > void
+        registerCommand( const uint32_t command, T* object,
+                         CommandQueue* queue,
+                         const CommandPriority priority =
+                             COMMANDPRIORITY_NORMAL,
+                         const uint32_t deadline = 0 );
 
         /**
          * Dispatch a command from the receiver thread to the registered queue.
@@ -86,16 +160,65 @@ namespace detail { class Dispatcher; }
     private:
         detail::Dispatcher* const _impl;
 
+        template< typename T, bool ( T::*func )( ICommand& ) >
+        static bool _invoke( Dispatcher* object, ICommand& command )
+        {
+#ifdef _MSC_VER // mirrors CommandFunc::_convertThis
+            return ( reinterpret_cast< T* >( object )->*func )( command );
+#else
+            return ( static_cast< T* >( object )->*func )( command );
+#endif
+        }
+
         CO_API void _registerCommand( const uint32_t command,
-                                      const Func& func, CommandQueue* queue );
+                                      const Func& func, CommandQueue* queue,
+                                      const CommandPriority priority,
+                                      const uint32_t deadline,
+                                      const Handler handler = 0 );
     };
 
     template< typename T >
     void Dispatcher::registerCommand( const uint32_t command,
                                       const CommandFunc< T >& func,
-                                      CommandQueue* queue )
+                                      CommandQueue* queue,
+                                      const CommandPriority priority,
+                                      const uint32_t deadline )
+    {
+        _registerCommand( command, Dispatcher::Func( func ), queue, priority,
+                          deadline );
+    }
+
+    template< typename T >
+    void Dispatcher::registerCommand( const uint32_t command,
+                                      bool ( T::*func )( ICommand& ),
+                                      CommandQueue* queue,
+                                      const CommandPriority priority,
+                                      const uint32_t deadline )
+    {
+        registerCommand( command, CommandFunc< T >( static_cast< T* >( this ),
+                                                    func ),
+                         queue, priority, deadline );
+    }
+
+    template< typename T, bool ( T::*func )( ICommand& ) >
+    void Dispatcher::registerCommand( const uint32_t command,
+                                      CommandQueue* queue,
+                                      const CommandPriority priority,
+                                      const uint32_t deadline )
+    {
+        registerCommand< T, func >( command, static_cast< T* >( this ), queue,
+                                    priority, deadline );
+    }
+
+    template< typename T, bool ( T::*func )( ICommand& ) >
+    void Dispatcher::registerCommand( const uint32_t command, T* object,
+                                      CommandQueue* queue,
+                                      const CommandPriority priority,
+                                      const uint32_t deadline )
     {
-        _registerCommand( command, Dispatcher::Func( func ), queue );
+        _registerCommand( command,
+                          Dispatcher::Func( CommandFunc< T >( object, func )),
+                          queue, priority, deadline, &_invoke< T, func > );
     }
 }
 #endif // CO_DISPATCHER_H
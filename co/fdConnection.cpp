@@ -27,17 +27,147 @@
 #include "log.h"
 
 #include <lunchbox/os.h>
+#include <lunchbox/scopedMutex.h>
+
+#ifdef CO_USE_URING
+#  include "uring.h"
+#  include <lunchbox/atomic.h>
+#  include <linux/io_uring.h>
+#endif
 
 #include <errno.h>
 #include <poll.h>
 
 namespace co
 {
+namespace
+{
+#ifdef CO_USE_URING
+enum URingRequest
+{
+    URING_CANCEL, // see URing::prepareCancel
+    URING_READ,
+    URING_WRITE
+};
+
+lunchbox::a_int32_t _uringAvailable( 1 ); // set up concurrently by connects
+
+/** Cancel the given request and wait until the kernel releases its buffer. */
+void _cancel( URing* ring, const uint64_t request )
+{
+    if( ring->getPending() == 0 || !ring->prepareCancel( request ) ||
+        !ring->submit( ))
+    {
+        return;
+    }
+
+    uint64_t userData = URING_CANCEL;
+    int32_t result = 0;
+    while( ring->getPending() > 0 && ring->reap( userData, result, 1000 ) > 0 )
+        /* nop */;
+}
+#endif
+}
+
 FDConnection::FDConnection()
         : _readFD( 0 ),
-          _writeFD( 0 )
+          _writeFD( 0 ),
+          _readRing( 0 ),
+          _writeRing( 0 ),
+          _writeRingBusy( false )
 {}
 
+FDConnection::~FDConnection()
+{
+    _exitURing();
+}
+
+Connection::Notifier FDConnection::getNotifier() const
+{
+#ifdef CO_USE_URING
+    if( _readRing )
+        return _readRing->getFD();
+#endif
+    return _readFD;
+}
+
+void FDConnection::_initURing()
+{
+#ifdef CO_USE_URING
+    LBASSERT( !_readRing && !_writeRing );
+    const int32_t depth =
+        Global::getIAttribute( Global::IATTR_URING_QUEUE_DEPTH );
+    const int32_t idle =
+        Global::getIAttribute( Global::IATTR_URING_SQ_POLL_IDLE );
+    // without submission polling, each request needs a system call anyway
+    if( depth <= 0 || idle <= 0 || _uringAvailable == 0 )
+        return;
+
+    URing* readRing = new URing;
+    URing* writeRing = new URing;
+    if( readRing->init( depth, idle ) && writeRing->init( depth, idle ))
+    {
+        _readRing = readRing;
+        lunchbox::ScopedMutex<> mutex( _writeRingLock );
+        _writeRing = writeRing;
+        return;
+    }
+
+    LBINFO << "io_uring setup failed, falling back to plain IO" << std::endl;
+    _uringAvailable = 0;
+    delete readRing;
+    delete writeRing;
+#endif
+}
+
+void FDConnection::_exitURing()
+{
+#ifdef CO_USE_URING
+    if( _readRing )
+        _cancel( _readRing, URING_READ );
+    delete _readRing;
+    _readRing = 0;
+
+    URing* writeRing = 0;
+    {
+        lunchbox::ScopedMutex<> mutex( _writeRingLock );
+        if( !_writeRingBusy ) // otherwise the writer releases it
+            writeRing = _writeRing;
+        _writeRing = 0;
+    }
+    if( writeRing )
+        _cancel( writeRing, URING_WRITE );
+    delete writeRing;
+#endif
+}
+
+#ifdef CO_USE_URING
+URing* FDConnection::_acquireWriteRing()
+{
+    lunchbox::ScopedMutex<> mutex( _writeRingLock );
+    if( !_writeRing )
+        return 0;
+
+    LBASSERT( !_writeRingBusy );
+    _writeRingBusy = true;
+    return _writeRing;
+}
+
+void FDConnection::_releaseWriteRing( URing* ring )
+{
+    {
+        lunchbox::ScopedMutex<> mutex( _writeRingLock );
+        _writeRingBusy = false;
+        if( ring == _writeRing )
+            return;
+    }
+
+    // the ring was torn down while writing
+    _cancel( ring, URING_WRITE );
+    delete ring;
+}
+#endif
+
 int FDConnection::_getTimeOut()
 {
     const uint32_t timeout = Global::getTimeout();
@@ -47,11 +177,38 @@ int FDConnection::_getTimeOut()
 //----------------------------------------------------------------------
 // read
 //----------------------------------------------------------------------
-int64_t FDConnection::readSync( void* buffer, const uint64_t bytes, const bool )
+void FDConnection::readNB( void* buffer, const uint64_t bytes )
+{
+#ifdef CO_USE_URING
+    // Completions are signaled on the ring, which is the notifier
+    if( !_readRing )
+        return;
+
+    LBASSERT( _readRing->getPending() == 0 );
+    if( !_readRing->prepare( IORING_OP_READ, _readFD, buffer, bytes,
+                             URING_READ ) || !_readRing->submit( ))
+    {
+        LBWARN << "Can't submit read on fd " << _readFD << std::endl;
+    }
+#else
+    (void)buffer;
+    (void)bytes;
+#endif
+}
+
+int64_t FDConnection::readSync( void* buffer, const uint64_t bytes,
+                                const bool block )
 {
     if( _readFD < 1 )
         return -1;
 
+#ifdef CO_USE_URING
+    if( _readRing && _readRing->getPending() > 0 )
+        return _readURing( buffer, bytes, block );
+#else
+    (void)block;
+#endif
+
     ssize_t bytesRead = ::read( _readFD, buffer, bytes );
     if( bytesRead > 0 )
         return bytesRead;
@@ -106,6 +263,26 @@ int64_t FDConnection::write( const void* buffer, const uint64_t bytes )
     if( !isConnected() || _writeFD < 1 )
         return -1;
 
+#ifdef CO_USE_URING
+    // Don't hold the lock while waiting, so closing doesn't block on writes
+    URing* ring = _acquireWriteRing();
+    if( ring )
+    {
+        int64_t result = -1;
+        try
+        {
+            result = _writeURing( ring, buffer, bytes );
+        }
+        catch( ... )
+        {
+            _releaseWriteRing( ring );
+            throw;
+        }
+        _releaseWriteRing( ring );
+        return result;
+    }
+#endif
+
     ssize_t bytesWritten = ::write( _writeFD, buffer, bytes );
     if( bytesWritten > 0 )
         return bytesWritten;
@@ -142,5 +319,94 @@ int64_t FDConnection::write( const void* buffer, const uint64_t bytes )
 
     return bytesWritten;
 }
+
+//----------------------------------------------------------------------
+// io_uring
+//----------------------------------------------------------------------
+#ifdef CO_USE_URING
+int64_t FDConnection::_readURing( void* buffer, const uint64_t bytes,
+                                  const bool block )
+{
+    while( true )
+    {
+        uint64_t request = URING_CANCEL;
+        int32_t result = 0;
+        const int reaped = _readRing->reap( request, result,
+                                            block ? _getTimeOut() : 0 );
+        if( reaped == 0 )
+        {
+            if( !block ) // read still pending, see Connection::recvSync
+                return READ_TIMEOUT;
+
+            _cancel( _readRing, URING_READ );
+            throw Exception( Exception::TIMEOUT_READ );
+        }
+        if( reaped < 0 )
+            return -1;
+        if( request != URING_READ )
+            continue;
+
+        if( result > 0 )
+            return result;
+
+        if( result == 0 ) // EOF
+        {
+            LBINFO << "Got EOF, closing " << getDescription()->toString()
+                   << std::endl;
+            close();
+            return -1;
+        }
+
+        if( result == -EINTR || result == -EAGAIN ) // try again
+        {
+            if( _readRing->prepare( IORING_OP_READ, _readFD, buffer, bytes,
+                                    URING_READ ) && _readRing->submit( ))
+            {
+                continue;
+            }
+            return -1;
+        }
+
+        LBWARN << "Error during read: " << strerror( -result ) << ", "
+               << bytes << "b on fd " << _readFD << std::endl;
+        return -1;
+    }
+}
+
+int64_t FDConnection::_writeURing( URing* ring, const void* buffer,
+                                   const uint64_t bytes )
+{
+    if( !ring->prepare( IORING_OP_WRITE, _writeFD, buffer, bytes,
+                        URING_WRITE ))
+    {
+        return -1;
+    }
+
+    while( true )
+    {
+        uint64_t request = URING_CANCEL;
+        int32_t result = 0;
+        const int reaped = ring->reap( request, result, _getTimeOut( ));
+        if( reaped == 0 )
+        {
+            _cancel( ring, URING_WRITE );
+            throw Exception( Exception::TIMEOUT_WRITE );
+        }
+        if( reaped < 0 )
+            return -1;
+        if( request != URING_WRITE )
+            continue;
+
+        if( result >= 0 )
+            return result;
+
+        if( result == -EINTR || result == -EAGAIN ) // if interrupted, try again
+            return 0;
+
+        LBWARN << "Error during write: " << strerror( -result ) << std::endl;
+        return -1;
+    }
+}
+#endif
 }
 #endif
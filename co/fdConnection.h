@@ -22,8 +22,12 @@
 
 #include <co/connection.h>
 
+#include <lunchbox/lock.h> // member
+
 namespace co
 {
+    class URing;
+
 #ifdef _WIN32
 #  error FDConnection not used nor supported on Windows
 #endif
@@ -32,18 +36,30 @@ namespace co
     class FDConnection : public Connection
     {
     public:
-        virtual Notifier getNotifier() const { return _readFD; }
+        virtual Notifier getNotifier() const;
 
     protected:
         FDConnection();
-        virtual ~FDConnection() {}
+        virtual ~FDConnection();
 
-        void readNB( void*, const uint64_t ) override { /* NOP */ }
+        void readNB( void* buffer, const uint64_t bytes ) override;
         int64_t readSync( void* buffer, const uint64_t bytes,
-                                  const bool ignored ) override;
+                                  const bool block ) override;
         int64_t write( const void* buffer,
                                const uint64_t bytes ) override;
 
+        /**
+         * Set up io_uring-based IO once both file descriptors are valid.
+         *
+         * Does nothing unless Global::IATTR_URING_QUEUE_DEPTH and
+         * Global::IATTR_URING_SQ_POLL_IDLE are set, and falls back to plain
+         * reads and writes if the kernel lacks io_uring submission polling.
+         */
+        void _initURing();
+
+        /** Cancel outstanding io_uring IO, to be called before closing. */
+        void _exitURing();
+
         int   _readFD;     //!< The read file descriptor.
         int   _writeFD;    //!< The write file descriptor.
 
@@ -51,8 +67,18 @@ namespace co
                                                const FDConnection* connection );
 
     private:
-        int _getTimeOut();
+        URing* _readRing;
+        URing* _writeRing;
+        bool _writeRingBusy; //!< a write uses _writeRing, which it releases
+        lunchbox::Lock _writeRingLock; //!< protects the write ring state
 
+        int _getTimeOut();
+        int64_t _readURing( void* buffer, const uint64_t bytes,
+                            const bool block );
+        URing* _acquireWriteRing();
+        void _releaseWriteRing( URing* ring );
+        int64_t _writeURing( URing* ring, const void* buffer,
+                             const uint64_t bytes );
     };
 
     inline std::ostream& operator << ( std::ostream& os,
@@ -6,6 +6,7 @@
 set(CO_PUBLIC_HEADERS
   api.h
   array.h
+  arrayView.h
   barrier.h
   buffer.h
   bufferConnection.h
@@ -61,13 +62,18 @@ set(CO_PUBLIC_HEADERS
 set(CO_HEADERS
   barrierCommand.h
   bufferCache.h
+  byteSwap.h
+  chunkStore.h
   connectionListener.h
   dataStreamArchive.h
   dataIStreamQueue.h
+  decompressorPool.h
   deltaMasterCM.h
   eventConnection.h
+  flatHash.h
   fullMasterCM.h
   instanceCache.h
+  leftRight.h
   masterCMCommand.h
   nodeCommand.h
   nullCM.h
@@ -82,11 +88,14 @@ set(CO_HEADERS
   objectStore.h
   pipeConnection.h
   queueCommand.h
+  relayConnection.h
   rspConnection.h
+  rspRateControl.h
   socketConnection.h
   staticMasterCM.h
   staticSlaveCM.h
   unbufferedMasterCM.h
+  varint.h
   versionedMasterCM.h
   versionedSlaveCM.h
   )
@@ -96,6 +105,8 @@ set(CO_SOURCES
   buffer.cpp
   bufferCache.cpp
   bufferConnection.cpp
+  byteSwap.cpp
+  chunkStore.cpp
   commandQueue.cpp
   connection.cpp
   connectionDescription.cpp
@@ -105,6 +116,7 @@ set(CO_SOURCES
   dataIStream.cpp
   dataIStreamQueue.cpp
   dataOStream.cpp
+  decompressorPool.cpp
   deltaMasterCM.cpp
   dispatcher.cpp
   eventConnection.cpp
@@ -136,11 +148,13 @@ set(CO_SOURCES
   queueItem.cpp
   queueMaster.cpp
   queueSlave.cpp
+  relayConnection.cpp
   sendToken.cpp
   serializable.cpp
   socketConnection.cpp
   staticSlaveCM.cpp
   unbufferedMasterCM.cpp
+  varint.cpp
   version.cpp
   versionedMasterCM.cpp
   versionedSlaveCM.cpp
@@ -0,0 +1,379 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_FLATHASH_H
+#define CO_FLATHASH_H
+
+#include <co/types.h>
+
+#include <string.h>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#  define CO_FLATHASH_SSE2
+#  include <emmintrin.h>
+#endif
+
+namespace co
+{
+    /** @internal @return the unmixed hash of a FlatHash key. */
+    inline uint64_t flatHashKey( const uint128_t& key )
+        { return key.low() ^ ( key.high() * 0x9e3779b97f4a7c15ull ); }
+
+    /** @internal @return the unmixed hash of a FlatHash key. */
+    template< class T >
+    inline uint64_t flatHashKey( const lunchbox::RefPtr< T >& key )
+        { return uint64_t( reinterpret_cast< uintptr_t >( key.get( ))); }
+
+    /**
+     * @internal A flat, open-addressing hash table.
+     *
+     * All items are stored in one array, with one control byte per slot in a
+     * separate array. A control byte is either empty, deleted, or holds seven
+     * bits of the hash of the key in its slot. A lookup compares the control
+     * bytes of a group of slots at once, using SSE2 if available, and only
+     * compares the keys of slots with a matching hash. Groups are probed
+     * quadratically until a group with an empty slot is found. Most lookups
+     * touch one control group and one slot, instead of following the node
+     * pointers of a stde::hash_map.
+     *
+     * Keys are uint128_t or lunchbox::RefPtr, see flatHashKey(). Implements
+     * the subset of the std::map interface used by Collage.
+     *
+     * Inserting a new key may move all items, which invalidates all
+     * iterators and references. Erasing does not move other items. Use
+     * pointers as values if references have to stay valid.
+     */
+    template< class K, class V > class FlatHash
+    {
+    public:
+        typedef K key_type;
+        typedef V mapped_type;
+        typedef std::pair< K, V > value_type;
+
+        /** Iterates over the full slots. */
+        template< bool isConst > class Iterator
+        {
+            typedef typename std::conditional< isConst, const FlatHash,
+                                               FlatHash >::type Hash;
+            typedef typename std::conditional< isConst, const value_type,
+                                               value_type >::type Value;
+        public:
+            Iterator() : _hash( 0 ), _index( 0 ) {}
+            Iterator( const Iterator< false >& from )
+                : _hash( from._hash ), _index( from._index ) {}
+
+            Value& operator * () const { return _hash->_slots[ _index ]; }
+            Value* operator -> () const { return &_hash->_slots[ _index ]; }
+
+            Iterator& operator ++ () { ++_index; _skip(); return *this; }
+
+            bool operator == ( const Iterator& rhs ) const
+                { return _index == rhs._index; }
+            bool operator != ( const Iterator& rhs ) const
+                { return _index != rhs._index; }
+
+        private:
+            Hash* _hash;
+            size_t _index;
+
+            friend class FlatHash;
+            template< bool > friend class Iterator;
+
+            Iterator( Hash* hash, const size_t index )
+                : _hash( hash ), _index( index ) { _skip(); }
+
+            void _skip()
+            {
+                while( _index < _hash->_ctrl.size() &&
+                       !_isFull( _hash->_ctrl[ _index ] ))
+                {
+                    ++_index;
+                }
+            }
+        };
+        typedef Iterator< false > iterator;
+        typedef Iterator< true > const_iterator;
+
+        FlatHash() : _size( 0 ), _growthLeft( 0 ) {}
+
+        bool empty() const { return _size == 0; }
+        size_t size() const { return _size; }
+
+        iterator begin() { return iterator( this, 0 ); }
+        iterator end() { return iterator( this, _slots.size( )); }
+        const_iterator begin() const { return const_iterator( this, 0 ); }
+        const_iterator end() const
+            { return const_iterator( this, _slots.size( )); }
+
+        iterator find( const K& key )
+            { return iterator( this, _find( key, _hash( key ))); }
+        const_iterator find( const K& key ) const
+            { return const_iterator( this, _find( key, _hash( key ))); }
+
+        /** @return the value of the key, inserting a default value if new. */
+        V& operator [] ( const K& key )
+        {
+            const uint64_t hash = _hash( key );
+            size_t index = _find( key, hash );
+            if( index == _slots.size( ))
+                index = _insert( key, hash );
+            return _slots[ index ].second;
+        }
+
+        /** Erase the item at the given position. */
+        void erase( const iterator& i ) { _erase( i._index ); }
+
+        /** Erase the item with the given key. @return the number erased. */
+        size_t erase( const K& key )
+        {
+            const size_t index = _find( key, _hash( key ));
+            if( index == _slots.size( ))
+                return 0;
+            _erase( index );
+            return 1;
+        }
+
+        /** Remove all items and release the memory. */
+        void clear()
+        {
+            std::vector< value_type >().swap( _slots );
+            std::vector< int8_t >().swap( _ctrl );
+            _size = 0;
+            _growthLeft = 0;
+        }
+
+    private:
+        enum
+        {
+#ifdef CO_FLATHASH_SSE2
+            GROUP_SIZE = 16,
+#else
+            GROUP_SIZE = 8,
+#endif
+            CTRL_EMPTY = -128,
+            CTRL_DELETED = -2
+        };
+
+        std::vector< value_type > _slots;
+        std::vector< int8_t > _ctrl; // one control byte for each slot
+        size_t _size;
+        size_t _growthLeft; // empty slots to fill before the next rehash
+
+        /**
+         * The control bytes of one group of slots.
+         *
+         * Without SSE2, the eight bytes of a group are compared within one
+         * 64 bit word, and each matching slot sets the high bit of its byte.
+         */
+        class Group
+        {
+        public:
+            typedef uint64_t Mask; //!< Matching slots, see getSlot()
+
+#ifdef CO_FLATHASH_SSE2
+            explicit Group( const int8_t* ctrl )
+                : _ctrl( _mm_loadu_si128(
+                             reinterpret_cast< const __m128i* >( ctrl ))) {}
+#else
+            explicit Group( const int8_t* ctrl )
+            {
+                ::memcpy( &_ctrl, ctrl, sizeof( _ctrl ));
+#  if defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+                _ctrl = __builtin_bswap64( _ctrl ); // first slot in low byte
+#  endif
+            }
+#endif
+
+            /** @return the slots with the given control byte. */
+            Mask match( const int8_t value ) const
+            {
+#ifdef CO_FLATHASH_SSE2
+                return Mask( _mm_movemask_epi8(
+                            _mm_cmpeq_epi8( _mm_set1_epi8( value ), _ctrl )));
+#else
+                // May report bytes after a match, but is exact if none match
+                const uint64_t x = _ctrl ^ ( _lsbs * uint8_t( value ));
+                return ( x - _lsbs ) & ~x & ( _lsbs << 7 );
+#endif
+            }
+
+            /** @return the empty or deleted slots. */
+            Mask matchFree() const
+            {
+#ifdef CO_FLATHASH_SSE2
+                return Mask( _mm_movemask_epi8( _ctrl ));
+#else
+                return _ctrl & ( _lsbs << 7 );
+#endif
+            }
+
+            /** @return the position in the group of the first slot. */
+            static size_t getSlot( const Mask mask )
+            {
+#ifdef __GNUC__
+                const size_t bit = size_t( __builtin_ctzll( mask ));
+#else
+                size_t bit = 0;
+                while( !( mask & ( Mask( 1 ) << bit )))
+                    ++bit;
+#endif
+#ifdef CO_FLATHASH_SSE2
+                return bit;
+#else
+                return bit / 8;
+#endif
+            }
+
+        private:
+#ifdef CO_FLATHASH_SSE2
+            const __m128i _ctrl;
+#else
+            static const uint64_t _lsbs = 0x0101010101010101ull;
+            uint64_t _ctrl;
+#endif
+        };
+
+        static bool _isFull( const int8_t ctrl ) { return ctrl >= 0; }
+
+        static uint64_t _hash( const K& key )
+        {
+            // finalizer of MurmurHash3, all bits depend on all input bits
+            uint64_t x = flatHashKey( key );
+            x ^= x >> 33;
+            x *= 0xff51afd7ed558ccdull;
+            x ^= x >> 33;
+            x *= 0xc4ceb9fe1a85ec53ull;
+            x ^= x >> 33;
+            return x;
+        }
+
+        /** @return the seven bits of the hash stored in the control byte. */
+        static int8_t _getTag( const uint64_t hash )
+            { return int8_t( hash & 0x7f ); }
+
+        /** @return the first group to probe for the given hash. */
+        size_t _getGroup( const uint64_t hash ) const
+            { return size_t( hash >> 7 ) & ( _ctrl.size() / GROUP_SIZE - 1 ); }
+
+        /** @return the slot of the key, or _slots.size() if not found. */
+        size_t _find( const K& key, const uint64_t hash ) const
+        {
+            if( _size == 0 )
+                return _slots.size();
+
+            // Quadratic probing visits all groups since their number is a
+            // power of two. Terminates since there is always an empty slot.
+            const size_t groupMask = _ctrl.size() / GROUP_SIZE - 1;
+            const int8_t tag = _getTag( hash );
+            size_t group = _getGroup( hash );
+            for( size_t step = 1; ; group = ( group + step++ ) & groupMask )
+            {
+                const size_t first = group * GROUP_SIZE;
+                const Group ctrl( &_ctrl[ first ] );
+                typename Group::Mask m = ctrl.match( tag );
+                for( ; m; m &= m - 1 )
+                {
+                    const size_t index = first + Group::getSlot( m );
+                    if( _slots[ index ].first == key )
+                        return index;
+                }
+                if( ctrl.match( CTRL_EMPTY ))
+                    return _slots.size();
+            }
+        }
+
+        /** @return the first empty or deleted slot of the probe sequence. */
+        size_t _findFree( const uint64_t hash ) const
+        {
+            const size_t groupMask = _ctrl.size() / GROUP_SIZE - 1;
+            size_t group = _getGroup( hash );
+            for( size_t step = 1; ; group = ( group + step++ ) & groupMask )
+            {
+                const size_t first = group * GROUP_SIZE;
+                const typename Group::Mask m =
+                    Group( &_ctrl[ first ] ).matchFree();
+                if( m )
+                    return first + Group::getSlot( m );
+            }
+        }
+
+        /** Insert a new key with a default value. @return its slot. */
+        size_t _insert( const K& key, const uint64_t hash )
+        {
+            size_t index = _slots.empty() ? 0 : _findFree( hash );
+            if( _slots.empty() ||
+                ( _growthLeft == 0 && _ctrl[ index ] == CTRL_EMPTY ))
+            {
+                // grow at a load of 7/16, else only drop the deleted slots
+                const size_t capacity = _slots.size();
+                _rehash( capacity == 0 ? size_t( GROUP_SIZE ) :
+                         _size * 16 >= capacity * 7 ? capacity * 2 : capacity );
+                index = _findFree( hash );
+            }
+
+            if( _ctrl[ index ] == CTRL_EMPTY )
+                --_growthLeft;
+            _ctrl[ index ] = _getTag( hash );
+            _slots[ index ].first = key;
+            ++_size;
+            return index;
+        }
+
+        void _rehash( const size_t capacity )
+        {
+            std::vector< value_type > slots( capacity );
+            std::vector< int8_t > ctrl( capacity, int8_t( CTRL_EMPTY ));
+            slots.swap( _slots );
+            ctrl.swap( _ctrl );
+            _growthLeft = capacity - capacity / 8 - _size; // max load 7/8
+
+            for( size_t i = 0; i < slots.size(); ++i )
+            {
+                if( !_isFull( ctrl[ i ] ))
+                    continue;
+                const size_t index = _findFree( _hash( slots[ i ].first ));
+                _ctrl[ index ] = ctrl[ i ];
+                _slots[ index ] = std::move( slots[ i ] );
+            }
+        }
+
+        void _erase( const size_t index )
+        {
+            // A probe stops at the first group with an empty slot. If this
+            // group has one, no probe went past it, and the slot can become
+            // empty. Otherwise it has to stay deleted until the next rehash.
+            const size_t first = index - index % GROUP_SIZE;
+            if( Group( &_ctrl[ first ] ).match( CTRL_EMPTY ))
+            {
+                _ctrl[ index ] = CTRL_EMPTY;
+                ++_growthLeft;
+            }
+            else
+                _ctrl[ index ] = CTRL_DELETED;
+
+            _slots[ index ] = value_type(); // release the key and value
+            --_size;
+        }
+    };
+}
+
+#endif // CO_FLATHASH_H
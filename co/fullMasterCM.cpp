@@ -81,7 +81,7 @@ void FullMasterCM::init()
     _object->getInstanceData( data->os );
     data->os.disable();
 
-    _instanceDatas.push_back( data );
+    _addInstanceData( data );
     ++_version;
     ++_commitCount;
 }
@@ -312,11 +312,15 @@ void FullMasterCM::_addInstanceData( InstanceData* data )
     _bytesBuffered += data->os.getSaveBuffer().getSize();
     LBINFO << _bytesBuffered << " bytes used" << std::endl;
 #endif
+
+    // retained versions mostly differ in a few chunks of their data
+    data->os.shareData( _chunkStore );
 }
 
 void FullMasterCM::_releaseInstanceData( InstanceData* data )
 {
 #ifdef CO_AGGRESSIVE_CACHING
+    data->os.reset(); // release shared chunks
     _instanceDataCache.push_back( data );
 #else
     delete data;
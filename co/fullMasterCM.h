@@ -22,6 +22,7 @@
 #define CO_FULLMASTERCM_H
 
 #include "versionedMasterCM.h"        // base class
+#include "chunkStore.h"                // member
 #include "objectInstanceDataOStream.h" // member
 
 #include <deque>
@@ -94,6 +95,9 @@ namespace co
         InstanceDataDeque _instanceDatas;
         InstanceDatas _instanceDataCache;
 
+        /** The data of all retained versions, sharing identical chunks. */
+        ChunkStore _chunkStore;
+
         /* The command handlers. */
         bool _cmdCommit( ICommand& command );
         bool _cmdObsolete( ICommand& command );
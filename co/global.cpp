@@ -93,7 +93,22 @@ int32_t     _iAttributes[Global::IATTR_ALL] =
     5000,   // RDMA_RESOLVE_TIMEOUT_MS
     1,      // IATTR_ROBUSTNESS
     _getTimeout(), // IATTR_TIMEOUT_DEFAULT
-    1023    // IATTR_OBJECT_COMPRESSION
+    1023,   // IATTR_OBJECT_COMPRESSION
+    100,    // IATTR_COMMAND_QUEUE_MAX_AGE
+    0,      // IATTR_COMMAND_POOL_SIZE
+    4096,   // IATTR_NODE_SEND_BATCH_SIZE
+    1,      // IATTR_NODE_SEND_BATCH_DELAY
+    0,      // IATTR_NODE_RECEIVE_BUFFER_SIZE
+    0,      // IATTR_URING_QUEUE_DEPTH
+    4194304, // IATTR_NODE_SEND_ASYNC_QUEUE_SIZE
+    4,      // IATTR_SEND_POOL_SIZE
+    32,     // IATTR_RSP_BATCH_SIZE
+    0,      // IATTR_RSP_RATE_CONTROL
+    0,      // IATTR_RSP_SIMULATED_LOSS
+    0,      // IATTR_RSP_FEC_GROUP_SIZE
+    2,      // IATTR_RELAY_FANOUT
+    4,      // IATTR_DECOMPRESSOR_POOL_SIZE
+    1000    // IATTR_URING_SQ_POLL_IDLE
 };
 }
 
@@ -101,6 +101,32 @@ namespace co
             IATTR_ROBUSTNESS,            //!< @internal use robustness
             IATTR_TIMEOUT_DEFAULT,       //!< @internal default timeout
             IATTR_OBJECT_COMPRESSION,    //!< @internal threshold to compress
+            /** @internal max queueing time in ms before promotion */
+            IATTR_COMMAND_QUEUE_MAX_AGE,
+            IATTR_COMMAND_POOL_SIZE,     //!< @internal object command threads
+            IATTR_NODE_SEND_BATCH_SIZE,  //!< @internal max command batch size
+            IATTR_NODE_SEND_BATCH_DELAY, //!< @internal max batching time (ms)
+            /** @internal read-ahead buffer size, 0 reads command by command */
+            IATTR_NODE_RECEIVE_BUFFER_SIZE,
+            IATTR_URING_QUEUE_DEPTH,     //!< @internal 0 disables io_uring IO
+            /** @internal max bytes queued by asynchronous node sends */
+            IATTR_NODE_SEND_ASYNC_QUEUE_SIZE,
+            IATTR_SEND_POOL_SIZE,        //!< @internal parallel send threads
+            IATTR_RSP_BATCH_SIZE,        //!< @internal datagrams per syscall
+            /** @internal 1 for equation-based rate control, 0 for nack-based */
+            IATTR_RSP_RATE_CONTROL,
+            /**
+             * @internal permille of received data datagrams to drop, needs a
+             * COLLAGE_RSP_SIMULATE_LOSS build
+             */
+            IATTR_RSP_SIMULATED_LOSS,
+            /** @internal data datagrams per parity datagram, 0 disables FEC */
+            IATTR_RSP_FEC_GROUP_SIZE,
+            IATTR_RELAY_FANOUT,          //!< @internal children per member
+            /** @internal background decompression threads, 0 disables */
+            IATTR_DECOMPRESSOR_POOL_SIZE,
+            /** @internal io_uring kernel submission thread idle time (ms) */
+            IATTR_URING_SQ_POLL_IDLE,
             IATTR_ALL
         };
 
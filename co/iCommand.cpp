@@ -38,6 +38,8 @@ public:
         , size( 0 )
         , type( COMMANDTYPE_INVALID )
         , cmd( CMD_INVALID )
+        , priority( COMMANDPRIORITY_NORMAL )
+        , deadline( 0 )
         , consumed( false )
     {}
 
@@ -49,6 +51,8 @@ public:
         , size( 0 )
         , type( COMMANDTYPE_INVALID )
         , cmd( CMD_INVALID )
+        , priority( COMMANDPRIORITY_NORMAL )
+        , deadline( 0 )
         , consumed( false )
     {}
 
@@ -64,6 +68,8 @@ public:
     uint64_t size;
     uint32_t type;
     uint32_t cmd;
+    CommandPriority priority;
+    uint32_t deadline;
     bool consumed;
 };
 } // detail namespace
@@ -111,6 +117,7 @@ ICommand::~ICommand()
 void ICommand::clear()
 {
     _impl->clear();
+    reset(); // drop the input buffer reference taken for array views
 }
 
 void ICommand::_skipHeader()
@@ -151,6 +158,23 @@ void ICommand::setDispatchFunction( const Dispatcher::Func& func )
     _impl->func = func;
 }
 
+void ICommand::setPriority( const CommandPriority priority,
+                            const uint32_t deadline )
+{
+    _impl->priority = priority;
+    _impl->deadline = deadline;
+}
+
+CommandPriority ICommand::getPriority() const
+{
+    return _impl->priority;
+}
+
+uint32_t ICommand::getDeadline() const
+{
+    return _impl->deadline;
+}
+
 ConstBufferPtr ICommand::getBuffer() const
 {
     LBASSERT( _impl->buffer );
@@ -175,13 +199,10 @@ NodePtr ICommand::getMaster()
 bool ICommand::getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
                              const void** chunkData, uint64_t& size )
 {
-    if( !_impl->buffer )
+    if( !_impl->buffer || _impl->consumed ) // one buffer per command
         return false;
 
-#ifndef NDEBUG
-    LBASSERT( !_impl->consumed );
     _impl->consumed = true;
-#endif
 
     *chunkData = _impl->buffer->getData();
     size = _impl->buffer->getSize();
@@ -190,6 +211,11 @@ bool ICommand::getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
     return true;
 }
 
+ConstBufferPtr ICommand::getCurrentBuffer() const
+{
+    return _impl->buffer;
+}
+
 NodePtr ICommand::getNode() const
 {
     return _impl->remote;
@@ -95,7 +95,17 @@ namespace detail { class ICommand; }
         CO_API void setCommand( const uint32_t cmd );
 
         /** @internal Set the function to which the command is dispatched. */
-        void setDispatchFunction( const Dispatcher::Func& func );
+        CO_API void setDispatchFunction( const Dispatcher::Func& func );
+
+        /** @internal Set the queue scheduling class and deadline in ms. */
+        CO_API void setPriority( const CommandPriority priority,
+                                 const uint32_t deadline );
+
+        /** @internal @return the queue scheduling class. */
+        CO_API CommandPriority getPriority() const;
+
+        /** @internal @return the maximum queueing time in ms, or 0. */
+        CO_API uint32_t getDeadline() const;
 
         /** @internal Invoke and clear the command function. */
         CO_API bool operator()();
@@ -113,6 +123,7 @@ namespace detail { class ICommand; }
         CO_API NodePtr getMaster() override;
         CO_API bool getNextBuffer( uint32_t&, uint32_t&, const void**,
                                            uint64_t& ) override;
+        CO_API ConstBufferPtr getCurrentBuffer() const override;
         //@}
 
         void _skipHeader(); //!< @internal
@@ -19,9 +19,14 @@
 
 #include "init.h"
 
+#include "connection.h"
+#include "decompressorPool.h"
 #include "global.h"
 #include "node.h"
 #include "socketConnection.h"
+#ifdef CO_USE_URING
+#  include "uring.h"
+#endif
 
 #include <lunchbox/init.h>
 #include <lunchbox/os.h>
@@ -87,6 +92,13 @@ bool exit()
     }
 #endif
 
+    Connection::exitBatchFlusher();
+    Connection::exitSendPool();
+    DecompressorPool::exit(); // uses the plugins
+#ifdef CO_USE_URING
+    URing::exitSQPoll();
+#endif
+
     // de-initialize registered plugins
     lunchbox::PluginRegistry& plugins = Global::getPluginRegistry();
     plugins.exit();
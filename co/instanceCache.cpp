@@ -56,8 +56,9 @@ InstanceCache::~InstanceCache()
 {
     for( ItemHash::iterator i = _items->begin(); i != _items->end(); ++i )
     {
-        Item& item = i->second;
-        _releaseStreams( item );
+        Item* item = i->second;
+        _releaseStreams( *item );
+        delete item;
     }
 
     _items->clear();
@@ -100,12 +101,13 @@ bool InstanceCache::add( const ObjectVersion& rev, const uint32_t instanceID,
     ItemHash::const_iterator i = _items->find( rev.identifier );
     if( i == _items->end( ))
     {
-        Item& item = _items.data[ rev.identifier ];
-        item.data.masterInstanceID = instanceID;
-        item.from = nodeID;
+        Item* item = new Item;
+        item->data.masterInstanceID = instanceID;
+        item->from = nodeID;
+        _items.data[ rev.identifier ] = item;
     }
 
-    Item& item = _items.data[ rev.identifier ] ;
+    Item& item = *_items.data[ rev.identifier ] ;
     if( item.data.masterInstanceID != instanceID || item.from != nodeID )
     {
         LBASSERT( !item.access ); // same master with different instance ID?!
@@ -193,7 +195,7 @@ void InstanceCache::remove( const NodeID& nodeID )
     lunchbox::ScopedMutex<> mutex( _items );
     for( ItemHash::iterator i = _items->begin(); i != _items->end(); ++i )
     {
-        Item& item = i->second;
+        Item& item = *i->second;
         if( item.from != nodeID )
             continue;
 
@@ -208,7 +210,7 @@ void InstanceCache::remove( const NodeID& nodeID )
     for( std::vector< lunchbox::uint128_t >::const_iterator i = keys.begin();
          i != keys.end(); ++i )
     {
-        _items->erase( *i );
+        _erase( *i );
     }
 }
 
@@ -223,7 +225,7 @@ const InstanceCache::Data& InstanceCache::operator[]( const UUID& id )
     if( i == _items->end( ))
         return Data::NONE;
 
-    Item& item = i->second;
+    Item& item = *i->second;
     LBASSERT( !item.data.versions.empty( ));
     ++item.access;
     ++item.used;
@@ -241,7 +243,7 @@ bool InstanceCache::release( const UUID& id, const uint32_t count )
     if( i == _items->end( ))
         return false;
 
-    Item& item = i->second;
+    Item& item = *i->second;
     LBASSERT( !item.data.versions.empty( ));
     LBASSERT( item.access >= count );
 
@@ -257,12 +259,12 @@ bool InstanceCache::erase( const UUID& id )
     if( i == _items->end( ))
         return false;
 
-    Item& item = i->second;
+    Item& item = *i->second;
     if( item.access != 0 )
         return false;
 
     _releaseStreams( item );
-    _items->erase( i );
+    _erase( id );
     return true;
 }
 
@@ -277,7 +279,7 @@ void InstanceCache::expire( const int64_t timeout )
     lunchbox::ScopedMutex<> mutex( _items );
     for( ItemHash::iterator i = _items->begin(); i != _items->end(); ++i )
     {
-        Item& item = i->second;
+        Item& item = *i->second;
         if( item.access != 0 )
             continue;
 
@@ -289,10 +291,18 @@ void InstanceCache::expire( const int64_t timeout )
     for( std::vector< lunchbox::uint128_t >::const_iterator i = keys.begin();
          i != keys.end(); ++i )
     {
-        _items->erase( *i );
+        _erase( *i );
     }
 }
 
+void InstanceCache::_erase( const uint128_t& id )
+{
+    ItemHashIter i = _items->find( id );
+    LBASSERT( i != _items->end( ));
+    delete i->second;
+    _items->erase( i );
+}
+
 void InstanceCache::_releaseStreams( InstanceCache::Item& item,
                                      const int64_t minTime )
 {
@@ -355,7 +365,7 @@ void InstanceCache::_releaseItems( const uint32_t minUsage )
     for( ItemHashIter i = _items->begin();
          i != _items->end() && _size > target; ++i )
     {
-        Item& item = i->second;
+        Item& item = *i->second;
         LBASSERT( !item.data.versions.empty( ));
 
         if( item.access == 0 && item.used >= minUsage )
@@ -379,7 +389,7 @@ void InstanceCache::_releaseItems( const uint32_t minUsage )
         for( std::vector< lunchbox::uint128_t >::const_iterator i = keys.begin();
              i != keys.end() && _size > target; ++i )
         {
-            Item& item = _items.data[ *i ];
+            Item& item = *_items.data[ *i ];
 
             if( !item.data.versions.empty() && item.access == 0 &&
                 item.used >= minUsage )
@@ -397,9 +407,9 @@ void InstanceCache::_releaseItems( const uint32_t minUsage )
     for( std::vector< lunchbox::uint128_t >::const_iterator i = keys.begin();
          i != keys.end(); ++i )
     {
-        Item& item = _items.data[ *i ];
+        Item& item = *_items.data[ *i ];
         if( item.data.versions.empty( ))
-            _items->erase( *i );
+            _erase( *i );
     }
 
     if( _size > target && minUsage == 0 )
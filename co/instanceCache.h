@@ -27,10 +27,12 @@
 #include <lunchbox/clock.h>     // member
 #include <lunchbox/lock.h>      // member
 #include <lunchbox/lockable.h>  // member
-#include <lunchbox/stdExt.h>    // member
 #include <lunchbox/thread.h>    // member
 #include <lunchbox/uuid.h>      // member
 
+#include "flatHash.h"           // member
+
+#include <deque>
 #include <iostream>
 
 namespace co
@@ -130,7 +132,9 @@ namespace co
             TimeDeque times;
         };
 
-        typedef stde::hash_map< lunchbox::uint128_t, Item > ItemHash;
+        // Items are allocated separately, since operator[] returns their
+        // data to be used outside of the lock while other items are added.
+        typedef FlatHash< uint128_t, Item* > ItemHash;
         typedef ItemHash::iterator ItemHashIter;
         lunchbox::Lockable< ItemHash > _items;
 
@@ -140,6 +144,7 @@ namespace co
         const lunchbox::Clock _clock;  //!< Clock for item expiration
 
         void _releaseItems( const uint32_t minUsage );
+        void _erase( const uint128_t& id );
         void _releaseStreams( InstanceCache::Item& item );
         void _releaseStreams( InstanceCache::Item& item,
                               const int64_t minTime );
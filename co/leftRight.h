@@ -0,0 +1,122 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_LEFTRIGHT_H
+#define CO_LEFTRIGHT_H
+
+#include <lunchbox/atomic.h>      // member
+#include <lunchbox/nonCopyable.h> // base class
+#include <lunchbox/scopedMutex.h> // used inline
+#include <lunchbox/spinLock.h>    // member
+#include <lunchbox/thread.h>      // used inline
+
+namespace co
+{
+    /**
+     * @internal Wait-free read access to data modified by one writer at a
+     * time, using the Left-Right technique.
+     *
+     * Two instances of the data are kept. Readers use the published instance
+     * without locking, after incrementing one of two read indicators. A writer
+     * modifies the other instance, publishes it, waits until no reader uses
+     * the previous instance, and then applies the same modification to it.
+     * Writers pay for the second modification and the wait for readers.
+     *
+     * After modify() returns, no reader uses data which was removed by the
+     * modification.
+     */
+    template< class T > class LeftRight : public lunchbox::NonCopyable
+    {
+    public:
+        LeftRight() : _leftRight( 0 ), _version( 0 )
+            { _readers[ 0 ] = 0; _readers[ 1 ] = 0; }
+
+        /**
+         * Read access to the published instance during the lifetime of the
+         * reader. Must not be used by a thread during its modify().
+         */
+        class Reader
+        {
+        public:
+            explicit Reader( const LeftRight& leftRight )
+                : _leftRight( leftRight ), _version( leftRight._version )
+            {
+                ++_leftRight._readers[ _version ];
+                _data = &_leftRight._data[ int32_t( _leftRight._leftRight )];
+            }
+
+            ~Reader() { --_leftRight._readers[ _version ]; }
+
+            const T& operator * () const { return *_data; }
+            const T* operator -> () const { return _data; }
+
+        private:
+            const LeftRight& _leftRight;
+            const int32_t _version;
+            const T* _data;
+        };
+
+        /**
+         * Modify both instances, calling functor( T& ) once for each.
+         *
+         * The functor has to apply the same change both times.
+         */
+        template< class F > void modify( const F& functor )
+        {
+            lunchbox::ScopedFastWrite mutex( _writeLock );
+            const int32_t leftRight = _leftRight;
+
+            functor( _data[ 1 - leftRight ] );
+            _leftRight = 1 - leftRight;
+
+            // Readers from before the publication may be registered with
+            // either indicator. Wait for the unused one, move new readers to
+            // it and wait for the previously used one.
+            const int32_t version = _version;
+            _waitReaders( 1 - version );
+            _version = 1 - version;
+            _waitReaders( version );
+
+            functor( _data[ leftRight ] );
+        }
+
+        /**
+         * Unsynchronized access to the published instance.
+         *
+         * Only valid in a thread which does all modifications.
+         */
+        const T& operator * () const { return _data[ int32_t( _leftRight )]; }
+        const T* operator -> () const
+            { return &_data[ int32_t( _leftRight )]; }
+
+    private:
+        T _data[ 2 ];
+        lunchbox::a_int32_t _leftRight; //!< the instance used by new readers
+        lunchbox::a_int32_t _version; //!< the indicator used by new readers
+        mutable lunchbox::a_int32_t _readers[ 2 ]; //!< the read indicators
+        lunchbox::SpinLock _writeLock;
+
+        void _waitReaders( const int32_t version ) const
+        {
+            while( _readers[ version ] != 0 )
+                lunchbox::Thread::yield();
+        }
+    };
+}
+
+#endif // CO_LEFTRIGHT_H
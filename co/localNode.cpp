@@ -28,7 +28,9 @@
 #include "connectionSet.h"
 #include "customICommand.h"
 #include "dataIStream.h"
+#include "dataStreamArchive.h"
 #include "exception.h"
+#include "flatHash.h"
 #include "global.h"
 #include "iCommand.h"
 #include "nodeCommand.h"
@@ -42,7 +44,6 @@
 #include "zeroconf.h"
 
 #include <lunchbox/clock.h>
-#include <lunchbox/hash.h>
 #include <lunchbox/lockable.h>
 #include <lunchbox/log.h>
 #include <lunchbox/requestHandler.h>
@@ -50,6 +51,7 @@
 #include <lunchbox/scopedMutex.h>
 #include <lunchbox/sleep.h>
 #include <lunchbox/spinLock.h>
+#include <lunchbox/stdExt.h>
 #include <lunchbox/types.h>
 #include <lunchbox/servus.h>
 
@@ -59,10 +61,10 @@ namespace
 {
 typedef CommandFunc< LocalNode > CmdFunc;
 typedef std::list< ICommand > CommandList;
-typedef lunchbox::RefPtrHash< Connection, NodePtr > ConnectionNodeHash;
+typedef FlatHash< ConnectionPtr, NodePtr > ConnectionNodeHash;
 typedef ConnectionNodeHash::const_iterator ConnectionNodeHashCIter;
 typedef ConnectionNodeHash::iterator ConnectionNodeHashIter;
-typedef stde::hash_map< uint128_t, NodePtr > NodeHash;
+typedef FlatHash< uint128_t, NodePtr > NodeHash;
 typedef NodeHash::const_iterator NodeHashCIter;
 typedef stde::hash_map< uint128_t, LocalNode::PushHandler > HandlerHash;
 typedef HandlerHash::const_iterator HandlerHashCIter;
@@ -110,6 +112,74 @@ private:
     co::LocalNode* const _localNode;
 };
 
+class PoolThread : public Worker
+{
+public:
+    PoolThread( co::LocalNode* localNode, const size_t index )
+        : _localNode( localNode ), _index( index ) {}
+
+protected:
+    virtual bool init()
+        {
+            std::ostringstream name;
+            name << "P" << _index << " " << lunchbox::className( _localNode );
+            setName( name.str( ));
+            return true;
+        }
+
+    virtual bool stopRunning() { return _localNode->isClosed(); }
+
+private:
+    co::LocalNode* const _localNode;
+    const size_t _index;
+};
+typedef std::vector< PoolThread* > PoolThreads;
+typedef PoolThreads::const_iterator PoolThreadsCIter;
+
+/**
+ * Distributes commands to the command pool threads.
+ *
+ * All commands for one object identifier are executed by the same pool
+ * thread, which serializes them in order. Custom commands are distributed the
+ * same way by their command identifier, see LocalNode::_cmdCommand. Other
+ * non-object commands use the first pool thread. The queue itself stays empty.
+ */
+class CommandPool : public co::CommandQueue
+{
+public:
+    virtual void push( const co::ICommand& command )
+        { _select( command )->push( command ); }
+
+    virtual void pushFront( const co::ICommand& command )
+        { _select( command )->pushFront( command ); }
+
+    virtual co::ICommand pop( const uint32_t )
+        { LBDONTCALL; return co::ICommand(); }
+    virtual co::ICommands popAll( const uint32_t )
+        { LBDONTCALL; return co::ICommands(); }
+    virtual co::ICommand tryPop() { LBDONTCALL; return co::ICommand(); }
+
+    co::CommandQueue* select( const uint128_t& id )
+    {
+        LBASSERT( !threads.empty( ));
+        const size_t index = ( id.high() ^ id.low( )) % threads.size();
+        return threads[ index ]->getWorkerQueue();
+    }
+
+    PoolThreads threads;
+
+private:
+    co::CommandQueue* _select( const co::ICommand& command )
+    {
+        LBASSERT( !threads.empty( ));
+        if( command.getType() != COMMANDTYPE_OBJECT )
+            return threads.front()->getWorkerQueue();
+
+        const co::ObjectICommand objectCommand( command );
+        return select( objectCommand.getObjectID( ));
+    }
+};
+
 class LocalNode
 {
 public:
@@ -134,6 +204,14 @@ public:
 
             delete objectStore;
             objectStore = 0;
+            for( PoolThreadsCIter i = commandPool.threads.begin();
+                 i != commandPool.threads.end(); ++i )
+            {
+                LBASSERT( !(*i)->isRunning( ));
+                delete *i;
+            }
+            commandPool.threads.clear();
+
             LBASSERT( !commandThread->isRunning( ));
             delete commandThread;
             commandThread = 0;
@@ -184,6 +262,7 @@ public:
 
     ReceiverThread* receiverThread;
     CommandThread* commandThread;
+    CommandPool commandPool;
 
     lunchbox::Lockable< lunchbox::Servus > service;
 };
@@ -195,57 +274,61 @@ LocalNode::LocalNode( const uint32_t type )
 {
     _impl->receiverThread = new detail::ReceiverThread( this );
     _impl->commandThread  = new detail::CommandThread( this );
+    const int32_t poolSize =
+        Global::getIAttribute( Global::IATTR_COMMAND_POOL_SIZE );
+    for( int32_t i = 0; i < poolSize; ++i )
+        _impl->commandPool.threads.push_back( new detail::PoolThread( this, i ));
     _impl->objectStore = new ObjectStore( this );
+    _setCapabilities( NODE_CAPABILITIES );
 
     CommandQueue* queue = getCommandThreadQueue();
-    registerCommand( CMD_NODE_CONNECT,
-                     CmdFunc( this, &LocalNode::_cmdConnect ), 0 );
-    registerCommand( CMD_NODE_CONNECT_BE,
-                     CmdFunc( this, &LocalNode::_cmdConnect ), 0 );
-    registerCommand( CMD_NODE_CONNECT_REPLY,
-                     CmdFunc( this, &LocalNode::_cmdConnectReply ), 0 );
-    registerCommand( CMD_NODE_CONNECT_REPLY_BE,
-                     CmdFunc( this, &LocalNode::_cmdConnectReply ), 0 );
-    registerCommand( CMD_NODE_ID,
-                     CmdFunc( this, &LocalNode::_cmdID ), 0 );
-    registerCommand( CMD_NODE_ID_BE,
-                     CmdFunc( this, &LocalNode::_cmdID ), 0 );
-    registerCommand( CMD_NODE_ACK_REQUEST,
-                     CmdFunc( this, &LocalNode::_cmdAckRequest ), 0 );
-    registerCommand( CMD_NODE_STOP_RCV,
-                     CmdFunc( this, &LocalNode::_cmdStopRcv ), 0 );
-    registerCommand( CMD_NODE_STOP_CMD,
-                     CmdFunc( this, &LocalNode::_cmdStopCmd ), queue );
-    registerCommand( CMD_NODE_SET_AFFINITY_RCV,
-                     CmdFunc( this, &LocalNode::_cmdSetAffinity ), 0 );
-    registerCommand( CMD_NODE_SET_AFFINITY_CMD,
-                     CmdFunc( this, &LocalNode::_cmdSetAffinity ), queue );
-    registerCommand( CMD_NODE_CONNECT_ACK,
-                     CmdFunc( this, &LocalNode::_cmdConnectAck ), 0 );
-    registerCommand( CMD_NODE_DISCONNECT,
-                     CmdFunc( this, &LocalNode::_cmdDisconnect ), 0 );
-    registerCommand( CMD_NODE_GET_NODE_DATA,
-                     CmdFunc( this, &LocalNode::_cmdGetNodeData), queue );
-    registerCommand( CMD_NODE_GET_NODE_DATA_REPLY,
-                     CmdFunc( this, &LocalNode::_cmdGetNodeDataReply ), 0 );
-    registerCommand( CMD_NODE_ACQUIRE_SEND_TOKEN,
-                     CmdFunc( this, &LocalNode::_cmdAcquireSendToken ), queue );
-    registerCommand( CMD_NODE_ACQUIRE_SEND_TOKEN_REPLY,
-                     CmdFunc( this, &LocalNode::_cmdAcquireSendTokenReply ), 0);
-    registerCommand( CMD_NODE_RELEASE_SEND_TOKEN,
-                     CmdFunc( this, &LocalNode::_cmdReleaseSendToken ), queue );
-    registerCommand( CMD_NODE_ADD_LISTENER,
-                     CmdFunc( this, &LocalNode::_cmdAddListener ), 0 );
-    registerCommand( CMD_NODE_REMOVE_LISTENER,
-                     CmdFunc( this, &LocalNode::_cmdRemoveListener ), 0 );
-    registerCommand( CMD_NODE_PING,
-                     CmdFunc( this, &LocalNode::_cmdPing ), queue );
-    registerCommand( CMD_NODE_PING_REPLY,
-                     CmdFunc( this, &LocalNode::_cmdDiscard ), 0 );
-    registerCommand( CMD_NODE_COMMAND,
-                     CmdFunc( this, &LocalNode::_cmdCommand ), 0 );
-    registerCommand( CMD_NODE_ADD_CONNECTION,
-                     CmdFunc( this, &LocalNode::_cmdAddConnection ), 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdConnect >(
+        CMD_NODE_CONNECT, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdConnect >(
+        CMD_NODE_CONNECT_BE, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdConnectReply >(
+        CMD_NODE_CONNECT_REPLY, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdConnectReply >(
+        CMD_NODE_CONNECT_REPLY_BE, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdID >( CMD_NODE_ID, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdID >( CMD_NODE_ID_BE, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdAckRequest >(
+        CMD_NODE_ACK_REQUEST, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdStopRcv >(
+        CMD_NODE_STOP_RCV, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdStopCmd >(
+        CMD_NODE_STOP_CMD, queue );
+    registerCommand< LocalNode, &LocalNode::_cmdSetAffinity >(
+        CMD_NODE_SET_AFFINITY_RCV, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdSetAffinity >(
+        CMD_NODE_SET_AFFINITY_CMD, queue );
+    registerCommand< LocalNode, &LocalNode::_cmdConnectAck >(
+        CMD_NODE_CONNECT_ACK, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdDisconnect >(
+        CMD_NODE_DISCONNECT, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdGetNodeData >(
+        CMD_NODE_GET_NODE_DATA, queue );
+    registerCommand< LocalNode, &LocalNode::_cmdGetNodeDataReply >(
+        CMD_NODE_GET_NODE_DATA_REPLY, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdAcquireSendToken >(
+        CMD_NODE_ACQUIRE_SEND_TOKEN, queue, COMMANDPRIORITY_HIGH );
+    registerCommand< LocalNode, &LocalNode::_cmdAcquireSendTokenReply >(
+        CMD_NODE_ACQUIRE_SEND_TOKEN_REPLY, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdReleaseSendToken >(
+        CMD_NODE_RELEASE_SEND_TOKEN, queue, COMMANDPRIORITY_HIGH );
+    registerCommand< LocalNode, &LocalNode::_cmdAddListener >(
+        CMD_NODE_ADD_LISTENER, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdRemoveListener >(
+        CMD_NODE_REMOVE_LISTENER, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdPing >(
+        CMD_NODE_PING, queue, COMMANDPRIORITY_HIGH );
+    registerCommand< LocalNode, &LocalNode::_cmdDiscard >(
+        CMD_NODE_PING_REPLY, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdCommand >(
+        CMD_NODE_COMMAND, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdAddConnection >(
+        CMD_NODE_ADD_CONNECTION, 0 );
+    registerCommand< LocalNode, &LocalNode::_cmdBatch >( CMD_NODE_BATCH, 0 );
 }
 
 LocalNode::~LocalNode( )
@@ -483,6 +566,16 @@ void LocalNode::_addConnection( ConnectionPtr connection )
     }
 
     _impl->incoming.addConnection( connection );
+
+    const uint64_t streamSize =
+        Global::getIAttribute( Global::IATTR_NODE_RECEIVE_BUFFER_SIZE );
+    if( streamSize >= COMMAND_ALLOCSIZE && !connection->isMulticast( ))
+    {
+        BufferPtr buffer = _impl->bigBuffers.alloc( streamSize );
+        connection->recvAvailableNB( buffer, buffer->getMaxSize( ));
+        return;
+    }
+
     BufferPtr buffer = _impl->smallBuffers.alloc( COMMAND_ALLOCSIZE );
     connection->recvNB( buffer, COMMAND_MINSIZE );
 }
@@ -1023,7 +1116,8 @@ uint32_t LocalNode::_connect( NodePtr node, ConnectionPtr connection )
     const uint32_t cmd = CMD_NODE_CONNECT;
 #endif
     OCommand( Connections( 1, connection ), cmd )
-        << getNodeID() << requestID << getType() << serialize();
+        << getNodeID() << requestID << getType() << serialize()
+        << uint32_t( NODE_CAPABILITIES ) << getNativeLayout();
 
     bool connected = false;
     if( !waitRequest( requestID, connected, 10000 /*ms*/ ))
@@ -1074,6 +1168,22 @@ CommandQueue* LocalNode::getCommandThreadQueue()
     return _impl->commandThread->getWorkerQueue();
 }
 
+CommandQueue* LocalNode::getCommandPoolQueue()
+{
+    if( _impl->commandPool.threads.empty( ))
+        return getCommandThreadQueue();
+    return &_impl->commandPool;
+}
+
+bool LocalNode::_pushCommandPool( const UUID& objectID,
+                                  const ICommand& command )
+{
+    if( _impl->commandPool.threads.empty( ))
+        return false;
+    _impl->commandPool.select( objectID )->push( command );
+    return true;
+}
+
 bool LocalNode::inCommandThread() const
 {
     return _impl->commandThread->isCurrent();
@@ -1160,6 +1270,11 @@ void LocalNode::_runReceiverThread()
 
     _impl->pendingCommands.clear();
     LBCHECK( _impl->commandThread->join( ));
+    for( detail::PoolThreadsCIter i = _impl->commandPool.threads.begin();
+         i != _impl->commandPool.threads.end(); ++i )
+    {
+        LBCHECK( (*i)->join( ));
+    }
 
     ConnectionPtr connection = getConnection();
     PipeConnectionPtr pipe = LBSAFECAST( PipeConnection*, connection.get( ));
@@ -1235,6 +1350,8 @@ bool LocalNode::_handleData()
 
     ConnectionPtr connection = _impl->incoming.getConnection();
     LBASSERT( connection );
+    if( connection->isRecvAvailable( ))
+        return _handleStreamData( connection );
 
     BufferPtr buffer = _readHead( connection );
     if( !buffer ) // fluke signal
@@ -1258,6 +1375,116 @@ bool LocalNode::_handleData()
     return false;
 }
 
+bool LocalNode::_handleStreamData( ConnectionPtr connection )
+{
+    BufferPtr buffer;
+    const bool gotData = connection->recvSync( buffer, false );
+
+    if( !buffer ) // fluke signal
+    {
+        LBWARN << "Erronous network event on " << connection->getDescription()
+               << std::endl;
+        _impl->incoming.setDirty();
+        return false;
+    }
+
+    // frame all complete commands read so far into their own buffers
+    const uint64_t headerSize = OCommand::getSize();
+    std::vector< BufferPtr > buffers;
+    uint64_t offset = 0;
+    while( gotData && buffer->getSize() - offset >= headerSize )
+    {
+        const uint8_t* data = buffer->getData() + offset;
+        const uint64_t available = buffer->getSize() - offset;
+        uint64_t size;
+        memcpy( &size, data, sizeof( size ));
+        if( _isSwapping( connection, data ))
+            lunchbox::byteswap( size );
+
+        if( size < headerSize )
+        {
+            LBERROR << "Out-of-sync network stream: command size " << size
+                    << " on " << connection->getDescription() << std::endl;
+            connection->close();
+            return false; // no receive on the closed connection
+        }
+
+        // small commands are padded on the wire
+        const uint64_t wireSize = LB_MAX( size, uint64_t( COMMAND_MINSIZE ));
+        if( wireSize <= available )
+        {
+            BufferPtr commandBuffer = allocBuffer( size );
+            commandBuffer->replace( data, size );
+            buffers.push_back( commandBuffer );
+            offset += wireSize;
+            continue;
+        }
+        if( wireSize <= buffer->getMaxSize( ))
+            break; // wait for remainder of command
+
+        // oversized command, read remainder directly into a big buffer
+        BufferPtr commandBuffer = _impl->bigBuffers.alloc( size );
+        commandBuffer->replace( data, available );
+        offset += available;
+
+        connection->recvNB( commandBuffer, size - available );
+        if( !connection->recvSync( commandBuffer ))
+        {
+            LBERROR << "Incomplete command read of " << size << " bytes on "
+                    << connection->getDescription() << std::endl;
+            connection->close();
+            return false; // no receive on the closed connection
+        }
+        buffers.push_back( commandBuffer );
+    }
+
+    // move remaining partial command to front and start next receive
+    const uint64_t remaining = buffer->getSize() - offset;
+    if( offset > 0 && remaining > 0 )
+        memmove( buffer->getData(), buffer->getData() + offset, remaining );
+    buffer->setSize( remaining );
+    connection->recvAvailableNB( buffer, buffer->getMaxSize() - remaining );
+
+    for( std::vector< BufferPtr >::const_iterator i = buffers.begin();
+         i != buffers.end(); ++i )
+    {
+        ICommand command = _setupCommand( connection, *i );
+        if( command.isValid( ))
+            _dispatchCommand( command );
+        else
+            LBERROR << "Invalid command of size " << (*i)->getSize()
+                    << " read on " << connection->getDescription()
+                    << std::endl;
+    }
+    return !buffers.empty();
+}
+
+bool LocalNode::_isSwapping( ConnectionPtr connection, const uint8_t* data )
+{
+    ConnectionNodeHashCIter i = _impl->connectionNodes.find( connection );
+    if( i != _impl->connectionNodes.end( ))
+    {
+#ifdef COLLAGE_BIGENDIAN
+        return !i->second->isBigEndian();
+#else
+        return i->second->isBigEndian();
+#endif
+    }
+
+    // pre-node commands are sent little endian, see _setupCommand()
+    uint32_t cmd;
+    memcpy( &cmd, data + sizeof( uint64_t ) + sizeof( uint32_t ),
+            sizeof( cmd ));
+#ifdef COLLAGE_BIGENDIAN
+    lunchbox::byteswap( cmd );
+    return cmd == CMD_NODE_CONNECT || cmd == CMD_NODE_CONNECT_REPLY ||
+           cmd == CMD_NODE_ID;
+#else
+    return cmd == CMD_NODE_CONNECT_BE || cmd == CMD_NODE_CONNECT_REPLY_BE ||
+           cmd == CMD_NODE_ID_BE;
+#endif
+}
+
 BufferPtr LocalNode::_readHead( ConnectionPtr connection )
 {
     BufferPtr buffer;
@@ -1479,6 +1706,12 @@ Zeroconf LocalNode::getZeroconf()
 //----------------------------------------------------------------------
 bool LocalNode::_startCommandThread()
 {
+    for( detail::PoolThreadsCIter i = _impl->commandPool.threads.begin();
+         i != _impl->commandPool.threads.end(); ++i )
+    {
+        if( !(*i)->start( ))
+            return false;
+    }
     return _impl->commandThread->start();
 }
 
@@ -1515,6 +1748,15 @@ bool LocalNode::_cmdStopCmd( ICommand& command )
     LBASSERTINFO( isClosing(), *this );
 
     _setClosed();
+
+    // wake up pool threads to notice the closed state
+    for( detail::PoolThreadsCIter i = _impl->commandPool.threads.begin();
+         i != _impl->commandPool.threads.end(); ++i )
+    {
+        ICommand wakeup( command );
+        wakeup.setDispatchFunction( CmdFunc( this, &LocalNode::_cmdDiscard ));
+        (*i)->getWorkerQueue()->push( wakeup );
+    }
     return true;
 }
 
@@ -1535,6 +1777,7 @@ bool LocalNode::_cmdConnect( ICommand& command )
     const uint32_t requestID = command.get< uint32_t >();
     const uint32_t nodeType = command.get< uint32_t >();
     std::string data = command.get< std::string >();
+    const uint32_t capabilities = _getCapabilities( command );
 
     LBVERB << "handle connect " << command << " req " << requestID << " type "
            << nodeType << " data " << data << std::endl;
@@ -1586,6 +1829,7 @@ bool LocalNode::_cmdConnect( ICommand& command )
                   peer->getNodeID() << "!=" << nodeID );
     LBASSERT( peer->getType() == nodeType );
 
+    peer->_setCapabilities( capabilities );
     peer->_connect( connection );
     _impl->connectionNodes[ connection ] = peer;
     {
@@ -1596,12 +1840,29 @@ bool LocalNode::_cmdConnect( ICommand& command )
 
     // send our information as reply
     OCommand( Connections( 1, connection ), cmd )
-        << getNodeID() << requestID << getType() << serialize();
+        << getNodeID() << requestID << getType() << serialize()
+        << uint32_t( NODE_CAPABILITIES ) << getNativeLayout();
 
     notifyConnect( peer );
     return true;
 }
 
+uint32_t LocalNode::_getCapabilities( ICommand& command )
+{
+    // appended to the connect handshake, not sent by Collage 1.0 nodes
+    if( command.getRemainingBufferSize() < sizeof( uint32_t ))
+        return 0;
+    uint32_t capabilities = command.get< uint32_t >();
+
+    // native archives need the same sizes of the fundamental types
+    if( ( capabilities & NODE_CAPABILITY_NATIVE_ARCHIVE ) &&
+        command.get< uint32_t >() != getNativeLayout( ))
+    {
+        capabilities &= ~uint32_t( NODE_CAPABILITY_NATIVE_ARCHIVE );
+    }
+    return capabilities;
+}
+
 bool LocalNode::_cmdConnectReply( ICommand& command )
 {
     LBASSERT( !command.getNode( ));
@@ -1627,6 +1888,7 @@ bool LocalNode::_cmdConnectReply( ICommand& command )
 
     const uint32_t nodeType = command.get< uint32_t >();
     std::string data = command.get< std::string >();
+    const uint32_t capabilities = _getCapabilities( command );
 
     LBVERB << "handle connect reply " << command << " req " << requestID
            << " type " << nodeType << " data " << data << std::endl;
@@ -1670,6 +1932,7 @@ bool LocalNode::_cmdConnectReply( ICommand& command )
     LBASSERT( data.empty( ));
     LBASSERT( peer->getNodeID() == nodeID );
 
+    peer->_setCapabilities( capabilities );
     peer->_connect( connection );
     _impl->connectionNodes[ connection ] = peer;
     {
@@ -1955,6 +2218,40 @@ bool LocalNode::_cmdPing( ICommand& command )
     return true;
 }
 
+bool LocalNode::_cmdBatch( ICommand& command )
+{
+    LB_TS_THREAD( _rcvThread );
+
+    // split into the contained commands and dispatch each separately
+    ConstBufferPtr buffer = command.getBuffer();
+    const uint8_t* data = buffer->getData();
+    const uint64_t end = command.getSize();
+    uint64_t offset = OCommand::getSize();
+    LBASSERT( end <= buffer->getSize( ));
+
+    while( offset < end )
+    {
+        uint64_t size;
+        memcpy( &size, data + offset, sizeof( size ));
+        if( command.isSwapping( ))
+            lunchbox::byteswap( size );
+
+        if( size < OCommand::getSize() || offset + size > end )
+        {
+            LBERROR << "Corrupted batch " << command << std::endl;
+            return false;
+        }
+
+        BufferPtr subBuffer = allocBuffer( size );
+        subBuffer->replace( data + offset, size );
+        ICommand subCommand( this, command.getNode(), subBuffer,
+                             command.isSwapping( ));
+        _dispatchCommand( subCommand );
+        offset += size;
+    }
+    return true;
+}
+
 bool LocalNode::_cmdCommand( ICommand& command )
 {
     const uint128_t& commandID = command.get< uint128_t >();
@@ -1970,6 +2267,8 @@ bool LocalNode::_cmdCommand( ICommand& command )
         {
             command.setDispatchFunction( CmdFunc( this,
                                                 &LocalNode::_cmdCommandAsync ));
+            if( queue == &_impl->commandPool ) // serialize per command ID
+                queue = _impl->commandPool.select( commandID );
             queue->push( command );
             return true;
         }
@@ -332,6 +332,10 @@ namespace detail { class LocalNode; class ReceiverThread; class CommandThread; }
          * Custom command handlers are invoked on reception of a CustomICommand
          * send by Node::send( uint128_t, ... ).
          *
+         * Handlers registered with getCommandPoolQueue() run in parallel for
+         * different custom commands. All invocations of one custom command are
+         * executed in order by the same pool thread.
+         *
          * @param command the unique identifier of the custom command
          * @param func the handler function for the custom command
          * @param queue the queue where the command should be inserted to
@@ -366,6 +370,20 @@ namespace detail { class LocalNode; class ReceiverThread; class CommandThread; }
         /** Return the command queue to the command thread. @version 1.0 */
         CO_API CommandQueue* getCommandThreadQueue();
 
+        /**
+         * Return the command queue to the command thread pool.
+         *
+         * Commands pushed to this queue are executed by a pool of
+         * Global::IATTR_COMMAND_POOL_SIZE threads. Object commands for the
+         * same object identifier are executed in order by the same thread,
+         * commands for different objects run in parallel. Custom commands are
+         * distributed by their command identifier. Returns the command
+         * thread queue if the pool is disabled.
+         *
+         * @version 1.1
+         */
+        CO_API CommandQueue* getCommandPoolQueue();
+
         /**
          * @return true if executed from the command handler thread, false if
          *         not.
@@ -511,6 +529,8 @@ namespace detail { class LocalNode; class ReceiverThread; class CommandThread; }
         void   _handleConnect();
         void   _handleDisconnect();
         bool   _handleData();
+        bool   _handleStreamData( ConnectionPtr connection );
+        bool   _isSwapping( ConnectionPtr connection, const uint8_t* data );
         BufferPtr _readHead( ConnectionPtr connection );
         ICommand   _setupCommand( ConnectionPtr, ConstBufferPtr );
         bool      _readTail( ICommand&, BufferPtr, ConnectionPtr );
@@ -520,14 +540,35 @@ namespace detail { class LocalNode; class ReceiverThread; class CommandThread; }
         friend class ObjectStore;
         template< typename T > void
         _registerCommand( const uint32_t command, const CommandFunc< T >& func,
-                          CommandQueue* destinationQueue )
+                          CommandQueue* destinationQueue,
+                          const CommandPriority priority =
+                              COMMANDPRIORITY_NORMAL )
         {
-            registerCommand( command, func, destinationQueue );
+            registerCommand( command, func, destinationQueue, priority );
+        }
+
+        template< typename T, bool ( T::*func )( ICommand& ) > void
+        _registerCommand( const uint32_t command, T* object,
+                          CommandQueue* destinationQueue,
+                          const CommandPriority priority =
+                              COMMANDPRIORITY_NORMAL )
+        {
+            registerCommand< T, func >( command, object, destinationQueue,
+                                        priority );
         }
 
         void _dispatchCommand( ICommand& command );
         void   _redispatchCommands();
 
+        /**
+         * Queue a command on the pool thread serving the given object.
+         * @return false if the command pool is disabled.
+         */
+        bool _pushCommandPool( const UUID& objectID, const ICommand& command );
+
+        /** @return the NodeCapability bits ending a connect command. */
+        static uint32_t _getCapabilities( ICommand& command );
+
         /** The command functions. */
         bool _cmdAckRequest( ICommand& command );
         bool _cmdStopRcv( ICommand& command );
@@ -549,6 +590,7 @@ namespace detail { class LocalNode; class ReceiverThread; class CommandThread; }
         bool _cmdCommand( ICommand& command );
         bool _cmdCommandAsync( ICommand& command );
         bool _cmdAddConnection( ICommand& command );
+        bool _cmdBatch( ICommand& command );
         bool _cmdDiscard( ICommand& ) { return true; }
         //@}
 
@@ -22,6 +22,7 @@
 
 #include "connectionDescription.h"
 #include "customOCommand.h"
+#include "global.h"
 #include "nodeCommand.h"
 #include "oCommand.h"
 
@@ -86,6 +87,18 @@ public:
     /** Is a big endian host? */
     bool bigEndian;
 
+    /** Coalesce small commands sent to this node? */
+    bool sendBatching;
+
+    /** Queue sends to this node for the connection's send thread? */
+    bool asyncSend;
+
+    /** Use the compact encoding for object data sent to this node? */
+    bool compactData;
+
+    /** The NodeCapability bits announced by this node when connecting. */
+    uint32_t capabilities;
+
     Node( const uint32_t type_ )
         : id( true ), type( type_ ), state( STATE_CLOSED ), lastReceive ( 0 )
 #ifdef COLLAGE_BIGENDIAN
@@ -93,6 +106,10 @@ public:
 #else
         , bigEndian( false )
 #endif
+        , sendBatching( false )
+        , asyncSend( false )
+        , compactData( false )
+        , capabilities( 0 )
         {}
 
     ~Node()
@@ -351,6 +368,80 @@ CustomOCommand Node::send( const uint128_t& commandID, const bool multicast )
     return CustomOCommand( Connections( 1, connection ), commandID );
 }
 
+void Node::setSendBatching( const bool enable )
+{
+    _impl->sendBatching = enable;
+    ConnectionPtr connection = _impl->outgoing;
+    if( connection )
+        connection->setSendBatchSize( _getSendBatchSize( ));
+}
+
+bool Node::isSendBatching() const
+{
+    return _impl->sendBatching;
+}
+
+void Node::flushSendBatch()
+{
+    ConnectionPtr connection = _impl->outgoing;
+    if( connection )
+        connection->flushSendBatch();
+}
+
+void Node::setAsyncSend( const bool enable )
+{
+    _impl->asyncSend = enable;
+    ConnectionPtr connection = _impl->outgoing;
+    if( connection )
+        connection->setSendQueueSize( _getSendQueueSize( ));
+}
+
+bool Node::isAsyncSend() const
+{
+    return _impl->asyncSend;
+}
+
+void Node::setCompactData( const bool enable )
+{
+    _impl->compactData = enable;
+}
+
+bool Node::isCompactData() const
+{
+    return _impl->compactData &&
+           ( _impl->capabilities & NODE_CAPABILITY_COMPACT_DATA );
+}
+
+bool Node::isNativeArchive() const
+{
+#ifdef COLLAGE_BIGENDIAN
+    const bool bigEndian = true;
+#else
+    const bool bigEndian = false;
+#endif
+    return _impl->bigEndian == bigEndian &&
+           ( _impl->capabilities & NODE_CAPABILITY_NATIVE_ARCHIVE );
+}
+
+void Node::_setCapabilities( const uint32_t capabilities )
+{
+    _impl->capabilities = capabilities;
+}
+
+uint64_t Node::_getSendQueueSize() const
+{
+    if( !_impl->asyncSend )
+        return 0;
+    return Global::getIAttribute( Global::IATTR_NODE_SEND_ASYNC_QUEUE_SIZE );
+}
+
+uint64_t Node::_getSendBatchSize() const
+{
+    if( !_impl->sendBatching )
+        return 0;
+    return Global::getIAttribute( Global::IATTR_NODE_SEND_BATCH_SIZE );
+}
+
 const NodeID& Node::getNodeID() const
 {
     return _impl->id;
@@ -505,6 +596,10 @@ void Node::_connect( ConnectionPtr connection )
 {
     _impl->outgoing = connection;
     _impl->state = STATE_CONNECTED;
+    if( _impl->sendBatching )
+        connection->setSendBatchSize( _getSendBatchSize( ));
+    if( _impl->asyncSend )
+        connection->setSendQueueSize( _getSendQueueSize( ));
 }
 
 void Node::_disconnect()
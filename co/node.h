@@ -160,8 +160,83 @@ namespace detail { class Node; }
          */
         CO_API CustomOCommand send( const uint128_t& commandID,
                                     const bool multicast = false );
+
+        /**
+         * Enable or disable the batching of small commands sent to this node.
+         *
+         * When enabled, small unicast commands are coalesced into one batch
+         * command of up to Global::IATTR_NODE_SEND_BATCH_SIZE bytes. A batch
+         * is sent when it is full, after at most
+         * Global::IATTR_NODE_SEND_BATCH_DELAY milliseconds, on
+         * flushSendBatch(), or before a large command is sent. Batching trades
+         * latency for fewer system calls and packets for chatty
+         * communication. Disabled by default.
+         *
+         * @param enable true to enable batching, false to disable it.
+         * @version 1.1
+         */
+        CO_API void setSendBatching( const bool enable );
+
+        /** @return true if send batching is enabled. @version 1.1 */
+        CO_API bool isSendBatching() const;
+
+        /** Send all batched commands immediately. @version 1.1 */
+        CO_API void flushSendBatch();
+
+        /**
+         * Enable or disable asynchronous sends to this node.
+         *
+         * When enabled, sends to this node are queued and written by a send
+         * thread of the unicast connection, so that a slow receiver does not
+         * block the sender. Up to Global::IATTR_NODE_SEND_ASYNC_QUEUE_SIZE
+         * bytes are queued before a send blocks. Disabled by default.
+         *
+         * @param enable true to enable asynchronous sends, false to disable
+         *               them.
+         * @sa Connection::setSendQueueSize()
+         * @version 1.1
+         */
+        CO_API void setAsyncSend( const bool enable );
+
+        /** @return true if asynchronous sends are enabled. @version 1.1 */
+        CO_API bool isAsyncSend() const;
+
+        /**
+         * Enable or disable the compact encoding of object data sent to this
+         * node.
+         *
+         * When enabled, integers, container sizes and object versions written
+         * to the object data streams are sent as LEB128 varints, and signed
+         * integers are zigzag-encoded. Containers of flat items are still
+         * sent as raw blocks. The encoding is flagged in each data command,
+         * so that the receiver decodes it independent of its own setting. Data
+         * sent to multiple nodes is compact only if it is used for all of
+         * them. The compact encoding trades CPU time for less bandwidth,
+         * mostly for small commits on slow networks. Disabled by default.
+         *
+         * The encoding is only used if the node announced that it decodes
+         * compact data when connecting, which older nodes do not.
+         *
+         * @param enable true to enable the compact encoding, false to disable
+         *               it.
+         * @version 1.1
+         */
+        CO_API void setCompactData( const bool enable );
+
+        /**
+         * @return true if the compact encoding is enabled and supported by
+         *         the connected node.
+         * @version 1.1
+         */
+        CO_API bool isCompactData() const;
         //@}
 
+        /**
+         * @internal @return true if this node has the same endianness and
+         *           announced that it reads native archives of this node.
+         */
+        CO_API bool isNativeArchive() const;
+
         /** @internal @return last receive time. */
         CO_API int64_t getLastReceiveTime() const;
 
@@ -201,6 +276,12 @@ namespace detail { class Node; }
         /** Ensures the connectivity of this node. */
         ConnectionPtr _getConnection( const bool preferMulticast );
 
+        /** @return the send batch size of the unicast connection. */
+        uint64_t _getSendBatchSize() const;
+
+        /** @return the send queue size of the unicast connection. */
+        uint64_t _getSendQueueSize() const;
+
         /** @internal @name Methods for LocalNode */
         //@{
         void _addMulticast( NodePtr node, ConnectionPtr connection );
@@ -213,6 +294,7 @@ namespace detail { class Node; }
         void _connect( ConnectionPtr connection );
         void _disconnect();
         void _setLastReceive( const int64_t time );
+        void _setCapabilities( const uint32_t capabilities );
         friend class LocalNode;
         //@}
     };
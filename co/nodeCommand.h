@@ -68,9 +68,24 @@ namespace co
         CMD_NODE_COMMAND,
         CMD_NODE_PING,
         CMD_NODE_PING_REPLY,
-        CMD_NODE_ADD_CONNECTION
+        CMD_NODE_ADD_CONNECTION,
+        CMD_NODE_BATCH
         // check that not more than CMD_NODE_CUSTOM have been defined!
     };
+
+    /**
+     * Capabilities announced after the node data of the connect handshake.
+     * Nodes without them, e.g. Collage 1.0 nodes, do not send the field.
+     */
+    enum NodeCapability
+    {
+        NODE_CAPABILITY_COMPACT_DATA = 1 << 0, //!< decodes compact object data
+        /** reads native archives, followed by getNativeLayout() */
+        NODE_CAPABILITY_NATIVE_ARCHIVE = 1 << 1,
+
+        NODE_CAPABILITIES = NODE_CAPABILITY_COMPACT_DATA |
+                            NODE_CAPABILITY_NATIVE_ARCHIVE //!< of this version
+    };
 }
 
 #endif // CO_NODECOMMAND_H
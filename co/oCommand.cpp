@@ -167,12 +167,17 @@ void OCommand::sendData( const void* buffer, const uint64_t size,
     reinterpret_cast< uint64_t* >( bytes )[ 0 ] = _impl->size + size;
     const uint64_t sendSize = _impl->isLocked ? size : LB_MAX( size,
                                                                COMMAND_MINSIZE);
+    // batch what fits, send the rest with one fan-out to all connections
     const Connections& connections = getConnections();
+    Connections unbatched;
+    unbatched.reserve( connections.size( ));
     for( ConnectionsCIter i = connections.begin(); i != connections.end(); ++i )
     {
         ConnectionPtr connection = *i;
-        connection->send( bytes, sendSize, _impl->isLocked );
+        if( _impl->isLocked || !connection->sendBatched( bytes, size ))
+            unbatched.push_back( connection );
     }
+    Connection::send( unbatched, bytes, sendSize, _impl->isLocked );
 }
 
 }
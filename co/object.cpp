@@ -164,10 +164,13 @@ void Object::transfer( Object* from )
     impl_->cm           = from->impl_->cm;
     impl_->localNode    = from->impl_->localNode;
     impl_->cm->setObject( this );
+}
 
-    from->impl_->cm = ObjectCM::ZERO;
-    from->impl_->localNode = 0;
-    from->impl_->instanceID = EQ_INSTANCE_INVALID;
+void Object::releaseTransferred()
+{
+    impl_->cm = ObjectCM::ZERO;
+    impl_->localNode = 0;
+    impl_->instanceID = EQ_INSTANCE_INVALID;
 }
 
 void Object::_setChangeManager( ObjectCMPtr cm )
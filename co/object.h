@@ -419,9 +419,15 @@ public:
      */
     CO_API virtual void detach();
 
-    /** @internal Transfer the attachment from the given object. */
+    /**
+     * @internal Transfer the attachment from the given object. The given
+     * object keeps its attachment until releaseTransferred() is called on it.
+     */
     void transfer( Object* from );
 
+    /** @internal Drop the attachment after it was transferred. */
+    void releaseTransferred();
+
     void applyMapData( const uint128_t& version ); //!< @internal
     void sendInstanceData( Nodes& nodes ); //!< @internal
     //@}
@@ -38,6 +38,7 @@ public:
         , compressor( EQ_COMPRESSOR_NONE )
         , chunks( 1 )
         , isLast( false )
+        , compact( false )
     {}
 
     uint128_t version;
@@ -46,6 +47,7 @@ public:
     uint32_t compressor;
     uint32_t chunks;
     bool isLast;
+    bool compact;
 };
 
 }
@@ -75,9 +77,14 @@ ObjectDataICommand::ObjectDataICommand( const ObjectDataICommand& rhs )
 
 void ObjectDataICommand::_init()
 {
-    if( isValid( ))
-        *this >> _impl->version >> _impl->datasize >> _impl->sequence
-              >> _impl->isLast >> _impl->compressor >> _impl->chunks;
+    if( !isValid( ))
+        return;
+
+    uint8_t flags = 0;
+    *this >> _impl->version >> _impl->datasize >> _impl->sequence >> flags
+          >> _impl->compressor >> _impl->chunks;
+    _impl->isLast = flags & OBJECTDATA_LAST;
+    _impl->compact = flags & OBJECTDATA_COMPACT;
 }
 
 ObjectDataICommand::~ObjectDataICommand()
@@ -115,13 +122,19 @@ bool ObjectDataICommand::isLast() const
     return _impl->isLast;
 }
 
+bool ObjectDataICommand::isCompactData() const
+{
+    return _impl->compact;
+}
+
 std::ostream& operator << ( std::ostream& os, const ObjectDataICommand& command )
 {
     os << static_cast< const ObjectICommand& >( command );
     if( command.isValid( ))
     {
         os << " v" << command.getVersion() << " size " << command.getDataSize()
-           << " seq " << command.getSequence() << " last " << command.isLast();
+           << " seq " << command.getSequence() << " last " << command.isLast()
+           << " compact " << command.isCompactData();
     }
     return os;
 }
@@ -28,6 +28,16 @@ namespace co
 
 namespace detail { class ObjectDataICommand; }
 
+/**
+ * @internal Bits of the flag byte in the object data header. The byte was the
+ * isLast bool, the header of uncompact data is unchanged.
+ */
+enum ObjectDataFlags
+{
+    OBJECTDATA_LAST    = 1 << 0, //!< last command of the object data
+    OBJECTDATA_COMPACT = 1 << 1  //!< data uses the compact encoding
+};
+
 /** @internal A command specialization for object data. */
 class ObjectDataICommand : public ObjectICommand
 {
@@ -59,6 +69,9 @@ public:
     /** @return true if this is the last command for one object. */
     CO_API bool isLast() const;
 
+    /** @return true if the object data uses the compact encoding. */
+    CO_API bool isCompactData() const;
+
 private:
     ObjectDataICommand();
     ObjectDataICommand& operator = ( const ObjectDataICommand& );
@@ -23,6 +23,8 @@
 #include "commands.h"
 #include "objectDataICommand.h"
 
+#include <lunchbox/plugins/compressor.h>
+
 namespace co
 {
 ObjectDataIStream::ObjectDataIStream()
@@ -34,6 +36,7 @@ ObjectDataIStream::ObjectDataIStream()
 ObjectDataIStream::ObjectDataIStream( const ObjectDataIStream& from )
         : DataIStream( from )
         , _commands( from._commands )
+        , _jobs( from._jobs )
         , _version( from._version )
 {
 }
@@ -51,8 +54,14 @@ void ObjectDataIStream::reset()
 
 void ObjectDataIStream::_reset()
 {
+    for( JobDeque::const_iterator i = _jobs.begin(); i != _jobs.end(); ++i )
+        if( *i )
+            DecompressorPool::cancel( *i );
+
     _usedCommand.clear();
+    _usedJob = 0;
     _commands.clear();
+    _jobs.clear();
     _version = VERSION_INVALID;
 }
 
@@ -80,7 +89,22 @@ void ObjectDataIStream::addDataCommand( ObjectDataICommand command )
     }
 #endif
 
+    // decompress in the background while the remaining commands arrive
+    DecompressorPool::JobPtr job;
+    if( command.getCompressor() != EQ_COMPRESSOR_NONE &&
+        command.getDataSize() > 0 )
+    {
+        ObjectDataICommand data( command );
+        job = DecompressorPool::push( command.getBuffer(), _getData( data ),
+                                      command.getCompressor(),
+                                      command.getChunks(),
+                                      command.getDataSize( ));
+    }
+
+    // all commands of a version share the encoding of the sending stream
+    setCompact( command.isCompactData( ));
     _commands.push_back( command );
+    _jobs.push_back( job );
     if( command.isLast( ))
         _setReady();
 }
@@ -135,11 +159,14 @@ bool ObjectDataIStream::getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
     if( _commands.empty( ))
     {
         _usedCommand.clear();
+        _usedJob = 0;
         return false;
     }
 
     _usedCommand = _commands.front();
+    _usedJob = _jobs.front();
     _commands.pop_front();
+    _jobs.pop_front();
     if( !_usedCommand.isValid( ))
         return false;
 
@@ -154,8 +181,31 @@ bool ObjectDataIStream::getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
         return getNextBuffer( compressor, nChunks, chunkData, size );
 
     size = dataSize;
+    setSwapping( command.isSwapping( ));
+    if( _usedJob )
+    {
+        DecompressorPool::finish( _usedJob );
+        compressor = EQ_COMPRESSOR_NONE;
+        nChunks = 1;
+        *chunkData = _usedJob->getData();
+        return true;
+    }
+
     compressor = command.getCompressor();
     nChunks = command.getChunks();
+    *chunkData = _getData( command );
+    return true;
+}
+
+ConstBufferPtr ObjectDataIStream::getCurrentBuffer() const
+{
+    if( _usedJob )
+        return _usedJob;
+    return _usedCommand.isValid() ? _usedCommand.getBuffer() : ConstBufferPtr();
+}
+
+const void* ObjectDataIStream::_getData( ObjectDataICommand& command )
+{
     switch( command.getCommand( ))
     {
       case CMD_OBJECT_INSTANCE:
@@ -166,10 +216,7 @@ bool ObjectDataIStream::getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
         command.get< UUID >();      // commit UUID
         break;
     }
-    *chunkData = command.getRemainingBuffer( command.getRemainingBufferSize( ));
-
-    setSwapping( command.isSwapping( ));
-    return true;
+    return command.getRemainingBuffer( command.getRemainingBufferSize( ));
 }
 
 }
@@ -23,6 +23,7 @@
 
 #include <co/iCommand.h>        // member
 #include <co/dataIStream.h>     // base class
+#include <co/decompressorPool.h> // member
 #include <co/version.h>         // enum
 #include <lunchbox/monitor.h>   // member
 #include <lunchbox/thread.h>    // member
@@ -59,6 +60,7 @@ namespace co
     protected:
         bool getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
                               const void** chunkData, uint64_t& size ) override;
+        ConstBufferPtr getCurrentBuffer() const override;
 
     private:
         typedef std::deque< ICommand > CommandDeque;
@@ -66,7 +68,13 @@ namespace co
         /** All data commands for this istream. */
         CommandDeque _commands;
 
+        typedef std::deque< DecompressorPool::JobPtr > JobDeque;
+
+        /** The background decompression of each command, 0 if none. */
+        JobDeque _jobs;
+
         ICommand _usedCommand; //!< Currently used buffer
+        DecompressorPool::JobPtr _usedJob; //!< Decompressed used buffer
 
         /** The object version associated with this input stream. */
         lunchbox::Monitor< uint128_t > _version;
@@ -74,6 +82,9 @@ namespace co
         void _setReady() { _version = getPendingVersion(); }
         void _reset();
 
+        /** @return the compressed or uncompressed data of a command. */
+        static const void* _getData( ObjectDataICommand& command );
+
         LB_TS_VAR( _thread );
     };
 }
@@ -81,7 +81,10 @@ void ObjectDataOCommand::_init( const uint128_t& version,
                                 const uint32_t sequence,
                                 const uint64_t dataSize, const bool isLast )
 {
-    *this << version << dataSize << sequence << isLast;
+    uint8_t flags = isLast ? OBJECTDATA_LAST : 0;
+    if( _impl->stream && _impl->stream->isCompact( ))
+        flags |= OBJECTDATA_COMPACT;
+    *this << version << dataSize << sequence << flags;
 
     if( _impl->stream )
         _impl->stream->streamDataHeader( *this );
@@ -94,13 +97,7 @@ ObjectDataOCommand::~ObjectDataOCommand()
     if( _impl->stream && _impl->dataSize > 0 )
     {
         sendHeader( _impl->dataSize );
-        const Connections& connections = getConnections();
-        for( ConnectionsCIter i = connections.begin(); i != connections.end();
-             ++i )
-        {
-            ConnectionPtr conn = *i;
-            _impl->stream->sendBody( conn, _impl->dataSize );
-        }
+        _impl->stream->sendBody( getConnections(), _impl->dataSize );
     }
 
     delete _impl;
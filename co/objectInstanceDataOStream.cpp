@@ -35,14 +35,18 @@ ObjectInstanceDataOStream::ObjectInstanceDataOStream( const ObjectCM* cm )
         : ObjectDataOStream( cm )
         , _instanceID( EQ_INSTANCE_ALL )
         , _command( 0 )
+        , _chunkStore( 0 )
 {}
 
 ObjectInstanceDataOStream::~ObjectInstanceDataOStream()
-{}
+{
+    _releaseChunks();
+}
 
 void ObjectInstanceDataOStream::reset()
 {
     ObjectDataOStream::reset();
+    _releaseChunks();
     _nodeID = 0;
     _instanceID = EQ_INSTANCE_NONE;
     _command = 0;
@@ -76,7 +80,7 @@ void ObjectInstanceDataOStream::push( const Nodes& receivers,
     _instanceID = EQ_INSTANCE_NONE;
     _setupConnections( receivers );
 
-    _resend();
+    _resendSaved();
     OCommand( getConnections(), CMD_NODE_OBJECT_PUSH )
         << objectID << groupID << typeID;
 
@@ -89,7 +93,7 @@ void ObjectInstanceDataOStream::sendInstanceData( const Nodes& receivers )
     _nodeID = 0;
     _instanceID = EQ_INSTANCE_NONE;
     _setupConnections( receivers );
-    _resend();
+    _resendSaved();
     _clearConnections();
 }
 
@@ -100,10 +104,45 @@ void ObjectInstanceDataOStream::sendMapData( NodePtr node,
     _nodeID = node->getNodeID();
     _instanceID = instanceID;
     _setupConnection( node, true /* useMulticast */ );
-    _resend();
+    _resendSaved();
     _clearConnections();
 }
 
+void ObjectInstanceDataOStream::shareData( ChunkStore& store )
+{
+    LBASSERT( _chunks.empty( ));
+    const uint64_t size = _getSavedSize();
+    if( size <= ChunkStore::CHUNK_SIZE )
+        return;
+
+    _chunkStore = &store;
+    _chunkStore->insert( getBuffer().getData(), size, _chunks );
+    _releaseSaved();
+}
+
+void ObjectInstanceDataOStream::_resendSaved()
+{
+    if( _chunks.empty( ))
+    {
+        _resend();
+        return;
+    }
+
+    // reassemble the saved data only for the duration of the send
+    _chunkStore->copy( _chunks, getBuffer( ));
+    _resend();
+    _releaseSaved();
+}
+
+void ObjectInstanceDataOStream::_releaseChunks()
+{
+    if( _chunks.empty( ))
+        return;
+
+    _chunkStore->release( _chunks );
+    _chunkStore = 0;
+}
+
 void ObjectInstanceDataOStream::enableMap( const uint128_t& version,
                                            NodePtr node,
                                            const uint32_t instanceID )
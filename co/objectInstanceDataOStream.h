@@ -21,6 +21,7 @@
 #ifndef CO_OBJECTINSTANCEDATAOSTREAM_H
 #define CO_OBJECTINSTANCEDATAOSTREAM_H
 
+#include "chunkStore.h"         // member
 #include "objectDataOStream.h"   // base class
 
 namespace co
@@ -55,6 +56,13 @@ namespace co
         /** Send mapping data to the node, using multicast if available. */
         void sendMapData( NodePtr node, const uint32_t instanceID );
 
+        /**
+         * Move the saved data into chunks of the given store, sharing the
+         * chunks identical to other saved data. Small data and data only
+         * saved in compressed form are kept as is.
+         */
+        void shareData( ChunkStore& store );
+
     protected:
         void sendData( const void* buffer, const uint64_t size,
                                const bool last ) override;
@@ -63,6 +71,12 @@ namespace co
         NodeID _nodeID;
         uint32_t _instanceID;
         uint32_t _command;
+
+        ChunkStore* _chunkStore;
+        ChunkStore::Chunks _chunks; //!< the shared saved data, if any
+
+        void _resendSaved();
+        void _releaseChunks();
     };
 }
 #endif //CO_OBJECTINSTANCEDATAOSTREAM_H
@@ -22,6 +22,7 @@
 
 #include "dataIStream.h"
 #include "dataOStream.h"
+#include "flatHash.h"
 #include "objectFactory.h"
 
 #include <lunchbox/scopedMutex.h>
@@ -42,7 +43,7 @@ struct Entry //!< One object map item
     bool own;           //!< The object is created by us, delete it
 };
 
-typedef stde::hash_map< uint128_t, Entry > Map;
+typedef FlatHash< uint128_t, Entry > Map;
 typedef Map::iterator MapIter;
 typedef Map::const_iterator MapCIter;
 typedef std::vector< uint128_t > IDVector;
@@ -56,7 +57,7 @@ class ObjectMap
 {
 public:
     ObjectMap( ObjectHandler& h, ObjectFactory& f )
-        : handler( h ) , factory( f ) {}
+        : handler( h ) , factory( f ), dirtyTracking( false ) {}
 
     ~ObjectMap()
     {
@@ -99,6 +100,18 @@ public:
     Map map; //!< the actual map
     Objects masters; //!< Master objects registered with this instance
 
+    /** Masters not notifying this map, checked on each commit. */
+    Objects unwatched;
+
+    /** Serializable masters notify this map from setDirty(). */
+    bool dirtyTracking;
+
+    /** Protects dirty, which is modified by the masters' setDirty(). */
+    mutable lunchbox::SpinLock dirtyLock;
+
+    /** Watched masters which became dirty since the last commit. */
+    Objects dirty;
+
     /** Added master objects since the last commit. */
     IDVector added;
 
@@ -135,9 +148,21 @@ bool ObjectMap::isDirty() const
         return true;
 
     lunchbox::ScopedFastRead mutex( _impl->lock );
-    for( ObjectsCIter i =_impl->masters.begin(); i !=_impl->masters.end(); ++i )
+    {
+        lunchbox::ScopedFastRead dirtyMutex( _impl->dirtyLock );
+        for( ObjectsCIter i = _impl->dirty.begin(); i != _impl->dirty.end();
+             ++i )
+        {
+            if( (*i)->isDirty( ))
+                return true;
+        }
+    }
+    for( ObjectsCIter i = _impl->unwatched.begin();
+         i != _impl->unwatched.end(); ++i )
+    {
         if( (*i)->isDirty( ))
             return true;
+    }
     return false;
 }
 
@@ -145,7 +170,17 @@ void ObjectMap::_commitMasters( const uint32_t incarnation )
 {
     lunchbox::ScopedFastWrite mutex( _impl->lock );
 
-    for( ObjectsCIter i =_impl->masters.begin(); i !=_impl->masters.end(); ++i )
+    // Masters becoming dirty during their commit are committed next time.
+    // Duplicates are not dirty anymore after their first commit.
+    Objects dirty;
+    {
+        lunchbox::ScopedFastWrite dirtyMutex( _impl->dirtyLock );
+        dirty.swap( _impl->dirty );
+    }
+    dirty.insert( dirty.end(), _impl->unwatched.begin(),
+                  _impl->unwatched.end( ));
+
+    for( ObjectsCIter i = dirty.begin(); i != dirty.end(); ++i )
     {
         Object* object = *i;
         if( !object->isDirty() || object->getChangeType() == Object::STATIC )
@@ -163,6 +198,80 @@ void ObjectMap::_commitMasters( const uint32_t incarnation )
         setDirty( DIRTY_CHANGED );
 }
 
+void ObjectMap::_notifyDirty( Serializable* object )
+{
+    bool first = false;
+    {
+        lunchbox::ScopedFastWrite mutex( _impl->dirtyLock );
+        first = _impl->dirty.empty();
+        _impl->dirty.push_back( object );
+    }
+
+    // a map registered in another map has to be committed by its parent
+    ObjectMap* parent = _getObjectMap();
+    if( first && parent )
+        parent->_notifyDirty( this );
+}
+
+void ObjectMap::setDirtyTracking( const bool enable )
+{
+    lunchbox::ScopedFastWrite mutex( _impl->lock );
+    if( _impl->dirtyTracking == enable )
+        return;
+
+    for( ObjectsCIter i = _impl->masters.begin(); i != _impl->masters.end();
+         ++i )
+    {
+        _unwatch( *i );
+    }
+    _impl->dirtyTracking = enable;
+    for( ObjectsCIter i = _impl->masters.begin(); i != _impl->masters.end();
+         ++i )
+    {
+        _watch( *i );
+    }
+}
+
+bool ObjectMap::isDirtyTracking() const
+{
+    return _impl->dirtyTracking;
+}
+
+void ObjectMap::_watch( Object* object )
+{
+    Serializable* serializable = _impl->dirtyTracking ?
+        dynamic_cast< Serializable* >( object ) : 0;
+    if( !serializable || serializable->_getObjectMap( ))
+    {
+        _impl->unwatched.push_back( object );
+        return;
+    }
+
+    serializable->_setObjectMap( this );
+    if( serializable->isDirty( ))
+        _notifyDirty( serializable );
+}
+
+void ObjectMap::_unwatch( Object* object )
+{
+    ObjectsIter i = std::find( _impl->unwatched.begin(),
+                               _impl->unwatched.end(), object );
+    if( i != _impl->unwatched.end( ))
+    {
+        _impl->unwatched.erase( i );
+        return;
+    }
+
+    Serializable* serializable = static_cast< Serializable* >( object );
+    LBASSERT( serializable->_getObjectMap() == this );
+    serializable->_setObjectMap( 0 );
+
+    lunchbox::ScopedFastWrite mutex( _impl->dirtyLock );
+    _impl->dirty.erase( std::remove( _impl->dirty.begin(),
+                                     _impl->dirty.end(), object ),
+                        _impl->dirty.end( ));
+}
+
 void ObjectMap::serialize( DataOStream& os, const uint64_t dirtyBits )
 {
     Serializable::serialize( os, dirtyBits );
@@ -278,6 +387,7 @@ bool ObjectMap::register_( Object* object, const uint32_t type )
     const Entry entry( object->getVersion(), object, type );
     _impl->map[ object->getID() ] = entry;
     _impl->masters.push_back( object );
+    _watch( object );
     _impl->added.push_back( object->getID( ));
     setDirty( DIRTY_ADDED );
     return true;
@@ -296,6 +406,7 @@ bool ObjectMap::deregister( Object* object )
     if( mapIt == _impl->map.end() || masterIt == _impl->masters.end( ))
         return false;
 
+    _unwatch( object );
     _impl->handler.deregisterObject( object );
     _impl->map.erase( mapIt );
     _impl->masters.erase( masterIt );
@@ -370,6 +481,14 @@ bool ObjectMap::unmap( Object* object )
 
 void ObjectMap::clear()
 {
+    {
+        lunchbox::ScopedFastWrite mutex( _impl->lock );
+        for( ObjectsCIter i = _impl->masters.begin();
+             i != _impl->masters.end(); ++i )
+        {
+            _unwatch( *i );
+        }
+    }
     _impl->clear();
 }
 
@@ -117,7 +117,31 @@ public:
     /** Deregister or unmap all registered and mapped objects. @version 1.0 */
     CO_API void clear();
 
-    /** Commit all registered objects. @version 1.0 */
+    /**
+     * Enable or disable dirty tracking of Serializable masters.
+     *
+     * When enabled, commit() only visits the registered Serializable masters
+     * which called setDirty() since their last commit, instead of calling
+     * isDirty() on every master. Serializable subclasses overriding isDirty()
+     * must then only return true after setDirty() was called. Disabled by
+     * default.
+     *
+     * @param enable true to enable dirty tracking, false to disable it.
+     * @version 1.1
+     */
+    CO_API void setDirtyTracking( bool enable );
+
+    /** @return true if dirty tracking is enabled. @version 1.1 */
+    CO_API bool isDirtyTracking() const;
+
+    /**
+     * Commit all changed registered objects.
+     *
+     * With dirty tracking enabled, only the Serializable masters which called
+     * setDirty() since the last commit are visited. All other masters are
+     * checked for isDirty() on each commit.
+     * @version 1.0
+     */
     CO_API uint128_t commit( const uint32_t incarnation =
                                      CO_COMMIT_NEXT ) override;
 
@@ -149,6 +173,14 @@ private:
 
     /** @internal Commit and note new master versions. */
     void _commitMasters( const uint32_t incarnation );
+
+    /** @internal Remember a registered master for the next commit. */
+    friend class Serializable;
+    void _notifyDirty( Serializable* object );
+
+    /** @internal Start or stop receiving dirty notifications of a master. */
+    void _watch( Object* object );
+    void _unwatch( Object* object );
 };
 }
 #endif // CO_OBJECTMAP_H
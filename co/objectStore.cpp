@@ -48,6 +48,80 @@ namespace co
 {
 typedef CommandFunc<ObjectStore> CmdFunc;
 
+namespace
+{
+/** Add an object to the objects of an identifier. */
+struct AttachObject
+{
+    AttachObject( const uint128_t& id_, Object* object_ )
+        : id( id_ ), object( object_ ) {}
+
+    template< class H > void operator()( H& hash ) const
+        { hash[ id ].push_back( object ); }
+
+    const uint128_t& id;
+    Object* const object;
+};
+
+/** Remove an object, and its identifier if it has no objects left. */
+struct DetachObject
+{
+    DetachObject( const uint128_t& id_, Object* object_ )
+        : id( id_ ), object( object_ ) {}
+
+    template< class H > void operator()( H& hash ) const
+    {
+        typename H::iterator i = hash.find( id );
+        LBASSERT( i != hash.end( ));
+        Objects& objects = i->second;
+        Objects::iterator j = std::find( objects.begin(), objects.end(),
+                                         object );
+        LBASSERT( j != objects.end( ));
+        objects.erase( j );
+        if( objects.empty( ))
+            hash.erase( i );
+    }
+
+    const uint128_t& id;
+    Object* const object;
+};
+
+/** Replace an object by another one at the same position. */
+struct SwapObject
+{
+    SwapObject( const uint128_t& id_, Object* oldObject_, Object* newObject_ )
+        : id( id_ ), oldObject( oldObject_ ), newObject( newObject_ ) {}
+
+    template< class H > void operator()( H& hash ) const
+    {
+        typename H::iterator i = hash.find( id );
+        LBASSERT( i != hash.end( ));
+        Objects& objects = i->second;
+        Objects::iterator j = std::find( objects.begin(), objects.end(),
+                                         oldObject );
+        LBASSERT( j != objects.end( ));
+        *j = newObject;
+    }
+
+    const uint128_t& id;
+    Object* const oldObject;
+    Object* const newObject;
+};
+
+/** Remove all objects of an identifier. */
+struct EraseObjects
+{
+    explicit EraseObjects( const uint128_t& id_ ) : id( id_ ) {}
+    template< class H > void operator()( H& hash ) const { hash.erase( id ); }
+    const uint128_t& id;
+};
+
+struct ClearObjects
+{
+    template< class H > void operator()( H& hash ) const { hash.clear(); }
+};
+}
+
 ObjectStore::ObjectStore( LocalNode* localNode )
         : _localNode( localNode )
         , _instanceIDs( -0x7FFFFFFF )
@@ -57,42 +131,50 @@ ObjectStore::ObjectStore( LocalNode* localNode )
     LBASSERT( localNode );
     CommandQueue* queue = localNode->getCommandThreadQueue();
 
-    localNode->_registerCommand( CMD_NODE_FIND_MASTER_NODE_ID,
-        CmdFunc( this, &ObjectStore::_cmdFindMasterNodeID ), queue );
-    localNode->_registerCommand( CMD_NODE_FIND_MASTER_NODE_ID_REPLY,
-        CmdFunc( this, &ObjectStore::_cmdFindMasterNodeIDReply ), 0 );
-    localNode->_registerCommand( CMD_NODE_ATTACH_OBJECT,
-        CmdFunc( this, &ObjectStore::_cmdAttachObject ), 0 );
-    localNode->_registerCommand( CMD_NODE_DETACH_OBJECT,
-        CmdFunc( this, &ObjectStore::_cmdDetachObject ), 0 );
-    localNode->_registerCommand( CMD_NODE_REGISTER_OBJECT,
-        CmdFunc( this, &ObjectStore::_cmdRegisterObject ), queue );
-    localNode->_registerCommand( CMD_NODE_DEREGISTER_OBJECT,
-        CmdFunc( this, &ObjectStore::_cmdDeregisterObject ), queue );
-    localNode->_registerCommand( CMD_NODE_MAP_OBJECT,
-        CmdFunc( this, &ObjectStore::_cmdMapObject ), queue );
-    localNode->_registerCommand( CMD_NODE_MAP_OBJECT_SUCCESS,
-        CmdFunc( this, &ObjectStore::_cmdMapObjectSuccess ), 0 );
-    localNode->_registerCommand( CMD_NODE_MAP_OBJECT_REPLY,
-        CmdFunc( this, &ObjectStore::_cmdMapObjectReply ), 0 );
-    localNode->_registerCommand( CMD_NODE_UNMAP_OBJECT,
-        CmdFunc( this, &ObjectStore::_cmdUnmapObject ), 0 );
-    localNode->_registerCommand( CMD_NODE_UNSUBSCRIBE_OBJECT,
-        CmdFunc( this, &ObjectStore::_cmdUnsubscribeObject ), queue );
-    localNode->_registerCommand( CMD_NODE_OBJECT_INSTANCE,
-        CmdFunc( this, &ObjectStore::_cmdInstance ), 0 );
-    localNode->_registerCommand( CMD_NODE_OBJECT_INSTANCE_MAP,
-        CmdFunc( this, &ObjectStore::_cmdInstance ), 0 );
-    localNode->_registerCommand( CMD_NODE_OBJECT_INSTANCE_COMMIT,
-        CmdFunc( this, &ObjectStore::_cmdInstance ), 0 );
-    localNode->_registerCommand( CMD_NODE_OBJECT_INSTANCE_PUSH,
-        CmdFunc( this, &ObjectStore::_cmdInstance ), 0 );
-    localNode->_registerCommand( CMD_NODE_DISABLE_SEND_ON_REGISTER,
-        CmdFunc( this, &ObjectStore::_cmdDisableSendOnRegister ), queue );
-    localNode->_registerCommand( CMD_NODE_REMOVE_NODE,
-        CmdFunc( this, &ObjectStore::_cmdRemoveNode ), queue );
-    localNode->_registerCommand( CMD_NODE_OBJECT_PUSH,
-        CmdFunc( this, &ObjectStore::_cmdObjectPush ), queue );
+    localNode->_registerCommand< ObjectStore,
+                                 &ObjectStore::_cmdFindMasterNodeID >(
+        CMD_NODE_FIND_MASTER_NODE_ID, this, queue );
+    localNode->_registerCommand< ObjectStore,
+                                 &ObjectStore::_cmdFindMasterNodeIDReply >(
+        CMD_NODE_FIND_MASTER_NODE_ID_REPLY, this, 0 );
+    localNode->_registerCommand< ObjectStore, &ObjectStore::_cmdAttachObject >(
+        CMD_NODE_ATTACH_OBJECT, this, 0 );
+    localNode->_registerCommand< ObjectStore, &ObjectStore::_cmdDetachObject >(
+        CMD_NODE_DETACH_OBJECT, this, 0 );
+    localNode->_registerCommand< ObjectStore,
+                                 &ObjectStore::_cmdRegisterObject >(
+        CMD_NODE_REGISTER_OBJECT, this, queue );
+    localNode->_registerCommand< ObjectStore,
+                                 &ObjectStore::_cmdDeregisterObject >(
+        CMD_NODE_DEREGISTER_OBJECT, this, queue );
+    localNode->_registerCommand< ObjectStore, &ObjectStore::_cmdMapObject >(
+        CMD_NODE_MAP_OBJECT, this, queue );
+    localNode->_registerCommand< ObjectStore,
+                                 &ObjectStore::_cmdMapObjectSuccess >(
+        CMD_NODE_MAP_OBJECT_SUCCESS, this, 0 );
+    localNode->_registerCommand< ObjectStore,
+                                 &ObjectStore::_cmdMapObjectReply >(
+        CMD_NODE_MAP_OBJECT_REPLY, this, 0 );
+    localNode->_registerCommand< ObjectStore, &ObjectStore::_cmdUnmapObject >(
+        CMD_NODE_UNMAP_OBJECT, this, 0 );
+    localNode->_registerCommand< ObjectStore,
+                                 &ObjectStore::_cmdUnsubscribeObject >(
+        CMD_NODE_UNSUBSCRIBE_OBJECT, this, queue );
+    localNode->_registerCommand< ObjectStore, &ObjectStore::_cmdInstance >(
+        CMD_NODE_OBJECT_INSTANCE, this, 0 );
+    localNode->_registerCommand< ObjectStore, &ObjectStore::_cmdInstance >(
+        CMD_NODE_OBJECT_INSTANCE_MAP, this, 0 );
+    localNode->_registerCommand< ObjectStore, &ObjectStore::_cmdInstance >(
+        CMD_NODE_OBJECT_INSTANCE_COMMIT, this, 0 );
+    localNode->_registerCommand< ObjectStore, &ObjectStore::_cmdInstance >(
+        CMD_NODE_OBJECT_INSTANCE_PUSH, this, 0 );
+    localNode->_registerCommand< ObjectStore,
+                                 &ObjectStore::_cmdDisableSendOnRegister >(
+        CMD_NODE_DISABLE_SEND_ON_REGISTER, this, queue );
+    localNode->_registerCommand< ObjectStore, &ObjectStore::_cmdRemoveNode >(
+        CMD_NODE_REMOVE_NODE, this, queue );
+    localNode->_registerCommand< ObjectStore, &ObjectStore::_cmdObjectPush >(
+        CMD_NODE_OBJECT_PUSH, this, queue, COMMANDPRIORITY_LOW );
 }
 
 ObjectStore::~ObjectStore()
@@ -134,7 +216,7 @@ void ObjectStore::clear( )
     expireInstanceData( 0 );
     LBASSERT( !_instanceCache || _instanceCache->isEmpty( ));
 
-    _objects->clear();
+    _objects.modify( ClearObjects( ));
     _sendQueue.clear();
 }
 
@@ -252,14 +334,13 @@ void ObjectStore::_attachObject( Object* object, const UUID& id,
 
     object->attach( id, instanceID );
 
-    {
-        lunchbox::ScopedFastWrite mutex( _objects );
-        Objects& objects = _objects.data[ id ];
-        LBASSERTINFO( !object->isMaster() || objects.empty(),
-            "Attaching master " << *object << ", " << objects.size() <<
-            " attached objects with same ID, first is: " << *objects[0] );
-        objects.push_back( object );
-    }
+#ifndef NDEBUG
+    ObjectsHashCIter i = _objects->find( id );
+    LBASSERTINFO( !object->isMaster() || i == _objects->end(),
+        "Attaching master " << *object << ", " << i->second.size() <<
+        " attached objects with same ID, first is: " << *i->second[0] );
+#endif
+    _objects.modify( AttachObject( id, object ));
 
     _localNode->flushCommands(); // redispatch pending commands
 
@@ -290,22 +371,25 @@ void ObjectStore::swapObject( Object* oldObject, Object* newObject )
 
     LBLOG( LOG_OBJECTS ) << "Swap " << lunchbox::className( oldObject )
                          << std::endl;
-    const UUID& id = oldObject->getID();
+    const UUID id = oldObject->getID();
 
-    lunchbox::ScopedFastWrite mutex( _objects );
-    ObjectsHash::iterator i = _objects->find( id );
+    ObjectsHashCIter i = _objects->find( id );
     LBASSERT( i != _objects->end( ));
     if( i == _objects->end( ))
         return;
 
-    Objects& objects = i->second;
-    Objects::iterator j = find( objects.begin(), objects.end(), oldObject );
+    const Objects& objects = i->second;
+    Objects::const_iterator j = find( objects.begin(), objects.end(),
+                                      oldObject );
     LBASSERT( j != objects.end( ));
     if( j == objects.end( ))
         return;
 
+    // Readers find either object during the modification. Both share the
+    // attachment until no reader uses the old one anymore.
     newObject->transfer( oldObject );
-    *j = newObject;
+    _objects.modify( SwapObject( id, oldObject, newObject ));
+    oldObject->releaseTransferred();
 }
 
 void ObjectStore::_detachObject( Object* object )
@@ -322,16 +406,7 @@ void ObjectStore::_detachObject( Object* object )
     LBASSERT( _objects->find( id ) != _objects->end( ));
     LBLOG( LOG_OBJECTS ) << "Detach " << *object << std::endl;
 
-    Objects& objects = _objects.data[ id ];
-    Objects::iterator i = find( objects.begin(),objects.end(), object );
-    LBASSERT( i != objects.end( ));
-
-    {
-        lunchbox::ScopedFastWrite mutex( _objects );
-        objects.erase( i );
-        if( objects.empty( ))
-            _objects->erase( id );
-    }
+    _objects.modify( DetachObject( id, object ));
 
     LBASSERT( object->getInstanceID() != EQ_INSTANCE_INVALID );
     object->detach();
@@ -640,10 +715,10 @@ bool ObjectStore::_cmdFindMasterNodeID( ICommand& command )
 
     NodeID masterNodeID;
     {
-        lunchbox::ScopedFastRead mutex( _objects );
-        ObjectsHashCIter i = _objects->find( id );
+        const ObjectsReader reader( _objects );
+        ObjectsHashCIter i = reader->find( id );
 
-        if( i != _objects->end( ))
+        if( i != reader->end( ))
         {
             const Objects& objects = i->second;
             LBASSERT( !objects.empty( ));
@@ -723,6 +798,22 @@ bool ObjectStore::_cmdDetachObject( ICommand& command )
     }
 
     LBASSERT( requestID != LB_UNDEFINED_UINT32 );
+
+    // Serve the request after the object's pool thread ran all commands
+    // queued for the object before it was detached
+    ICommand poolCommand( command );
+    poolCommand.setDispatchFunction(
+        CmdFunc( this, &ObjectStore::_cmdDetachObjectPool ));
+    if( !_localNode->_pushCommandPool( objectID, poolCommand ))
+        _localNode->serveRequest( requestID );
+    return true;
+}
+
+bool ObjectStore::_cmdDetachObjectPool( ICommand& command )
+{
+    command.get< UUID >();
+    command.get< uint32_t >();
+    const uint32_t requestID = command.get< uint32_t >();
     _localNode->serveRequest( requestID );
     return true;
 }
@@ -788,9 +879,9 @@ bool ObjectStore::_cmdMapObject( ICommand& cmd )
 
     ObjectCMPtr masterCM;
     {
-        lunchbox::ScopedFastRead mutex( _objects );
-        ObjectsHash::const_iterator i = _objects->find( id );
-        if( i != _objects->end( ))
+        const ObjectsReader reader( _objects );
+        ObjectsHash::const_iterator i = reader->find( id );
+        if( i != reader->end( ))
         {
             const Objects& objects = i->second;
 
@@ -925,9 +1016,9 @@ bool ObjectStore::_cmdUnsubscribeObject( ICommand& command )
     NodePtr node = command.getNode();
 
     {
-        lunchbox::ScopedFastWrite mutex( _objects );
-        ObjectsHash::const_iterator i = _objects->find( id );
-        if( i != _objects->end( ))
+        const ObjectsReader reader( _objects );
+        ObjectsHash::const_iterator i = reader->find( id );
+        if( i != reader->end( ))
         {
             const Objects& objects = i->second;
             for( ObjectsCIter j = objects.begin(); j != objects.end(); ++j )
@@ -957,15 +1048,12 @@ bool ObjectStore::_cmdUnmapObject( ICommand& command )
     if( _instanceCache )
         _instanceCache->erase( objectID );
 
-    ObjectsHash::iterator i = _objects->find( objectID );
+    ObjectsHashCIter i = _objects->find( objectID );
     if( i == _objects->end( )) // nothing to do
         return true;
 
     const Objects objects = i->second;
-    {
-        lunchbox::ScopedFastWrite mutex( _objects );
-        _objects->erase( i );
-    }
+    _objects.modify( EraseObjects( objectID ));
 
     for( Objects::const_iterator j = objects.begin(); j != objects.end(); ++j )
     {
@@ -1068,8 +1156,8 @@ bool ObjectStore::_cmdRemoveNode( ICommand& command )
     Node* node = command.get< Node* >();
     const uint32_t requestID = command.get< uint32_t >();
 
-    lunchbox::ScopedFastWrite mutex( _objects );
-    for( ObjectsHashCIter i = _objects->begin(); i != _objects->end(); ++i )
+    const ObjectsReader reader( _objects );
+    for( ObjectsHashCIter i = reader->begin(); i != reader->end(); ++i )
     {
         const Objects& objects = i->second;
         for( ObjectsCIter j = objects.begin(); j != objects.end(); ++j )
@@ -25,11 +25,9 @@
 #include <co/dispatcher.h>    // base class
 #include <co/version.h>       // enum
 
-#include <lunchbox/lockable.h>  // member
-#include <lunchbox/spinLock.h>  // member
-#include <lunchbox/stdExt.h>    // member
-
 #include "dataIStreamQueue.h"  // member
+#include "flatHash.h"          // member
+#include "leftRight.h"         // member
 
 namespace co
 {
@@ -178,15 +176,16 @@ namespace co
         /** enableSendOnRegister() invocations. */
         lunchbox::a_int32_t _sendOnRegister;
 
-        typedef stde::hash_map< lunchbox::uint128_t, Objects > ObjectsHash;
+        typedef FlatHash< uint128_t, Objects > ObjectsHash;
         typedef ObjectsHash::const_iterator ObjectsHashCIter;
 
         /** All registered and mapped objects.
-         *   - locked writes (only in receiver thread)
-         *   - unlocked reads in receiver thread
-         *   - locked reads in all other threads
+         *   - writes only in receiver thread, waiting for readers
+         *   - unsynchronized reads in receiver thread
+         *   - wait-free reads using a Reader in all other threads
          */
-        lunchbox::Lockable< ObjectsHash, lunchbox::SpinLock > _objects;
+        LeftRight< ObjectsHash > _objects;
+        typedef LeftRight< ObjectsHash >::Reader ObjectsReader;
 
         struct SendQueueItem
         {
@@ -220,6 +219,7 @@ namespace co
         bool _cmdFindMasterNodeIDReply( ICommand& command );
         bool _cmdAttachObject( ICommand& command );
         bool _cmdDetachObject( ICommand& command );
+        bool _cmdDetachObjectPool( ICommand& command );
         bool _cmdMapObject( ICommand& command );
         bool _cmdMapObjectSuccess( ICommand& command );
         bool _cmdMapObjectReply( ICommand& command );
@@ -173,6 +173,9 @@ bool PipeConnection::_createPipes()
 
     _sibling->_readFD  = pipeFDs[0];
     _writeFD = pipeFDs[1];
+
+    _initURing();
+    _sibling->_initURing();
     return true;
 }
 
@@ -181,6 +184,8 @@ void PipeConnection::_close()
     if( isClosed( ))
         return;
 
+    _setState( STATE_CLOSING ); // joins the send thread before the close
+    _exitURing();
     if( _writeFD > 0 )
     {
         ::close( _writeFD );
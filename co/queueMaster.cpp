@@ -116,10 +116,11 @@ void QueueMaster::attach( const UUID& id, const uint32_t instanceID )
 {
     Object::attach( id, instanceID );
 
-    CommandQueue* queue = getLocalNode()->getCommandThreadQueue();
+    CommandQueue* queue = getLocalNode()->getCommandPoolQueue();
     registerCommand( CMD_QUEUE_GET_ITEM,
                      CommandFunc< detail::QueueMaster >(
-                         _impl, &detail::QueueMaster::cmdGetItem ), queue );
+                         _impl, &detail::QueueMaster::cmdGetItem ), queue,
+                     COMMANDPRIORITY_HIGH );
 }
 
 void QueueMaster::clear()
@@ -0,0 +1,835 @@
+
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "relayConnection.h"
+
+#include "buffer.h"
+#include "connectionDescription.h"
+#include "global.h"
+
+#include <lunchbox/scopedMutex.h>
+
+#include <algorithm>
+
+namespace co
+{
+namespace
+{
+// Size of the parts of a data frame forwarded while receiving it
+static const uint64_t _relayChunkSize = LB_64KB;
+}
+
+RelayConnection::RelayConnection()
+    : _id( 0 )
+    , _event( new EventConnection )
+    , _thread( 0 )
+    , _running( 0 )
+    , _cutOff( false )
+    , _readBuffer( 0 )
+    , _readBufferPos( 0 )
+{
+    ConnectionDescriptionPtr description = _getDescription();
+    description->type = CONNECTIONTYPE_RELAY;
+    description->bandwidth = 102400;
+
+    LBCHECK( _event->connect( ));
+}
+
+RelayConnection::~RelayConnection()
+{
+    _close();
+    _clearFrames();
+}
+
+void RelayConnection::_close()
+{
+    if( isClosed( ))
+        return;
+
+    if( _parent.isValid( )) // reader
+    {
+        _setState( STATE_CLOSED );
+        _parent = 0;
+        {
+            lunchbox::ScopedWrite mutex( _mutexEvent ); // vs. _pushFrame()
+            _event->close();
+        }
+        _clearFrames();
+        return;
+    }
+
+    _setState( STATE_CLOSING );
+    if( _thread )
+    {
+        _running = 0;
+        _links.interrupt();
+        _thread->join();
+        delete _thread;
+        _thread = 0;
+    }
+
+    // leave the group, flushing all data before the links are closed
+    _forward( FRAME_EXIT, _id, 0, 0, 0 );
+    for( ConnectionsIter i = _tree.begin(); i != _tree.end(); ++i )
+        (*i)->finish();
+
+    const Connections links = _links.getConnections();
+    for( ConnectionsCIter i = links.begin(); i != links.end(); ++i )
+        if( *i != _listener )
+            _removeLink( *i );
+
+    if( _listener )
+    {
+        _links.removeConnection( _listener );
+        _listener->close();
+        _listener = 0;
+    }
+
+    // notify readers to close
+    for( RelayConnectionsIter i = _children.begin(); i != _children.end(); ++i)
+        (*i)->_pushFrame( 0 );
+    _children.clear();
+    {
+        lunchbox::ScopedWrite mutex( _mutexConnection );
+        _newChildren.clear();
+    }
+    _self = 0;
+    _members.clear();
+
+    _setState( STATE_CLOSED );
+    _event->close();
+}
+
+bool RelayConnection::listen()
+{
+    ConnectionDescriptionPtr description = _getDescription();
+    LBASSERT( description->type == CONNECTIONTYPE_RELAY );
+
+    if( !isClosed( ))
+        return false;
+
+    _setState( STATE_CONNECTING );
+
+    if( description->port == 0 )
+        description->port = EQ_DEFAULT_PORT;
+    if( description->getHostname().empty( ))
+        description->setHostname( "127.0.0.1" );
+
+    if( !_listenRoot( description ) && !_join( description ))
+    {
+        LBWARN << "Can't set up relay group " << description->getHostname()
+               << ":" << description->port << std::endl;
+        close();
+        return false;
+    }
+
+    _self = _getChild( _id );
+    _cutOff = false;
+    _running = 1;
+    _thread = new Thread( this );
+    if( !_thread->start( ))
+    {
+        close();
+        return false;
+    }
+
+    _setState( STATE_LISTENING );
+    LBINFO << "Member " << _id << " of relay group "
+           << description->getHostname() << ":" << description->port
+           << std::endl;
+    return true;
+}
+
+bool RelayConnection::_listenRoot( ConstConnectionDescriptionPtr description )
+{
+    // The first member binding the group address becomes the root
+    ConnectionDescriptionPtr rootDescription = new ConnectionDescription;
+    rootDescription->type = CONNECTIONTYPE_TCPIP;
+    rootDescription->setHostname( description->getHostname( ));
+    rootDescription->port = description->port;
+
+    ConnectionPtr listener = Connection::create( rootDescription );
+    if( !listener || !listener->listen( ))
+        return false;
+
+    _id = 0;
+    _listener = listener;
+    _listener->acceptNB();
+    _links.addConnection( _listener );
+
+    const Member root = { description->getHostname(), description->port, 0, 0,
+                          true };
+    _members.push_back( root );
+    return true;
+}
+
+bool RelayConnection::_join( ConstConnectionDescriptionPtr description )
+{
+    // listener for members placed below this one
+    ConnectionDescriptionPtr listenDescription = new ConnectionDescription;
+    listenDescription->type = CONNECTIONTYPE_TCPIP;
+    listenDescription->setHostname( description->getInterface( ));
+
+    ConnectionPtr listener = Connection::create( listenDescription );
+    if( !listener || !listener->listen( ))
+        return false;
+
+    _listener = listener;
+    _listener->acceptNB();
+    _links.addConnection( _listener );
+
+    // ask the root for a place in the tree
+    ConnectionPtr link = _connectTo( description->getHostname(),
+                                     description->port );
+    if( !link )
+        return false;
+    _addLink( link );
+
+    return _send( link, FRAME_JOIN, listenDescription->port, 0, 0 ) &&
+           _attach( link );
+}
+
+bool RelayConnection::_rejoin()
+{
+    ConstConnectionDescriptionPtr description = getDescription();
+    ConnectionPtr link = _connectTo( description->getHostname(),
+                                     description->port );
+    if( !link )
+        return false;
+    _addLink( link );
+
+    uint32_t port = _listener->getDescription()->port;
+#ifdef COLLAGE_BIGENDIAN
+    lunchbox::byteswap( port );
+#endif
+    if( _send( link, FRAME_REJOIN, _id, &port, sizeof( port )))
+        return _attach( link );
+
+    _removeLink( link );
+    return false;
+}
+
+bool RelayConnection::_attach( ConnectionPtr link )
+{
+    Frame frame;
+    Buffer payload;
+    if( !_readFrame( link, frame, payload ) || frame.type != FRAME_PLACE ||
+        payload.getSize() < sizeof( uint32_t ))
+    {
+        _removeLink( link );
+        return false;
+    }
+
+    _id = frame.source;
+    uint32_t port;
+    ::memcpy( &port, payload.getData(), sizeof( port ));
+#ifdef COLLAGE_BIGENDIAN
+    lunchbox::byteswap( port );
+#endif
+
+    if( port != 0 ) // attach below another member
+    {
+        const std::string hostname(
+            reinterpret_cast< const char* >( payload.getData( )) +
+            sizeof( port ), payload.getSize() - sizeof( port ));
+
+        _removeLink( link );
+        link = _connectTo( hostname, port );
+        if( !link || !_send( link, FRAME_ATTACH, _id, 0, 0 ))
+            return false;
+        _addLink( link );
+    }
+
+    _addTree( link );
+    lunchbox::ScopedWrite mutex( _mutexTree );
+    _up = link;
+    return true;
+}
+
+ConnectionPtr RelayConnection::_connectTo( const std::string& hostname,
+                                           const uint32_t port )
+{
+    ConnectionDescriptionPtr description = new ConnectionDescription;
+    description->type = CONNECTIONTYPE_TCPIP;
+    description->setHostname( hostname );
+    description->port = uint16_t( port );
+
+    ConnectionPtr link = Connection::create( description );
+    if( link && link->connect( ))
+        return link;
+
+    LBWARN << "Can't connect to relay member " << hostname << ":" << port
+           << std::endl;
+    return 0;
+}
+
+ConnectionPtr RelayConnection::acceptSync()
+{
+    if( !isListening( ))
+        return 0;
+
+    lunchbox::ScopedWrite mutex( _mutexConnection );
+    LBASSERT( !_newChildren.empty( ));
+    if( _newChildren.empty( ))
+        return 0;
+
+    RelayConnectionPtr newConnection = _newChildren.back();
+    _newChildren.pop_back();
+
+    LBINFO << _id << " accepted relay connection " << newConnection->_id
+           << std::endl;
+
+    lunchbox::ScopedWrite mutex2( _mutexEvent );
+    if( _newChildren.empty() )
+        _event->reset();
+    else
+        _event->set();
+
+    return newConnection;
+}
+
+int64_t RelayConnection::readSync( void* buffer, const uint64_t bytes,
+                                   const bool )
+{
+    LBASSERT( bytes > 0 );
+    if( !isConnected( ))
+        return -1;
+
+    uint64_t bytesLeft = bytes;
+    uint8_t* ptr = reinterpret_cast< uint8_t* >( buffer );
+
+    while( bytesLeft )
+    {
+        if( !_readBuffer )
+        {
+            LBASSERT( _readBufferPos == 0 );
+            _readBuffer = _frames.pop();
+            if( !_readBuffer )
+            {
+                close();
+                return (bytes == bytesLeft) ?
+                    -1 : static_cast< int64_t >( bytes - bytesLeft );
+            }
+        }
+
+        const uint64_t size = LB_MIN( bytesLeft,
+                                      _readBuffer->getSize() - _readBufferPos );
+        ::memcpy( ptr, _readBuffer->getData() + _readBufferPos, size );
+        _readBufferPos += size;
+        ptr += size;
+        bytesLeft -= size;
+
+        if( _readBufferPos >= _readBuffer->getSize( ))
+        {
+            delete _readBuffer;
+            _readBuffer = 0;
+            _readBufferPos = 0;
+        }
+    }
+
+    if( _readBuffer || !_frames.isEmpty( ))
+        _event->set();
+    else
+    {
+        lunchbox::ScopedWrite mutex( _mutexEvent );
+        if( _frames.isEmpty( ))
+            _event->reset();
+    }
+    return bytes;
+}
+
+int64_t RelayConnection::write( const void* buffer, const uint64_t bytes )
+{
+    if( _parent )
+        return _parent->write( buffer, bytes );
+
+    LBASSERT( isListening( ));
+    Connections tree;
+    {
+        lunchbox::ScopedWrite mutex( _mutexTree );
+        if( !isListening() || _cutOff )
+            return -1;
+        tree = _tree;
+    }
+
+    Buffer* frame = new Buffer;
+    frame->replace( buffer, bytes );
+    _self->_pushFrame( frame );
+
+    // failed links are removed by the relay thread
+    for( ConnectionsCIter i = tree.begin(); i != tree.end(); ++i )
+        _send( *i, FRAME_DATA, _id, buffer, bytes );
+    return bytes;
+}
+
+//----------------------------------------------------------------------
+// relay thread
+//----------------------------------------------------------------------
+void RelayConnection::_runThread()
+{
+    while( _running )
+    {
+        switch( _links.select( ))
+        {
+            case ConnectionSet::EVENT_CONNECT:
+                _acceptLink();
+                break;
+
+            case ConnectionSet::EVENT_DATA:
+            {
+                ConnectionPtr link = _links.getConnection();
+                if( !_handleFrame( link ))
+                    _removeLink( link );
+                break;
+            }
+
+            case ConnectionSet::EVENT_DISCONNECT:
+            case ConnectionSet::EVENT_INVALID_HANDLE:
+            case ConnectionSet::EVENT_ERROR:
+                _removeLink( _links.getConnection( ));
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+void RelayConnection::_acceptLink()
+{
+    ConnectionPtr link = _listener->acceptSync();
+    _listener->acceptNB();
+
+    // becomes a tree link on FRAME_JOIN or FRAME_ATTACH
+    if( link )
+        _addLink( link );
+}
+
+void RelayConnection::_addLink( ConnectionPtr link )
+{
+    Buffer* header = new Buffer;
+    _headers[ link.get() ] = header;
+    link->recvNB( header, sizeof( Frame ));
+    _links.addConnection( link );
+}
+
+void RelayConnection::_addTree( ConnectionPtr link )
+{
+    // forwarding must not block on a slow member while others wait for data
+    link->setSendQueueSize( Global::getIAttribute(
+                                Global::IATTR_NODE_SEND_ASYNC_QUEUE_SIZE ));
+
+    lunchbox::ScopedWrite mutex( _mutexTree );
+    _tree.push_back( link );
+}
+
+void RelayConnection::_removeLink( ConnectionPtr link )
+{
+    if( !link )
+        return;
+
+    _links.removeConnection( link );
+    if( link == _listener )
+    {
+        LBWARN << "Relay listener failed, no more members can join"
+               << std::endl;
+        return;
+    }
+
+    LinkBuffers::iterator i = _headers.find( link.get( ));
+    if( i != _headers.end( ))
+    {
+        link->resetRecvData();
+        delete i->second;
+        _headers.erase( i );
+    }
+
+    bool lost = false;
+    {
+        lunchbox::ScopedWrite mutex( _mutexTree );
+        Connections::iterator j = std::find( _tree.begin(), _tree.end(),
+                                             link );
+        if( j != _tree.end( ))
+            _tree.erase( j );
+        if( link == _up )
+        {
+            _up = 0;
+            lost = true;
+        }
+    }
+    link->close();
+
+    if( !lost || !isListening( ))
+        return;
+
+    // keep the subtree attached to this member, and find a new place for it
+    LBWARN << "Lost relay link towards the root, member " << _id
+           << " joins again" << std::endl;
+    if( _rejoin( ))
+        return;
+
+    // cut off from the root: leave the group with the whole subtree
+    LBWARN << "Relay member " << _id << " can't reach the root and leaves "
+           << "the group" << std::endl;
+    Connections tree;
+    {
+        lunchbox::ScopedWrite mutex( _mutexTree );
+        _cutOff = true;
+        tree = _tree;
+    }
+    for( ConnectionsCIter k = tree.begin(); k != tree.end(); ++k )
+        _removeLink( *k );
+
+    for( RelayConnectionsIter k = _children.begin(); k != _children.end(); ++k)
+        (*k)->_pushFrame( 0 );
+    _children.clear();
+}
+
+bool RelayConnection::_readFrame( ConnectionPtr link, Frame& frame,
+                                  Buffer& payload )
+{
+    return _readHeader( link, frame ) && _readPayload( link, frame, payload );
+}
+
+bool RelayConnection::_readHeader( ConnectionPtr link, Frame& frame )
+{
+    BufferPtr header;
+    if( !link->recvSync( header ) || header->getSize() != sizeof( Frame ))
+        return false;
+
+    ::memcpy( &frame, header->getData(), sizeof( frame ));
+    frame.byteswap();
+    header->setSize( 0 );
+    return true;
+}
+
+bool RelayConnection::_readPayload( ConnectionPtr link, const Frame& frame,
+                                    Buffer& payload )
+{
+    bool ok = true;
+    payload.setSize( 0 );
+    if( frame.size > 0 )
+    {
+        BufferPtr data;
+        link->recvNB( &payload, frame.size );
+        ok = link->recvSync( data );
+    }
+
+    link->recvNB( _headers[ link.get() ], sizeof( Frame )); // next frame
+    return ok;
+}
+
+bool RelayConnection::_relayData( ConnectionPtr link, const Frame& frame,
+                                  Buffer& payload )
+{
+    Connections targets;
+    {
+        lunchbox::ScopedWrite mutex( _mutexTree );
+        for( ConnectionsCIter i = _tree.begin(); i != _tree.end(); ++i )
+            if( *i != link )
+                targets.push_back( *i );
+    }
+
+    // Keep the targets locked for the whole frame, local writes would
+    // otherwise end up within it. Failed targets are removed later.
+    Frame header = frame;
+    header.byteswap();
+    for( ConnectionsIter i = targets.begin(); i != targets.end(); ++i )
+    {
+        (*i)->lockSend();
+        (*i)->send( &header, sizeof( header ), true );
+    }
+
+    bool ok = true;
+    payload.setSize( 0 );
+    payload.reserve( frame.size );
+    while( ok && payload.getSize() < frame.size )
+    {
+        const uint64_t offset = payload.getSize();
+        const uint64_t size = LB_MIN( frame.size - offset, _relayChunkSize );
+        BufferPtr data;
+        link->recvNB( &payload, size );
+        ok = link->recvSync( data );
+        if( !ok )
+            break;
+
+        for( ConnectionsIter i = targets.begin(); i != targets.end(); ++i )
+            (*i)->send( payload.getData() + offset, size, true );
+    }
+
+    for( ConnectionsIter i = targets.begin(); i != targets.end(); ++i )
+        (*i)->unlockSend();
+    link->recvNB( _headers[ link.get() ], sizeof( Frame )); // next frame
+
+    if( !ok ) // the targets got a partial frame and have to join again
+        for( ConnectionsIter i = targets.begin(); i != targets.end(); ++i )
+            _removeLink( *i );
+    return ok;
+}
+
+bool RelayConnection::_handleFrame( ConnectionPtr link )
+{
+    Frame frame;
+    if( !_readHeader( link, frame ))
+        return false;
+
+    Buffer* payload = new Buffer;
+    const bool ok = frame.type == FRAME_DATA ?
+                        _relayData( link, frame, *payload ) :
+                        _readPayload( link, frame, *payload );
+    if( !ok )
+    {
+        delete payload;
+        return false;
+    }
+
+    switch( frame.type )
+    {
+        case FRAME_DATA:
+            if( payload->isEmpty( ))
+                break;
+            _getChild( frame.source )->_pushFrame( payload );
+            return true;
+
+        case FRAME_EXIT:
+            _forward( FRAME_EXIT, frame.source, 0, 0, link );
+            _removeChild( frame.source );
+            if( !_members.empty( )) // root
+                _removeMember( frame.source );
+            break;
+
+        case FRAME_JOIN:
+            if( _members.empty( ))
+            {
+                LBWARN << "Join request on relay member " << _id
+                       << ", which is not the root" << std::endl;
+                delete payload;
+                return false;
+            }
+            _place( link, frame.source, 0 );
+            break;
+
+        case FRAME_REJOIN:
+        {
+            uint32_t port = 0;
+            if( _members.empty() || frame.source == 0 ||
+                frame.source >= _members.size() ||
+                payload->getSize() < sizeof( port ))
+            {
+                LBWARN << "Invalid rejoin request of relay member "
+                       << frame.source << " on " << _id << std::endl;
+                delete payload;
+                return false;
+            }
+            ::memcpy( &port, payload->getData(), sizeof( port ));
+#ifdef COLLAGE_BIGENDIAN
+            lunchbox::byteswap( port );
+#endif
+            _place( link, port, frame.source );
+            break;
+        }
+
+        case FRAME_ATTACH:
+            LBINFO << "Relay member " << frame.source << " attached to "
+                   << _id << std::endl;
+            _addTree( link );
+            break;
+
+        default:
+            LBWARN << "Unexpected relay frame of type " << frame.type
+                   << std::endl;
+            delete payload;
+            return false;
+    }
+
+    delete payload;
+    return true;
+}
+
+void RelayConnection::_place( ConnectionPtr link, const uint32_t port,
+                              uint32_t id )
+{
+    if( id == 0 ) // new member
+    {
+        id = uint32_t( _members.size( ));
+        const Member member = { link->getDescription()->getHostname(), port,
+                                0, 0, true };
+        _members.push_back( member );
+    }
+    else // lost its parent, which is not used for new places anymore
+    {
+        Member& member = _members[ id ];
+        Member& oldParent = _members[ member.parent ];
+        if( oldParent.nChildren > 0 )
+            --oldParent.nChildren;
+        _removeMember( member.parent );
+
+        member.hostname = link->getDescription()->getHostname();
+        member.port = port;
+        member.alive = true;
+    }
+
+    // fill the tree breadth-first, in join order, outside of the subtree of
+    // a rejoining member
+    const uint32_t fanout = LB_MAX( 1, Global::getIAttribute(
+                                           Global::IATTR_RELAY_FANOUT ));
+    size_t parent = 0;
+    while( parent < _members.size() &&
+           ( !_members[ parent ].alive ||
+             _members[ parent ].nChildren >= fanout ||
+             _isBelow( uint32_t( parent ), id )))
+    {
+        ++parent;
+    }
+    if( parent == _members.size( )) // all other members are full
+        parent = 0;
+    ++_members[ parent ].nChildren;
+    _members[ id ].parent = uint32_t( parent );
+
+    // reply the parent's address, or port 0 to stay attached to the root
+    const Member& parentMember = _members[ parent ];
+    uint32_t parentPort = parent ? parentMember.port : 0;
+#ifdef COLLAGE_BIGENDIAN
+    lunchbox::byteswap( parentPort );
+#endif
+    std::vector< uint8_t > data( sizeof( parentPort ));
+    ::memcpy( &data.front(), &parentPort, sizeof( parentPort ));
+    if( parent )
+        data.insert( data.end(), parentMember.hostname.begin(),
+                     parentMember.hostname.end( ));
+
+    LBINFO << "Placing relay member " << id << " below " << parent
+           << std::endl;
+    _send( link, FRAME_PLACE, id, &data.front(), data.size( ));
+    if( parent == 0 )
+        _addTree( link );
+    // else the new member closes the link and attaches to its parent
+}
+
+void RelayConnection::_removeMember( const uint32_t id )
+{
+    if( id == 0 || id >= _members.size() || !_members[ id ].alive )
+        return;
+
+    Member& member = _members[ id ];
+    member.alive = false;
+    Member& parent = _members[ member.parent ];
+    if( parent.nChildren > 0 )
+        --parent.nChildren;
+}
+
+bool RelayConnection::_isBelow( uint32_t member, const uint32_t id ) const
+{
+    while( member != id )
+    {
+        if( member == 0 )
+            return false;
+        member = _members[ member ].parent;
+    }
+    return true;
+}
+
+bool RelayConnection::_send( ConnectionPtr link, const FrameType type,
+                             const uint32_t source, const void* data,
+                             const uint64_t size )
+{
+    Frame frame = { uint32_t( type ), source, size };
+    frame.byteswap();
+
+    link->lockSend();
+    const bool ok = link->send( &frame, sizeof( frame ), true ) &&
+                    ( size == 0 || link->send( data, size, true ));
+    link->unlockSend();
+    return ok;
+}
+
+void RelayConnection::_forward( const FrameType type, const uint32_t source,
+                                const void* data, const uint64_t size,
+                                ConnectionPtr except )
+{
+    Connections tree;
+    {
+        lunchbox::ScopedWrite mutex( _mutexTree );
+        tree = _tree;
+    }
+
+    for( ConnectionsCIter i = tree.begin(); i != tree.end(); ++i )
+        if( *i != except )
+            _send( *i, type, source, data, size );
+}
+
+RelayConnectionPtr RelayConnection::_getChild( const uint32_t source )
+{
+    for( RelayConnectionsIter i = _children.begin(); i != _children.end(); ++i)
+        if( (*i)->_id == source )
+            return *i;
+
+    RelayConnectionPtr child = new RelayConnection;
+    child->_id = source;
+    child->_parent = this;
+    child->_setState( STATE_CONNECTED );
+    child->_setDescription( _getDescription( ));
+    _children.push_back( child );
+
+    lunchbox::ScopedWrite mutex( _mutexConnection );
+    _newChildren.push_back( child );
+
+    lunchbox::ScopedWrite mutex2( _mutexEvent );
+    _event->set();
+    return child;
+}
+
+void RelayConnection::_removeChild( const uint32_t source )
+{
+    for( RelayConnectionsIter i = _children.begin(); i != _children.end(); ++i)
+    {
+        if( (*i)->_id != source )
+            continue;
+
+        LBINFO << "Relay member " << source << " left" << std::endl;
+        (*i)->_pushFrame( 0 );
+        _children.erase( i );
+        return;
+    }
+}
+
+void RelayConnection::_pushFrame( Buffer* buffer )
+{
+    lunchbox::ScopedWrite mutex( _mutexEvent );
+    if( isClosed( )) // reader closed by the application
+    {
+        delete buffer;
+        return;
+    }
+    _frames.push( buffer );
+    _event->set();
+}
+
+void RelayConnection::_clearFrames()
+{
+    delete _readBuffer;
+    _readBuffer = 0;
+    _readBufferPos = 0;
+
+    Buffer* buffer = 0;
+    while( _frames.tryPop( buffer ))
+        delete buffer;
+}
+
+}
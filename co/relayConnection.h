@@ -0,0 +1,226 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_RELAYCONNECTION_H
+#define CO_RELAYCONNECTION_H
+
+#include <co/connection.h>      // base class
+#include <co/connectionSet.h>   // member
+#include <co/eventConnection.h> // member
+
+#include <lunchbox/atomic.h>  // member
+#include <lunchbox/lock.h>    // member
+#include <lunchbox/mtQueue.h> // member
+#include <lunchbox/thread.h>  // member
+
+#include <map>
+
+namespace co
+{
+    class RelayConnection;
+    typedef lunchbox::RefPtr< RelayConnection > RelayConnectionPtr;
+
+    /**
+     * A multicast connection relaying data over a tree of TCP connections.
+     *
+     * Provides multicast semantics on networks without IP multicast. The
+     * connection description names the group by the address of its root. The
+     * first member binds this address, all others join through it and are
+     * placed into a tree of Global::IATTR_RELAY_FANOUT children per
+     * member. Each member forwards the data received on one tree link to all
+     * other links while consuming it, so that every write crosses each link
+     * exactly once.
+     *
+     * Like for the RSPConnection, the listening connection is used for
+     * writing, and acceptSync() returns a reader connection for each group
+     * member, including the local one.
+     *
+     * A member losing its link towards the root, e.g., because its parent
+     * left, joins the root again under its identifier and is placed outside
+     * of its own subtree, which stays attached to it. Data relayed while the
+     * tree is repaired may be lost for this subtree. A member which cannot
+     * reach the root is cut off from the group: its readers are closed and
+     * further writes fail.
+     */
+    class RelayConnection : public Connection
+    {
+    public:
+        /** Create a new relay connection. */
+        RelayConnection();
+
+        bool listen() override;
+        void close() override { _close(); }
+
+        /** Identical to listen() for multicast connections. */
+        bool connect() override { return listen(); }
+
+        void acceptNB() override { LBASSERT( isListening( )); }
+
+        ConnectionPtr acceptSync() override;
+        void readNB( void*, const uint64_t ) override {/* NOP */}
+        int64_t readSync( void* buffer, const uint64_t bytes,
+                          const bool ignored ) override;
+        int64_t write( const void* buffer, const uint64_t bytes ) override;
+
+        /**
+         * @internal
+         * @return the unique identifier of this connection within the group.
+         */
+        uint32_t getID() const { return _id; }
+
+        Notifier getNotifier() const override
+            { return _event->getNotifier(); }
+
+    protected:
+        virtual ~RelayConnection();
+
+    private:
+        /** Thread receiving and forwarding the data of all tree links. */
+        class Thread : public lunchbox::Thread
+        {
+        public:
+            explicit Thread( RelayConnection* connection )
+                : _connection( connection ) {}
+        protected:
+            void run() override { _connection->_runThread(); }
+
+        private:
+            RelayConnection* const _connection;
+        };
+
+        /** The type of each frame on a link */
+        enum FrameType
+        {
+            FRAME_DATA,   //!< data written by source
+            FRAME_EXIT,   //!< source left the group
+            FRAME_JOIN,   //!< ask the root for a place, source is the port
+            FRAME_PLACE,  //!< root reply, source is the new id
+            FRAME_ATTACH, //!< attach source below the receiving member
+            FRAME_REJOIN  //!< ask the root for a new place for source
+        };
+
+        /** Header of each frame, followed by size bytes of payload */
+        struct Frame
+        {
+            uint32_t type;
+            uint32_t source;
+            uint64_t size;
+
+            void byteswap()
+            {
+#ifdef COLLAGE_BIGENDIAN
+                lunchbox::byteswap( type );
+                lunchbox::byteswap( source );
+                lunchbox::byteswap( size );
+#endif
+            }
+        };
+
+        /** A member known to the root, used to place new members. */
+        struct Member
+        {
+            std::string hostname;
+            uint32_t port;
+            uint32_t nChildren;
+            uint32_t parent; //!< the member it is attached to
+            bool alive;      //!< false once it left or lost its children
+        };
+        typedef std::vector< Member > Members;
+
+        typedef std::vector< RelayConnectionPtr > RelayConnections;
+        typedef RelayConnections::iterator RelayConnectionsIter;
+        typedef std::map< const Connection*, Buffer* > LinkBuffers;
+
+        RelayConnectionPtr _parent;  //!< listener of a reader connection
+        RelayConnections _children;  //!< readers, by source
+        RelayConnections _newChildren; //!< readers not yet accepted
+        RelayConnectionPtr _self;    //!< reader of the local writes
+
+        uint32_t _id; //!< The identifier used to demultiplex the writers
+
+        typedef lunchbox::RefPtr< EventConnection > EventConnectionPtr;
+        EventConnectionPtr _event;
+
+        ConnectionPtr _listener; //!< TCP listener for joining members
+        ConnectionPtr _up;       //!< Link towards the root, 0 on the root
+        Connections _tree;       //!< All tree links, for forwarding
+        LinkBuffers _headers;    //!< Frame header buffer of each link
+        ConnectionSet _links;    //!< All links and the listener
+        Members _members;        //!< Placement state of the root
+
+        Thread* _thread;
+        lunchbox::a_int32_t _running;
+        bool _cutOff; //!< lost the root, protected by _mutexTree
+        lunchbox::Lock _mutexTree;
+        lunchbox::Lock _mutexConnection;
+        lunchbox::Lock _mutexEvent;
+
+        lunchbox::MTQueue< Buffer* > _frames; //!< Received data (reader)
+        Buffer* _readBuffer;     //!< Read (app) buffer
+        uint64_t _readBufferPos; //!< Current read index
+
+        void _close();
+        bool _listenRoot( ConstConnectionDescriptionPtr description );
+        bool _join( ConstConnectionDescriptionPtr description );
+        bool _rejoin();
+        /** Attach to the place replied by the root on the given link. */
+        bool _attach( ConnectionPtr link );
+        ConnectionPtr _connectTo( const std::string& hostname,
+                                  const uint32_t port );
+
+        void _runThread();
+        void _acceptLink();
+        void _addLink( ConnectionPtr link );
+        void _addTree( ConnectionPtr link );
+        void _removeLink( ConnectionPtr link );
+        bool _readFrame( ConnectionPtr link, Frame& frame, Buffer& payload );
+        bool _readHeader( ConnectionPtr link, Frame& frame );
+        bool _readPayload( ConnectionPtr link, const Frame& frame,
+                           Buffer& payload );
+        bool _handleFrame( ConnectionPtr link );
+
+        /** Receive a data frame, forwarding each part while consuming it. */
+        bool _relayData( ConnectionPtr link, const Frame& frame,
+                         Buffer& payload );
+
+        /** Place a new (id 0) or rejoining member and reply its place. */
+        void _place( ConnectionPtr link, const uint32_t port, uint32_t id );
+        void _removeMember( const uint32_t id );
+
+        /** @return true if member is id or attached below it. */
+        bool _isBelow( uint32_t member, const uint32_t id ) const;
+
+        /** Send a frame to the given link. */
+        static bool _send( ConnectionPtr link, const FrameType type,
+                           const uint32_t source, const void* data,
+                           const uint64_t size );
+
+        /** Send a frame to all tree links except the given one. */
+        void _forward( const FrameType type, const uint32_t source,
+                       const void* data, const uint64_t size,
+                       ConnectionPtr except );
+
+        /** @return the reader for the given source, created on demand. */
+        RelayConnectionPtr _getChild( const uint32_t source );
+        void _removeChild( const uint32_t source );
+        void _pushFrame( Buffer* buffer );
+        void _clearFrames();
+    };
+}
+
+#endif //CO_RELAYCONNECTION_H
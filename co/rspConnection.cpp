@@ -25,6 +25,7 @@
 #include "connectionDescription.h"
 #include "global.h"
 #include "log.h"
+#include "rspRateControl.h"
 
 #include <lunchbox/rng.h>
 #include <lunchbox/scopedMutex.h>
@@ -67,6 +68,30 @@ lunchbox::Clock instrumentClock;
 #endif
 
 static uint16_t _numBuffers = 0;
+
+lunchbox::Clock _timeClock; // for round trip time measurements
+
+/** @return the current time in microseconds, wrapping around. */
+inline uint32_t _getTime()
+{
+    return uint32_t( uint64_t( _timeClock.getTimed() * 1000. ));
+}
+
+/** XOR size bytes of from into to. */
+void _xor( uint8_t* to, const uint8_t* from, const size_t size )
+{
+    size_t i = 0;
+    for( ; i + sizeof( uint64_t ) <= size; i += sizeof( uint64_t ))
+    {
+        uint64_t a, b;
+        ::memcpy( &a, to + i, sizeof( a ));
+        ::memcpy( &b, from + i, sizeof( b ));
+        a ^= b;
+        ::memcpy( to + i, &a, sizeof( a ));
+    }
+    for( ; i < size; ++i )
+        to[i] ^= from[i];
+}
 }
 
 RSPConnection::RSPConnection()
@@ -84,6 +109,7 @@ RSPConnection::RSPConnection()
     , _maxBucketSize( ( _mtu * _ackFreq) >> 1 )
     , _bucketSize( 0 )
     , _sendRate( 0 )
+    , _rateControl( 0 )
     , _thread( 0 )
     , _acked( std::numeric_limits< uint16_t >::max( ))
     , _threadBuffers( Global::getIAttribute( Global::IATTR_RSP_NUM_BUFFERS))
@@ -91,10 +117,30 @@ RSPConnection::RSPConnection()
     , _readBuffer( 0 )
     , _readBufferPos( 0 )
     , _sequence( 0 )
+    , _maxSequence( std::numeric_limits< uint16_t >::max( ))
+    , _nExpected( 0 )
+    , _nLossEvents( 0 )
+    , _echoSequence( 0 )
+    , _echoReceived( 0 )
+#ifdef CO_RSP_SIMULATE_LOSS
+    , _simulatedLoss( Global::getIAttribute(
+                          Global::IATTR_RSP_SIMULATED_LOSS ))
+    , _lossSeed( 0 )
+#endif
+    , _nDatagrams( 0 )
+    , _nRepeats( 0 )
+    , _nParities( 0 )
+    , _nRebuilt( 0 )
+    , _fecGroupSize( 0 )
+    , _parityIndex( 0 )
+    , _fecBuffer( _mtu )
     // ensure we have a handleConnectedTimeout before the write pop
     , _writeTimeOut( Global::IATTR_RSP_ACK_TIMEOUT * EQ_RSP_MAX_TIMEOUTS * 2 )
 {
     _buildNewID();
+#ifdef CO_RSP_SIMULATE_LOSS
+    _lossSeed = _id | 1u;
+#endif
     ConnectionDescriptionPtr description = _getDescription();
     description->type = CONNECTIONTYPE_RSP;
     description->bandwidth = 102400;
@@ -122,6 +168,16 @@ RSPConnection::~RSPConnection()
         delete _buffers.back();
         _buffers.pop_back();
     }
+    while( !_parityBuffers.empty( ))
+    {
+        delete _parityBuffers.back();
+        _parityBuffers.pop_back();
+    }
+    while( !_fecBuffers.empty( ))
+    {
+        delete _fecBuffers.back();
+        _fecBuffers.pop_back();
+    }
 }
 
 void RSPConnection::_close()
@@ -164,6 +220,11 @@ void RSPConnection::_close()
     }
 
     _parent = 0;
+    _batch.exit();
+    delete _rateControl;
+    _rateControl = 0;
+    _sendTimes.clear();
+    _writeAddr = ip::udp::endpoint();
 
     if( _read )
         _read->close();
@@ -267,6 +328,10 @@ bool RSPConnection::listen()
         _write->set_option( ip::multicast::outbound_interface( ifAddr.to_v4()));
 
         _write->connect( writeEndpoint );
+        if( ifAddr.is_loopback( ))
+            // Multicast loopback is disabled, but datagrams sent through the
+            // loopback interface are still received by our own socket.
+            _writeAddr = _write->local_endpoint();
 
         _read->set_option( ip::multicast::enable_loopback( false ));
         _write->set_option( ip::multicast::enable_loopback( false ));
@@ -282,10 +347,40 @@ bool RSPConnection::listen()
         return false;
     }
 
+    const int32_t batchSize =
+        Global::getIAttribute( Global::IATTR_RSP_BATCH_SIZE );
+    if( batchSize > 1 )
+        _batch.init( _read->native_handle(), _write->native_handle(), _mtu,
+                     batchSize );
+
+    const int32_t fecGroupSize =
+        Global::getIAttribute( Global::IATTR_RSP_FEC_GROUP_SIZE );
+    if( fecGroupSize > 1 )
+    {
+        _fecGroupSize = uint16_t( LB_MIN( fecGroupSize,
+                                          EQ_RSP_MAX_FEC_GROUP ));
+        // parities stay valid until the batch holding them is flushed
+        const size_t nParities = LB_MAX( batchSize, 1 ) / _fecGroupSize + 2;
+        while( _parityBuffers.size() < nParities )
+            _parityBuffers.push_back( new Buffer( _mtu ));
+        _parityIndex = 0;
+        reinterpret_cast< DatagramParity* >(
+            _parityBuffers.front()->getData( ))->count = 0;
+        _payloadSize = _mtu - sizeof( DatagramParity );
+    }
+
     // init communication protocol thread
     _thread = new Thread( this );
     _bucketSize = 0;
     _sendRate = description->bandwidth;
+    if( Global::getIAttribute( Global::IATTR_RSP_RATE_CONTROL ))
+    {
+        const int64_t minRate = description->bandwidth >>
+                  Global::getIAttribute( Global::IATTR_RSP_MIN_SENDRATE_SHIFT );
+        _rateControl = new RSPRateControl( minRate, description->bandwidth,
+                                           _mtu );
+        _sendTimes.resize( _numBuffers );
+    }
 
     // waits until RSP protocol establishes connection to the multicast network
     if( !_thread->start( ) )
@@ -636,7 +731,14 @@ void RSPConnection::_processOutgoing()
     _clock.reset();
     ++_timeouts;
     if ( _timeouts < EQ_RSP_MAX_TIMEOUTS )
+    {
+        if( _fecGroupSize ) // protect the tail before asking for nacks
+        {
+            _sendParity();
+            _flushDatagrams();
+        }
         _sendAckRequest();
+    }
     _setTimeout( timeout );
 }
 
@@ -647,11 +749,33 @@ void RSPConnection::_writeData()
         return;
 
     _timeouts = 0;
+    while( buffer )
+    {
+        _writeDatagram( buffer );
+
+        // batch more datagrams as long as the token bucket allows it
+        buffer = 0;
+        if( _canBatch( ))
+            _threadBuffers.pop( buffer );
+    }
+    _flushDatagrams();
+
+    if( _children.size() == 1 ) // We're all alone
+    {
+        LBASSERT( _children.front()->_id == _id );
+        _finishWriteQueue( _sequence - 1 );
+    }
+}
+
+void RSPConnection::_writeDatagram( Buffer* buffer )
+{
     LBASSERT( buffer );
 
     // write buffer
     DatagramData* header = reinterpret_cast<DatagramData*>( buffer->getData( ));
     header->sequence = _sequence++;
+    if( _rateControl )
+        _sendTimes[ header->sequence % _sendTimes.size() ] = _getTime();
 
 #ifdef EQ_RSP_MERGE_WRITES
     if( header->size < _payloadSize && !_threadBuffers.isEmpty( ))
@@ -689,10 +813,14 @@ void RSPConnection::_writeData()
     //  Note 2: Data to myself will be 'written' in _finishWriteQueue once we
     //          got all acks for the packet
     const uint32_t size = header->size + sizeof( DatagramData );
+    const bool sendParity = _fecGroupSize && _addParity( *header );
 
     _waitWritable( size ); // OPT: process incoming in between
     header->byteswap();
-    _write->send( boost::asio::buffer( header, size ));
+    _sendDatagram( header, size );
+    ++_nDatagrams;
+    if( sendParity )
+        _sendParity();
 
 #ifdef EQ_INSTRUMENT_RSP
     ++nDatagrams;
@@ -701,12 +829,85 @@ void RSPConnection::_writeData()
 
     // save datagram for repeats (and self)
     _writeBuffers.push_back( buffer );
+}
 
-    if( _children.size() == 1 ) // We're all alone
+bool RSPConnection::_addParity( const DatagramData& datagram )
+{
+    Buffer* buffer = _parityBuffers[ _parityIndex ];
+    DatagramParity* parity =
+        reinterpret_cast< DatagramParity* >( buffer->getData( ));
+    uint8_t* payload = reinterpret_cast< uint8_t* >( parity + 1 );
+
+    if( parity->count == 0 )
     {
-        LBASSERT( _children.front()->_id == _id );
-        _finishWriteQueue( _sequence - 1 );
+        parity->size = 0;
+        parity->sequence = datagram.sequence;
+        parity->sizes = 0;
     }
+    if( datagram.size > parity->size ) // pad shorter datagrams with zeros
+    {
+        ::memset( payload + parity->size, 0, datagram.size - parity->size );
+        parity->size = datagram.size;
+    }
+
+    _xor( payload, reinterpret_cast< const uint8_t* >( &datagram + 1 ),
+          datagram.size );
+    parity->sizes ^= datagram.size;
+    return ++parity->count == _fecGroupSize;
+}
+
+void RSPConnection::_sendParity()
+{
+    Buffer* buffer = _parityBuffers[ _parityIndex ];
+    DatagramParity* parity =
+        reinterpret_cast< DatagramParity* >( buffer->getData( ));
+    if( parity->count < 2 ) // nothing to protect, let the group grow
+        return;
+
+    const uint32_t size = parity->size + sizeof( DatagramParity );
+    parity->type = PARITY;
+    parity->writerID = _id;
+
+    _waitWritable( size );
+    parity->byteswap();
+    _sendDatagram( parity, size );
+    ++_nParities;
+
+    // start the next group, the sent parity may still be batched
+    _parityIndex = ( _parityIndex + 1 ) % _parityBuffers.size();
+    buffer = _parityBuffers[ _parityIndex ];
+    reinterpret_cast< DatagramParity* >( buffer->getData( ))->count = 0;
+}
+
+void RSPConnection::_sendDatagram( const void* data, const uint32_t size )
+{
+    if( _batch.isValid( ))
+    {
+        // a parity completing its group may follow a full batch
+        if( _batch.isFull( ))
+            _batch.flush();
+        _batch.add( data, size ); // sent by _flushDatagrams
+    }
+    else
+        _write->send( boost::asio::buffer( data, size ));
+}
+
+void RSPConnection::_flushDatagrams()
+{
+    // failed datagrams are treated as lost and will be nack'ed
+    if( _batch.isValid( ))
+        _batch.flush();
+}
+
+bool RSPConnection::_canBatch()
+{
+    if( !_batch.isValid() || _batch.isFull( ))
+        return false;
+
+    // only add datagrams which can be sent right away
+    _bucketSize += static_cast< uint64_t >( _clock.resetTimef() * _sendRate );
+    _bucketSize = LB_MIN( _bucketSize, _maxBucketSize );
+    return _bucketSize >= static_cast< uint64_t >( _mtu );
 }
 
 void RSPConnection::_waitWritable( const uint64_t bytes )
@@ -741,7 +942,7 @@ void RSPConnection::_waitWritable( const uint64_t bytes )
 #endif
 
     ConstConnectionDescriptionPtr description = getDescription();
-    if( _sendRate < description->bandwidth )
+    if( !_rateControl && _sendRate < description->bandwidth )
     {
         _sendRate += int64_t(
             float( Global::getIAttribute( Global::IATTR_RSP_ERROR_UPSCALE )) *
@@ -778,7 +979,8 @@ void RSPConnection::_repeatData()
             // send data
             _waitWritable( size ); // OPT: process incoming in between
             // already done by _writeData: header->byteswap();
-            _write->send( boost::asio::buffer( header, size ) );
+            _sendDatagram( header, size );
+            ++_nRepeats;
 #ifdef EQ_INSTRUMENT_RSP
             ++nRepeated;
 #endif
@@ -789,9 +991,10 @@ void RSPConnection::_repeatData()
         else
             ++request.start;
 
-        if( distance <= _writeBuffers.size( )) // send something
-            return;
+        if( distance <= _writeBuffers.size() && !_canBatch( )) // sent enough
+            break;
     }
+    _flushDatagrams();
 }
 
 void RSPConnection::_finishWriteQueue( const uint16_t sequence )
@@ -877,17 +1080,36 @@ void RSPConnection::_finishWriteQueue( const uint16_t sequence )
 
 void RSPConnection::_handlePacket( const boost::system::error_code& /* error */,
                                    const size_t bytes )
+{
+    if( _batch.isValid( ))
+    {
+        // socket is readable, drain it with as few system calls as possible
+        _batch.read();
+        size_t size = 0;
+        while( _batch.next( _recvBuffer, size ))
+            if( !_handleDatagram( size ))
+                return;
+    }
+    else if( !_isSelf() && !_handleDatagram( bytes ))
+        return;
+
+    if( isListening( ))
+        _processOutgoing();
+
+    //LBLOG( LOG_RSP ) << "_handlePacket timeout " << timeout << std::endl;
+    _asyncReceiveFrom();
+}
+
+bool RSPConnection::_handleDatagram( const size_t bytes )
 {
     if( isListening( ))
     {
         _handleConnectedData( bytes );
 
-        if( isListening( ))
-            _processOutgoing();
-        else
+        if( !isListening( ))
         {
             _ioService.stop();
-            return;
+            return false;
         }
     }
     else if( bytes >= sizeof( DatagramNode ))
@@ -897,9 +1119,7 @@ void RSPConnection::_handlePacket( const boost::system::error_code& /* error */,
         else
             _handleAcceptIDData( bytes );
     }
-
-    //LBLOG( LOG_RSP ) << "_handlePacket timeout " << timeout << std::endl;
-    _asyncReceiveFrom();
+    return true;
 }
 
 void RSPConnection::_handleAcceptIDData( const size_t bytes )
@@ -984,16 +1204,29 @@ void RSPConnection::_handleConnectedData( const size_t bytes )
 #ifdef COLLAGE_BIGENDIAN
     lunchbox::byteswap( type );
 #endif
+#ifdef CO_RSP_SIMULATE_LOSS
+    if(( type == DATA || type == PARITY ) && _simulateLoss( ))
+        return;
+#endif
+
     switch( type )
     {
         case DATA:
             LBCHECK( _handleData( bytes ));
             break;
 
+        case PARITY:
+            LBCHECK( _handleParity( bytes ));
+            break;
+
         case ACK:
             LBCHECK( _handleAck( bytes ));
             break;
 
+        case FEEDBACK:
+            LBCHECK( _handleFeedback( bytes ));
+            break;
+
         case NACK:
             LBCHECK( _handleNack( bytes ));
             break;
@@ -1019,6 +1252,16 @@ void RSPConnection::_handleConnectedData( const size_t bytes )
 
 void RSPConnection::_asyncReceiveFrom()
 {
+    if( _batch.isValid( ))
+    {
+        // only wait for data, _handlePacket receives it
+        _read->async_receive( null_buffers(),
+                              boost::bind( &RSPConnection::_handlePacket, this,
+                                           placeholders::error,
+                                           placeholders::bytes_transferred ));
+        return;
+    }
+
     _read->async_receive_from(
         buffer( _recvBuffer.getData(), _mtu ), _readAddr,
         boost::bind( &RSPConnection::_handlePacket, this,
@@ -1026,13 +1269,16 @@ void RSPConnection::_asyncReceiveFrom()
                      placeholders::bytes_transferred ));
 }
 
-bool RSPConnection::_handleData( const size_t bytes )
+bool RSPConnection::_handleData( const size_t bytes, const bool rebuilt )
 {
     if( bytes < sizeof( DatagramData ))
         return false;
+
     DatagramData& datagram =
                     *reinterpret_cast< DatagramData* >( _recvBuffer.getData( ));
     datagram.byteswap();
+    if( bytes < sizeof( DatagramData ) + datagram.size )
+        return false;
 
 #ifdef EQ_INSTRUMENT_RSP
     ++nReadData;
@@ -1055,6 +1301,9 @@ bool RSPConnection::_handleData( const size_t bytes )
         return false;
     }
     LBASSERT( connection->_id == writerID );
+    connection->_updateReceived( datagram.sequence, !rebuilt );
+    if( !connection->_fecBuffers.empty( ))
+        connection->_keepDatagram( datagram );
 
     const uint16_t sequence = datagram.sequence;
 //  LBLOG( LOG_RSP ) << "rcvd " << sequence << " from " << writerID <<std::endl;
@@ -1117,6 +1366,10 @@ bool RSPConnection::_handleData( const size_t bytes )
     LBASSERT( !connection->_recvBuffers[ i ] );
     connection->_recvBuffers[ i ] = newBuffer;
 
+    // the parity of the group rebuilds or nacks the missing packets
+    if( connection->_fecGroupSize )
+        return true;
+
     // early nack: request missing packets before current
     --i;
     Nack nack = { connection->_sequence, uint16_t( sequence - 1 ) };
@@ -1189,6 +1442,221 @@ void RSPConnection::_pushDataBuffer( Buffer* buffer )
     _appBuffers.push( buffer );
 }
 
+void RSPConnection::_updateReceived( const uint16_t sequence,
+                                     const bool echo )
+{
+    const uint16_t distance = sequence - _maxSequence;
+    if( distance == 0 || distance > _numBuffers )
+        return; // repetition or outdated datagram
+
+    if( distance > 1 ) // a gap counts as one loss event, independent of size
+        ++_nLossEvents;
+    _nExpected += distance;
+    _maxSequence = sequence;
+    if( echo )
+    {
+        _echoSequence = sequence;
+        _echoReceived = _getTime();
+    }
+
+    // decay old history to follow changing network conditions
+    if( _nExpected > 8192 )
+    {
+        _nExpected >>= 1;
+        _nLossEvents >>= 1;
+    }
+}
+
+uint16_t RSPConnection::_getLossRate() const
+{
+    if( _nExpected == 0 )
+        return 0;
+
+    const uint64_t rate = uint64_t( _nLossEvents ) * 65535u / _nExpected;
+    return uint16_t( LB_MIN( rate, 65535u ));
+}
+
+void RSPConnection::_updateSendRate( const DatagramFeedback& feedback )
+{
+    const uint16_t age = _sequence - feedback.echoSequence;
+    if( age == 0 || age > _sendTimes.size( ))
+        return; // send time not known (anymore)
+
+    const uint32_t sent = _sendTimes[ feedback.echoSequence %
+                                      _sendTimes.size() ];
+    const int32_t rtt = int32_t( _getTime() - sent - feedback.delay );
+    if( rtt < 0 )
+        return;
+
+    const DatagramAck& ack = feedback.ack;
+    const float lossRate = float( feedback.lossRate ) / 65535.f;
+    const int64_t rate = _rateControl->update( ack.readerID,
+                                               float( rtt ) * .001f, lossRate,
+                                               _sendRate,
+                                               _timeClock.getTimef( ));
+    if( rate != _sendRate )
+        LBLOG( LOG_RSP ) << "reader " << ack.readerID << " rtt " << rtt
+                         << "us loss " << lossRate * 100.f
+                         << "%, send rate " << rate << " KB/s" << std::endl;
+    _sendRate = rate;
+}
+
+bool RSPConnection::_isSelf() const
+{
+    // only set on the loopback interface, where an exact match is our socket
+    return _writeAddr.port() != 0 && _readAddr == _writeAddr;
+}
+
+#ifdef CO_RSP_SIMULATE_LOSS
+bool RSPConnection::_simulateLoss()
+{
+    if( _simulatedLoss == 0 )
+        return false;
+
+    // xorshift, cheap and good enough to drop random datagrams
+    _lossSeed ^= _lossSeed << 13;
+    _lossSeed ^= _lossSeed >> 17;
+    _lossSeed ^= _lossSeed << 5;
+    return _lossSeed % 1000 < _simulatedLoss;
+}
+#endif
+
+bool RSPConnection::_handleParity( const size_t bytes )
+{
+    if( bytes < sizeof( DatagramParity ))
+        return false;
+
+    DatagramParity& parity =
+        *reinterpret_cast< DatagramParity* >( _recvBuffer.getData( ));
+    parity.byteswap();
+    if( parity.count == 0 || parity.count > EQ_RSP_MAX_FEC_GROUP ||
+        parity.size > _payloadSize ||
+        bytes < sizeof( DatagramParity ) + parity.size )
+    {
+        return false;
+    }
+
+    RSPConnectionPtr connection = _findConnection( parity.writerID );
+    if( !connection || connection->_id == _id )
+        return true;
+
+    if( connection->_fecBuffers.empty( )) // first parity from this writer
+    {
+        const size_t size = 4 * parity.count;
+        connection->_fecBuffers.reserve( size );
+        while( connection->_fecBuffers.size() < size )
+            connection->_fecBuffers.push_back( new Buffer( _mtu ));
+        connection->_fecSequences.resize( size, -1 );
+    }
+    connection->_fecGroupSize = LB_MAX( connection->_fecGroupSize,
+                                        parity.count );
+
+    Nack nacks[ EQ_RSP_MAX_FEC_GROUP ];
+    uint16_t nNacks = 0;
+    uint16_t nMissing = 0;
+    uint16_t missing = 0;
+    for( uint16_t i = 0; i < parity.count; ++i )
+    {
+        const uint16_t sequence = parity.sequence + i;
+        if( connection->_hasDatagram( sequence ))
+            continue;
+
+        ++nMissing;
+        missing = sequence;
+        if( nNacks > 0 && nacks[ nNacks - 1 ].end == uint16_t( sequence - 1 ))
+            nacks[ nNacks - 1 ].end = sequence;
+        else
+        {
+            const Nack nack = { sequence, sequence };
+            nacks[ nNacks++ ] = nack;
+        }
+    }
+
+    if( nMissing == 0 ||
+        ( nMissing == 1 && _rebuildDatagram( *connection, parity, missing )))
+    {
+        return true;
+    }
+
+    LBLOG( LOG_RSP ) << "FEC can't rebuild " << nMissing << " of "
+                     << parity.count << " datagrams from " << parity.writerID
+                     << ", send nack" << std::endl;
+    _sendNack( parity.writerID, nacks, nNacks );
+    return true;
+}
+
+bool RSPConnection::_rebuildDatagram( const RSPConnection& writer,
+                                      const DatagramParity& parity,
+                                      const uint16_t sequence )
+{
+    DatagramData* datagram =
+        reinterpret_cast< DatagramData* >( _fecBuffer.getData( ));
+    uint8_t* payload = reinterpret_cast< uint8_t* >( datagram + 1 );
+    ::memcpy( payload, &parity + 1, parity.size );
+
+    uint16_t size = parity.sizes;
+    for( uint16_t i = 0; i < parity.count; ++i )
+    {
+        const uint16_t other = parity.sequence + i;
+        if( other == sequence )
+            continue;
+
+        const DatagramData* kept = writer._getKeptDatagram( other );
+        if( !kept || kept->size > parity.size ) // not kept, can't rebuild
+            return false;
+
+        _xor( payload, reinterpret_cast< const uint8_t* >( kept + 1 ),
+              kept->size );
+        size ^= kept->size;
+    }
+    if( size > parity.size )
+        return false;
+
+    datagram->type = DATA;
+    datagram->size = size;
+    datagram->writerID = parity.writerID;
+    datagram->sequence = sequence;
+    datagram->byteswap();
+    LBLOG( LOG_RSP ) << "FEC rebuilt " << sequence << " from "
+                     << parity.writerID << std::endl;
+
+    // process it like a received datagram, the parity is not used anymore
+    _recvBuffer.swap( _fecBuffer );
+    const bool ok = _handleData( sizeof( DatagramData ) + size, true );
+    _recvBuffer.swap( _fecBuffer );
+    ++_nRebuilt;
+    return ok;
+}
+
+void RSPConnection::_keepDatagram( const DatagramData& datagram )
+{
+    const size_t i = datagram.sequence % _fecBuffers.size();
+    ::memcpy( _fecBuffers[i]->getData(), &datagram,
+              sizeof( DatagramData ) + datagram.size );
+    _fecSequences[i] = datagram.sequence;
+}
+
+const RSPConnection::DatagramData* RSPConnection::_getKeptDatagram(
+    const uint16_t sequence ) const
+{
+    const size_t i = sequence % _fecBuffers.size();
+    if( _fecSequences[i] != sequence )
+        return 0;
+    return reinterpret_cast< const DatagramData* >( _fecBuffers[i]->getData( ));
+}
+
+bool RSPConnection::_hasDatagram( const uint16_t sequence ) const
+{
+    const uint16_t distance = sequence - _sequence;
+    if( distance == 0 ) // next expected
+        return false;
+    if( distance > _numBuffers ) // already delivered
+        return true;
+
+    const size_t i = distance - 1;
+    return i < _recvBuffers.size() && _recvBuffers[i];
+}
+
 bool RSPConnection::_handleAck( const size_t bytes )
 {
     if( bytes < sizeof( DatagramAck ))
@@ -1196,7 +1664,25 @@ bool RSPConnection::_handleAck( const size_t bytes )
     DatagramAck& ack =
                      *reinterpret_cast< DatagramAck* >( _recvBuffer.getData( ));
     ack.byteswap();
+    return _handleAck( ack );
+}
+
+bool RSPConnection::_handleFeedback( const size_t bytes )
+{
+    if( bytes < sizeof( DatagramFeedback ))
+        return false;
+    DatagramFeedback& feedback =
+                *reinterpret_cast< DatagramFeedback* >( _recvBuffer.getData( ));
+    feedback.byteswap();
+
+    // writers without rate control use it as a plain ack
+    if( _rateControl && feedback.ack.writerID == _id )
+        _updateSendRate( feedback );
+    return _handleAck( feedback.ack );
+}
 
+bool RSPConnection::_handleAck( const DatagramAck& ack )
+{
 #ifdef EQ_INSTRUMENT_RSP
     ++nAcksRead;
 #endif
@@ -1330,7 +1816,7 @@ void RSPConnection::_addRepeat( const Nack* nacks, uint16_t num )
     }
 
     ConstConnectionDescriptionPtr description = getDescription();
-    if( _sendRate >
+    if( !_rateControl && _sendRate >
         ( description->bandwidth >>
           Global::getIAttribute( Global::IATTR_RSP_MIN_SENDRATE_SHIFT )))
     {
@@ -1516,6 +2002,9 @@ void RSPConnection::_removeConnection( const uint16_t id )
     if( id == _id )
         return;
 
+    if( _rateControl )
+        _rateControl->remove( id );
+
     for( RSPConnectionsIter i = _children.begin(); i != _children.end(); ++i )
     {
         RSPConnectionPtr child = *i;
@@ -1598,6 +2087,7 @@ void RSPConnection::finish()
         return;
     }
     LBASSERT( isListening( ));
+    Connection::finish(); // batched and queued sends
     _appBuffers.waitSize( _buffers.size( ));
 }
 
@@ -1630,6 +2120,20 @@ void RSPConnection::_sendAck( const uint16_t writerID,
 #endif
 
     LBLOG( LOG_RSP ) << "send ack " << sequence << std::endl;
+    RSPConnectionPtr writer;
+    if( _rateControl )
+        writer = _findConnection( writerID );
+    if( writer && writer->_nExpected > 0 )
+    {
+        DatagramFeedback feedback = { { FEEDBACK, _id, writerID, sequence },
+                                      writer->_echoSequence,
+                                      writer->_getLossRate(),
+                                      _getTime() - writer->_echoReceived };
+        feedback.byteswap();
+        _write->send( buffer( &feedback, sizeof( feedback )) );
+        return;
+    }
+
     DatagramAck ack = { ACK, _id, writerID, sequence };
     ack.byteswap();
     _write->send( buffer( &ack, sizeof( ack )) );
@@ -23,6 +23,7 @@
 #define CO_RSPCONNECTION_H
 
 #include <co/connection.h>      // base class
+#include <co/datagramBatch.h>   // member
 #include <co/eventConnection.h> // member
 
 #include <lunchbox/buffer.h>  // member
@@ -38,6 +39,7 @@
 namespace co
 {
     class RSPConnection;
+    class RSPRateControl;
     typedef lunchbox::RefPtr< RSPConnection > RSPConnectionPtr;
 
     /**
@@ -74,6 +76,18 @@ namespace co
         /** @internal @return current send speed in kilobyte per second. */
         int64_t getSendRate() const { return _sendRate; }
 
+        /** @internal @return the number of data datagrams sent. */
+        uint64_t getNumDatagrams() const { return _nDatagrams; }
+
+        /** @internal @return the number of repeated data datagrams. */
+        uint64_t getNumRepeats() const { return _nRepeats; }
+
+        /** @internal @return the number of parity datagrams sent. */
+        uint64_t getNumParities() const { return _nParities; }
+
+        /** @internal @return the number of data datagrams rebuilt by FEC. */
+        uint64_t getNumRebuilt() const { return _nRebuilt; }
+
         /**
          * @internal
          * @return the unique identifier of this connection within the multicast
@@ -114,7 +128,9 @@ namespace co
             ID_DENY,   //!< deny the id, already used
             ID_CONFIRM,//!< a new node is connected
             ID_EXIT,   //!< a node is disconnected
-            COUNTNODE  //!< send to other the number of nodes which I have found
+            COUNTNODE, //!< send to other the number of nodes which I have found
+            PARITY,    //!< forward error correction for a group of data packets
+            FEEDBACK   //!< ack with rate control feedback
             // NOTE: Do not use more than 255 types here, since the endianness
             // detection magic relies on only using the LSB.
         };
@@ -215,6 +231,25 @@ namespace co
             }
         };
 
+        /** Ack sent instead of DatagramAck by readers using rate control. */
+        struct DatagramFeedback
+        {
+            DatagramAck ack;
+            uint16_t    echoSequence; //!< latest data packet received
+            uint16_t    lossRate;     //!< loss event rate, 1/65535 units
+            uint32_t    delay;        //!< time since receiving echoSequence (us)
+
+            void byteswap()
+            {
+                ack.byteswap();
+#ifdef COLLAGE_BIGENDIAN
+                lunchbox::byteswap( echoSequence );
+                lunchbox::byteswap( lossRate );
+                lunchbox::byteswap( delay );
+#endif
+            }
+        };
+
         /** Data packet */
         struct DatagramData
         {
@@ -234,6 +269,35 @@ namespace co
             }
         };
 
+#       define EQ_RSP_MAX_FEC_GROUP 64 // data packets per parity packet
+        /**
+         * XOR of the sizes and payloads of count data packets, starting at
+         * sequence. Writers using FEC shorten the data payload by the larger
+         * parity header, so that the parity of full data packets fits into
+         * the MTU.
+         */
+        struct DatagramParity
+        {
+            uint16_t    type;
+            uint16_t    size;     //!< payload size, largest of the group
+            uint16_t    writerID;
+            uint16_t    sequence; //!< first data packet of the group
+            uint16_t    count;    //!< number of data packets in the group
+            uint16_t    sizes;    //!< XOR of the data packet sizes
+
+            void byteswap()
+            {
+#ifdef COLLAGE_BIGENDIAN
+                lunchbox::byteswap( type );
+                lunchbox::byteswap( size );
+                lunchbox::byteswap( writerID );
+                lunchbox::byteswap( sequence );
+                lunchbox::byteswap( count );
+                lunchbox::byteswap( sizes );
+#endif
+            }
+        };
+
         typedef std::vector< RSPConnectionPtr > RSPConnections;
         typedef RSPConnections::iterator RSPConnectionsIter;
         typedef RSPConnections::const_iterator RSPConnectionsCIter;
@@ -258,13 +322,17 @@ namespace co
         boost::asio::ip::udp::socket*  _read;
         boost::asio::ip::udp::socket*  _write;
         boost::asio::ip::udp::endpoint _readAddr;
+        boost::asio::ip::udp::endpoint _writeAddr; //!< set on loopback only
         boost::asio::deadline_timer    _timeout;
         boost::asio::deadline_timer    _wakeup;
+        DatagramBatch                  _batch; //!< Linux mmsg/GSO/GRO IO
 
         lunchbox::Clock _clock;
         uint64_t        _maxBucketSize;
         size_t          _bucketSize;
         int64_t         _sendRate;
+        RSPRateControl* _rateControl; //!< 0 for NACK-based rate scaling
+        std::vector< uint32_t > _sendTimes; //!< per sequence, for rate control
 
         Thread*      _thread;
         lunchbox::Lock   _mutexConnection;
@@ -294,6 +362,31 @@ namespace co
         typedef std::deque< Nack > RepeatQueue;
         RepeatQueue _repeatQueue; //!< nacks to repeat
 
+        // Rate control feedback measured by a reader for this writer
+        uint16_t _maxSequence;  //!< highest data sequence received
+        uint32_t _nExpected;    //!< data datagrams expected (decayed)
+        uint32_t _nLossEvents;  //!< gaps in the received sequence (decayed)
+        uint16_t _echoSequence; //!< latest datagram received from the wire
+        uint32_t _echoReceived; //!< local receive time of _echoSequence
+
+#ifdef CO_RSP_SIMULATE_LOSS
+        uint32_t _simulatedLoss; //!< dropped data datagrams, in permille
+        uint32_t _lossSeed;
+#endif
+
+        uint64_t _nDatagrams; //!< data datagrams sent
+        uint64_t _nRepeats;   //!< data datagrams repeated
+        uint64_t _nParities;  //!< parity datagrams sent
+        uint64_t _nRebuilt;   //!< data datagrams rebuilt from parities
+
+        // Forward error correction
+        uint16_t _fecGroupSize;   //!< data per parity datagram, 0 if unused
+        Buffers  _parityBuffers;  //!< Parities in progress or batched (writer)
+        size_t   _parityIndex;    //!< Parity buffer of the current group
+        Buffers  _fecBuffers;     //!< Recent data datagrams (reader)
+        std::vector< int32_t > _fecSequences; //!< sequence of each fecBuffer
+        Buffer   _fecBuffer;      //!< Rebuilt data datagram
+
         const unsigned _writeTimeOut;
 
         void _close();
@@ -301,13 +394,34 @@ namespace co
 
         void _processOutgoing();
         void _writeData();
+        void _writeDatagram( Buffer* buffer );
         void _repeatData();
         void _finishWriteQueue( const uint16_t sequence );
-
-        bool _handleData( const size_t bytes );
+        bool _addParity( const DatagramData& datagram );
+        void _sendParity();
+
+        bool _handleData( const size_t bytes, const bool rebuilt = false );
+        void _updateReceived( const uint16_t sequence, const bool echo );
+        uint16_t _getLossRate() const;
+        void _updateSendRate( const DatagramFeedback& feedback );
+        bool _isSelf() const;
+#ifdef CO_RSP_SIMULATE_LOSS
+        bool _simulateLoss();
+#endif
         bool _handleAck( const size_t bytes );
+        bool _handleAck( const DatagramAck& ack );
+        bool _handleFeedback( const size_t bytes );
         bool _handleNack( const size_t bytes );
         bool _handleAckRequest( const size_t bytes );
+        bool _handleParity( const size_t bytes );
+        bool _rebuildDatagram( const RSPConnection& writer,
+                               const DatagramParity& parity,
+                               const uint16_t sequence );
+
+        /** Keep a received datagram for rebuilding lost ones */
+        void _keepDatagram( const DatagramData& datagram );
+        const DatagramData* _getKeptDatagram( const uint16_t sequence ) const;
+        bool _hasDatagram( const uint16_t sequence ) const;
 
         Buffer* _newDataBuffer( Buffer& inBuffer );
         void _pushDataBuffer( Buffer* buffer );
@@ -322,6 +436,7 @@ namespace co
         /* handle data about the comunication state */
         void _handlePacket( const boost::system::error_code& error,
                             const size_t bytes );
+        bool _handleDatagram( const size_t bytes );
         void _handleConnectedData( const size_t bytes );
         void _handleInitData( const size_t bytes, const bool connected );
         void _handleAcceptIDData( const size_t bytes );
@@ -342,6 +457,15 @@ namespace co
         /** Sleep until allowed to send according to send rate */
         void _waitWritable( const uint64_t bytes );
 
+        /** @return true if another datagram can be batched without waiting */
+        bool _canBatch();
+
+        /** Send or batch a data datagram */
+        void _sendDatagram( const void* data, const uint32_t size );
+
+        /** Send all batched datagrams */
+        void _flushDatagrams();
+
         /** format and send a datagram count node */
         void _sendCountNode();
 
@@ -0,0 +1,122 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "rspRateControl.h"
+
+#include <lunchbox/debug.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace co
+{
+namespace
+{
+// Round trip times are clamped to this minimum (ms), loopback and LAN
+// measurements are dominated by scheduling noise below it.
+static const float _minRTT = .1f;
+// Queueing delay which triggers a delay-based decrease, relative to the
+// minimum round trip time and absolute (ms).
+static const float _queueFactor = 2.f;
+static const float _queueDelay = 1.f;
+// Rate reduction on queue build-up
+static const float _delayDecrease = .875f;
+}
+
+RSPRateControl::RSPRateControl( const int64_t minRate, const int64_t maxRate,
+                                const uint32_t packetSize )
+    : _minRate( float( minRate ))
+    , _maxRate( float( maxRate ))
+    , _packetSize( float( packetSize ))
+    , _lastUpdate( 0.f )
+    , _lastDecrease( 0.f )
+{
+    LBASSERT( minRate <= maxRate );
+}
+
+float RSPRateControl::getFairRate( const float rtt, const float loss ) const
+{
+    if( loss <= 0.f )
+        return _maxRate;
+
+    // TCP throughput equation (RFC 5348), with t_RTO = 4 * RTT, in bytes/ms
+    const float rttMS = std::max( rtt, _minRTT );
+    const float rto = 4.f * rttMS;
+    const float denominator = rttMS * std::sqrt( 2.f * loss / 3.f ) +
+                              rto * 3.f * std::sqrt( 3.f * loss / 8.f ) *
+                              loss * ( 1.f + 32.f * loss * loss );
+    // bytes/ms ~= KB/s, see RSPConnection::_waitWritable
+    return _packetSize / denominator;
+}
+
+int64_t RSPRateControl::update( const uint16_t id, const float rtt,
+                                const float loss, const int64_t currentRate,
+                                const float time )
+{
+    Reader& reader = _readers[ id ];
+    const float sample = std::max( rtt, _minRTT );
+    if( reader.rtt == 0.f )
+        reader.rtt = reader.minRTT = sample;
+    else
+    {
+        reader.rtt = .875f * reader.rtt + .125f * sample;
+        reader.minRTT = std::min( reader.minRTT, sample );
+    }
+    reader.loss = loss;
+    reader.rate = getFairRate( reader.rtt, loss );
+
+    // The current limiting receiver determines the target rate
+    float target = _maxRate;
+    float rttCLR = reader.rtt;
+    for( Readers::const_iterator i = _readers.begin(); i != _readers.end();
+         ++i )
+    {
+        if( i->second.rate < target )
+        {
+            target = i->second.rate;
+            rttCLR = i->second.rtt;
+        }
+    }
+
+    float rate = float( currentRate );
+    const float queueing = reader.rtt - reader.minRTT;
+    if( queueing > _queueDelay &&
+        reader.rtt > _queueFactor * reader.minRTT &&
+        time - _lastDecrease > reader.rtt )
+    {
+        // back off once per round trip while the queue builds up
+        target = std::min( target, rate * _delayDecrease );
+        _lastDecrease = time;
+    }
+
+    if( target < rate )
+        rate = target;
+    else
+    {
+        // at most double the rate per round trip time
+        const float elapsed = std::min( time - _lastUpdate, rttCLR );
+        rate = std::min( target, rate + rate * elapsed / rttCLR );
+    }
+
+    _lastUpdate = time;
+    rate = std::max( rate, _minRate );
+    rate = std::min( rate, _maxRate );
+    return int64_t( rate );
+}
+
+}
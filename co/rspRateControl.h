@@ -0,0 +1,94 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_RSPRATECONTROL_H
+#define CO_RSPRATECONTROL_H
+
+#include <lunchbox/types.h>
+
+#include <map>
+
+namespace co
+{
+    /**
+     * @internal Equation-based send rate control for RSP writers.
+     *
+     * Modelled after TFMCC: each reader reports its loss event rate and
+     * echoes its latest data sequence to measure the round trip time against
+     * the send time recorded by the writer. The TCP throughput
+     * equation yields a fair rate for every reader, and the slowest one, the
+     * current limiting receiver, determines the send rate. Decreases are
+     * applied immediately. Increases are limited to doubling the rate per
+     * round trip time. A round trip time growing well above its minimum
+     * signals queueing in the network and reduces the rate before packets
+     * are lost.
+     */
+    class RSPRateControl
+    {
+    public:
+        /**
+         * @param minRate the minimum send rate in KB/s.
+         * @param maxRate the maximum send rate in KB/s.
+         * @param packetSize the datagram size in bytes.
+         */
+        RSPRateControl( const int64_t minRate, const int64_t maxRate,
+                        const uint32_t packetSize );
+
+        /**
+         * Process the feedback of one reader.
+         *
+         * @param reader the reader identifier.
+         * @param rtt the measured round trip time in ms.
+         * @param loss the loss event rate reported by the reader.
+         * @param rate the current send rate in KB/s.
+         * @param time the current time in ms.
+         * @return the new send rate in KB/s.
+         */
+        int64_t update( const uint16_t reader, const float rtt,
+                        const float loss, const int64_t rate,
+                        const float time );
+
+        /** Forget the feedback of a reader which left the group. */
+        void remove( const uint16_t reader ) { _readers.erase( reader ); }
+
+        /** @return the fair rate for the given conditions in KB/s. */
+        float getFairRate( const float rtt, const float loss ) const;
+
+    private:
+        struct Reader
+        {
+            Reader() : rtt( 0.f ), minRTT( 0.f ), loss( 0.f ), rate( 0.f ) {}
+
+            float rtt;    //!< smoothed round trip time (ms)
+            float minRTT; //!< smallest round trip time seen (ms)
+            float loss;   //!< loss event rate
+            float rate;   //!< fair rate (KB/s), 0 if not limited by loss
+        };
+        typedef std::map< uint16_t, Reader > Readers;
+
+        const float _minRate;
+        const float _maxRate;
+        const float _packetSize;
+
+        Readers _readers;
+        float _lastUpdate;   //!< time of the last rate change (ms)
+        float _lastDecrease; //!< time of the last delay-based decrease (ms)
+    };
+}
+
+#endif //CO_RSPRATECONTROL_H
@@ -22,6 +22,10 @@
 
 #include "dataIStream.h"
 #include "dataOStream.h"
+#include "objectMap.h"
+
+#include <lunchbox/scopedMutex.h>
+#include <lunchbox/spinLock.h>
 
 namespace co
 {
@@ -30,11 +34,17 @@ namespace detail
 class Serializable
 {
 public:
-    Serializable() : dirty( co::Serializable::DIRTY_NONE ) {}
+    Serializable() : dirty( co::Serializable::DIRTY_NONE ), objectMap( 0 ) {}
     ~Serializable() {}
 
     /** The current dirty bits. */
     uint64_t dirty;
+
+    /** The map holding this master, notified when it becomes dirty. */
+    co::ObjectMap* objectMap;
+
+    /** Protects objectMap against a concurrent unregistration from it. */
+    mutable lunchbox::SpinLock lock;
 };
 }
 
@@ -76,7 +86,14 @@ uint128_t Serializable::commit( const uint32_t incarnation )
 
 void Serializable::setDirty( const uint64_t bits )
 {
+    const bool wasClean = _impl->dirty == DIRTY_NONE;
     _impl->dirty |= bits;
+    if( !wasClean || bits == DIRTY_NONE )
+        return;
+
+    lunchbox::ScopedFastRead mutex( _impl->lock );
+    if( _impl->objectMap )
+        _impl->objectMap->_notifyDirty( this );
 }
 
 void Serializable::unsetDirty( const uint64_t bits )
@@ -84,6 +101,18 @@ void Serializable::unsetDirty( const uint64_t bits )
     _impl->dirty &= ~bits;
 }
 
+ObjectMap* Serializable::_getObjectMap() const
+{
+    lunchbox::ScopedFastRead mutex( _impl->lock );
+    return _impl->objectMap;
+}
+
+void Serializable::_setObjectMap( ObjectMap* map )
+{
+    lunchbox::ScopedFastWrite mutex( _impl->lock );
+    _impl->objectMap = map;
+}
+
 void Serializable::notifyAttached()
 {
     if( isMaster( ))
@@ -102,7 +102,13 @@ protected:
         DIRTY_ALL        = 0xFFFFFFFFFFFFFFFFull
     };
 
-    /** Add dirty flags to mark data for distribution. @version 1.0 */
+    /**
+     * Add dirty flags to mark data for distribution.
+     *
+     * Notifies the ObjectMap holding this master if it uses dirty tracking,
+     * see ObjectMap::setDirtyTracking().
+     * @version 1.0
+     */
     CO_API virtual void setDirty( const uint64_t bits );
 
     /** Remove dirty flags to clear data from distribution. @version 1.0 */
@@ -118,6 +124,11 @@ private:
     detail::Serializable* const _impl;
     friend class detail::Serializable;
 
+    /** @internal The object map notified by setDirty(). */
+    friend class ObjectMap;
+    ObjectMap* _getObjectMap() const;
+    void _setObjectMap( ObjectMap* map );
+
     void getInstanceData( co::DataOStream& os ) final
         { serialize( os, DIRTY_ALL ); }
 
@@ -44,20 +44,42 @@
 #  include <arpa/inet.h>
 #  include <netdb.h>
 #  include <netinet/tcp.h>
+#  include <poll.h>
 #  include <sys/errno.h>
 #  include <sys/socket.h>
 #  ifndef AF_INET_SDP
 #    define AF_INET_SDP 27
 #  endif
+#  ifdef __linux__
+#    include <linux/errqueue.h>
+#  endif
 #endif
 
 namespace co
 {
+namespace
+{
+// Socket buffer size of SOCKETPROFILE_THROUGHPUT
+static const int _throughputBufferSize = 4194304;
+// Busy polling time (us) and unsent data limit of SOCKETPROFILE_LATENCY
+static const int _busyPollTime = 50;
+static const int _notSentLowat = 16384;
+// Minimum write size sent without copy. The buffer of a zero-copy write is
+// only released after the peer acknowledged the data, and the completion has
+// to be collected, which only pays off for large writes.
+static const uint64_t _zeroCopySize = 262144;
+}
+
 SocketConnection::SocketConnection( const ConnectionType type )
 #ifdef _WIN32
         : _overlappedAcceptData( 0 )
         , _overlappedSocket( INVALID_SOCKET )
         , _overlappedDone( 0 )
+#else
+        : _quickAck( false )
+        , _zeroCopy( false )
+        , _zeroCopySends( 0 )
+        , _zeroCopyDone( 0 )
 #endif
 {
 #ifdef _WIN32
@@ -188,15 +210,30 @@ bool SocketConnection::connect()
 
 void SocketConnection::_close()
 {
-    if( isClosed() )
+    // The send thread closes on write errors, possibly during our close
+    if( !_closeLock.trySet( ))
         return;
+    if( isClosed( ))
+    {
+        _closeLock.unset();
+        return;
+    }
 
     if( isListening( ))
         _exitAIOAccept();
     else if( isConnected( ))
+    {
         _exitAIORead();
+        // fail a send thread blocked in a write to a stalled peer
+#ifdef _WIN32
+        ::shutdown( _readFD, SD_BOTH );
+#else
+        ::shutdown( _readFD, SHUT_RDWR );
+#endif
+    }
 
     LBASSERT( _readFD > 0 );
+    _setState( STATE_CLOSING ); // joins the send thread before the close
 
 #ifdef _WIN32
     const bool closed = ( ::closesocket(_readFD) == 0 );
@@ -211,6 +248,7 @@ void SocketConnection::_close()
     _readFD  = INVALID_SOCKET;
     _writeFD = INVALID_SOCKET;
     _setState( STATE_CLOSED );
+    _closeLock.unset();
 }
 
 //----------------------------------------------------------------------
@@ -262,8 +300,8 @@ void SocketConnection::_exitAIORead()
 #else
 void SocketConnection::_initAIOAccept(){ /* NOP */ }
 void SocketConnection::_exitAIOAccept(){ /* NOP */ }
-void SocketConnection::_initAIORead(){ /* NOP */ }
-void SocketConnection::_exitAIORead(){ /* NOP */ }
+void SocketConnection::_initAIORead(){ _initURing(); }
+void SocketConnection::_exitAIORead(){ _exitURing(); }
 #endif
 
 //----------------------------------------------------------------------
@@ -362,6 +400,8 @@ ConnectionPtr SocketConnection::acceptSync()
     newDescription->bandwidth = description->bandwidth;
     newDescription->port = ntohs( remote->sin_port );
     newDescription->setHostname( inet_ntoa( remote->sin_addr ));
+    newDescription->profile = description->profile;
+    newDescription->cpu = description->cpu;
 
     LBINFO << "accepted connection from " << inet_ntoa( remote->sin_addr )
            << ":" << ntohs( remote->sin_port ) << std::endl;
@@ -392,18 +432,21 @@ ConnectionPtr SocketConnection::acceptSync()
         return 0;
     }
 
-    _tuneSocket( fd );
-
     ConstConnectionDescriptionPtr description = getDescription();
     SocketConnection* newConnection = new SocketConnection( description->type);
 
-    newConnection->_readFD      = fd;
-    newConnection->_writeFD     = fd;
-    newConnection->_setState( STATE_CONNECTED );
     ConnectionDescriptionPtr newDescription = newConnection->_getDescription();
     newDescription->bandwidth = description->bandwidth;
     newDescription->port = ntohs( newAddress.sin_port );
     newDescription->setHostname( inet_ntoa( newAddress.sin_addr ));
+    newDescription->profile = description->profile;
+    newDescription->cpu = description->cpu;
+    newConnection->_tuneSocket( fd );
+
+    newConnection->_readFD      = fd;
+    newConnection->_writeFD     = fd;
+    newConnection->_initAIORead();
+    newConnection->_setState( STATE_CONNECTED );
 
     LBVERB << "accepted connection from " << inet_ntoa(newAddress.sin_addr)
            << ":" << ntohs( newAddress.sin_port ) << std::endl;
@@ -573,6 +616,113 @@ int64_t SocketConnection::write( const void* buffer, const uint64_t bytes )
     LBUNREACHABLE;
     return -1;
 }
+
+#else // _WIN32
+
+int64_t SocketConnection::readSync( void* buffer, const uint64_t bytes,
+                                    const bool block )
+{
+    const int64_t result = FDConnection::readSync( buffer, bytes, block );
+#ifdef TCP_QUICKACK
+    // The kernel falls back to delayed acks, re-enter quick ack mode
+    if( _quickAck && result > 0 )
+    {
+        const int on = 1;
+        setsockopt( _readFD, IPPROTO_TCP, TCP_QUICKACK, &on, sizeof( on ));
+    }
+#endif
+    return result;
+}
+
+int64_t SocketConnection::writeRetained( const void* buffer,
+                                         const uint64_t bytes )
+{
+#ifdef MSG_ZEROCOPY
+    // The kernel reads the buffer until the completion is reported, which
+    // is collected by releaseWriteBuffers() before the buffer is reused.
+    if( _zeroCopy && bytes >= _zeroCopySize && isConnected( ))
+    {
+        const ssize_t sent = ::send( _writeFD, buffer, bytes, MSG_ZEROCOPY );
+        if( sent > 0 )
+        {
+            ++_zeroCopySends;
+            return sent;
+        }
+        // else out of pinnable memory or not writable, copy below
+    }
+#endif
+    return FDConnection::write( buffer, bytes );
+}
+
+bool SocketConnection::_waitZeroCopy()
+{
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+    while( _zeroCopyDone != _zeroCopySends )
+    {
+        char control[ 128 ];
+        msghdr message;
+        memset( &message, 0, sizeof( message ));
+        message.msg_control = control;
+        message.msg_controllen = sizeof( control );
+
+        if( ::recvmsg( _writeFD, &message, MSG_ERRQUEUE ) < 0 )
+        {
+            if( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+            {
+                LBWARN << "Zero-copy completion error: " << lunchbox::sysError
+                       << std::endl;
+                return false;
+            }
+
+            // completions are signaled as POLLERR
+            pollfd fds = { _writeFD, 0, 0 };
+            const uint32_t timeout = Global::getTimeout();
+            const int res = ::poll( &fds, 1, timeout == LB_TIMEOUT_INDEFINITE ?
+                                             -1 : int( timeout ));
+            if( res == 0 ) // called by the send thread, which can't throw
+            {
+                LBWARN << "Timeout waiting for zero-copy completions"
+                       << std::endl;
+                return false;
+            }
+            if( res < 0 && errno != EINTR )
+            {
+                LBWARN << "Write error: " << lunchbox::sysError << std::endl;
+                return false;
+            }
+            continue;
+        }
+
+        for( cmsghdr* cmsg = CMSG_FIRSTHDR( &message ); cmsg;
+             cmsg = CMSG_NXTHDR( &message, cmsg ))
+        {
+            const bool ipv4 = cmsg->cmsg_level == SOL_IP &&
+                              cmsg->cmsg_type == IP_RECVERR;
+            const bool ipv6 = cmsg->cmsg_level == SOL_IPV6 &&
+                              cmsg->cmsg_type == IPV6_RECVERR;
+            if( !ipv4 && !ipv6 )
+                continue;
+
+            const sock_extended_err* error =
+                reinterpret_cast< const sock_extended_err* >(CMSG_DATA(cmsg));
+            if( error->ee_errno != 0 ||
+                error->ee_origin != SO_EE_ORIGIN_ZEROCOPY )
+            {
+                continue;
+            }
+
+            // [ee_info, ee_data] is the range of completed sends
+            _zeroCopyDone = error->ee_data + 1;
+
+            // The kernel copied the data anyway, e.g., over loopback. The
+            // completion round trip only costs time then.
+            if( error->ee_code & SO_EE_CODE_ZEROCOPY_COPIED )
+                _zeroCopy = false;
+        }
+    }
+#endif
+    return true;
+}
 #endif // _WIN32
 
 bool SocketConnection::_createSocket()
@@ -613,6 +763,7 @@ bool SocketConnection::_createSocket()
 
 void SocketConnection::_tuneSocket( const Socket fd )
 {
+    ConstConnectionDescriptionPtr description = getDescription();
     const int on         = 1;
     setsockopt( fd, IPPROTO_TCP, TCP_NODELAY,
                 reinterpret_cast<const char*>( &on ), sizeof( on ));
@@ -620,11 +771,58 @@ void SocketConnection::_tuneSocket( const Socket fd )
                 reinterpret_cast<const char*>( &on ), sizeof( on ));
 
 #ifdef _WIN32
-    const int size = 128768;
+    const int size = description->profile == SOCKETPROFILE_THROUGHPUT ?
+                         _throughputBufferSize : 128768;
     setsockopt( fd, SOL_SOCKET, SO_RCVBUF,
                 reinterpret_cast<const char*>( &size ), sizeof( size ));
     setsockopt( fd, SOL_SOCKET, SO_SNDBUF,
                 reinterpret_cast<const char*>( &size ), sizeof( size ));
+#else
+    switch( description->profile )
+    {
+      case SOCKETPROFILE_LATENCY:
+#  ifdef TCP_QUICKACK
+          _quickAck = true;
+          setsockopt( fd, IPPROTO_TCP, TCP_QUICKACK, &on, sizeof( on ));
+#  endif
+#  ifdef SO_BUSY_POLL
+          if( setsockopt( fd, SOL_SOCKET, SO_BUSY_POLL, &_busyPollTime,
+                          sizeof( _busyPollTime )) != 0 )
+          {
+              LBVERB << "Busy polling not available: " << lunchbox::sysError
+                     << std::endl;
+          }
+#  endif
+#  ifdef TCP_NOTSENT_LOWAT
+          setsockopt( fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &_notSentLowat,
+                      sizeof( _notSentLowat ));
+#  endif
+          break;
+
+      case SOCKETPROFILE_THROUGHPUT:
+          setsockopt( fd, SOL_SOCKET, SO_RCVBUF, &_throughputBufferSize,
+                      sizeof( _throughputBufferSize ));
+          setsockopt( fd, SOL_SOCKET, SO_SNDBUF, &_throughputBufferSize,
+                      sizeof( _throughputBufferSize ));
+#  if defined( SO_ZEROCOPY ) && defined( SO_EE_ORIGIN_ZEROCOPY )
+          _zeroCopy = setsockopt( fd, SOL_SOCKET, SO_ZEROCOPY, &on,
+                                  sizeof( on )) == 0;
+#  endif
+          break;
+
+      default:
+          break;
+    }
+
+#  ifdef SO_INCOMING_CPU
+    if( description->cpu >= 0 &&
+        setsockopt( fd, SOL_SOCKET, SO_INCOMING_CPU, &description->cpu,
+                    sizeof( description->cpu )) != 0 )
+    {
+        LBWARN << "Can't set incoming CPU " << description->cpu << ": "
+               << lunchbox::sysError << std::endl;
+    }
+#  endif
 #endif
 }
 
@@ -23,6 +23,7 @@
 #include <co/connectionType.h> // enum
 #include <lunchbox/api.h>
 #include <lunchbox/buffer.h> // member
+#include <lunchbox/lock.h> // member
 #include <lunchbox/os.h>
 #include <lunchbox/thread.h> // for LB_TS_VAR
 
@@ -72,11 +73,19 @@ namespace co
 
 #ifdef WIN32
         void readNB( void* buffer, const uint64_t bytes ) override;
+#endif
         int64_t readSync( void* buffer, const uint64_t bytes,
                                   const bool block ) override;
+#ifdef WIN32
         int64_t write( const void* buffer,
                                const uint64_t bytes ) override;
+#else
+        int64_t writeRetained( const void* buffer,
+                               const uint64_t bytes ) override;
+        bool releaseWriteBuffers() override { return _waitZeroCopy(); }
+#endif
 
+#ifdef WIN32
         typedef UINT_PTR Socket;
 #else
         //! @cond IGNORE
@@ -113,8 +122,18 @@ namespace co
         DWORD      _overlappedDone;
 
         LB_TS_VAR( _recvThread );
+#else
+        bool _quickAck;          //!< Re-arm TCP_QUICKACK after each read
+        bool _zeroCopy;          //!< Send large retained writes zero-copy
+        uint32_t _zeroCopySends; //!< Number of zero-copy sends
+        uint32_t _zeroCopyDone;  //!< Number of completed zero-copy sends
+
+        /** Wait until the kernel released all zero-copy send buffers. */
+        bool _waitZeroCopy();
 #endif
 
+        lunchbox::Lock _closeLock; //!< held by the thread closing the socket
+
         void _close();
     };
 }
@@ -29,8 +29,6 @@
 
 namespace co
 {
-typedef CommandFunc< StaticSlaveCM > CmdFunc;
-
 StaticSlaveCM::StaticSlaveCM( Object* object )
         : ObjectCM( object )
         , _currentIStream( new ObjectDataIStream )
@@ -38,8 +36,8 @@ StaticSlaveCM::StaticSlaveCM( Object* object )
     LBASSERT( _object );
     LBASSERT( object->getLocalNode( ));
 
-    object->registerCommand( CMD_OBJECT_INSTANCE,
-                             CmdFunc( this, &StaticSlaveCM::_cmdInstance ), 0 );
+    object->registerCommand< StaticSlaveCM, &StaticSlaveCM::_cmdInstance >(
+        CMD_OBJECT_INSTANCE, this, 0 );
 }
 
 StaticSlaveCM::~StaticSlaveCM()
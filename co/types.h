@@ -60,6 +60,7 @@ class ObjectDataIStream;
 class ObjectDataOCommand;
 class ObjectFactory;
 class ObjectHandler;
+class ObjectMap;
 class ObjectOCommand;
 class QueueItem;
 class QueueMaster;
@@ -0,0 +1,429 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "uring.h"
+
+#include "log.h"
+
+#include <lunchbox/clock.h>
+#include <lunchbox/debug.h>
+#include <lunchbox/lock.h>
+#include <lunchbox/os.h>
+#include <lunchbox/scopedMutex.h>
+
+#include <algorithm>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef __NR_io_uring_setup
+#  define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#  define __NR_io_uring_enter 426
+#endif
+#if defined( IORING_SETUP_ATTACH_WQ ) && defined( IORING_FEAT_SQPOLL_NONFIXED )
+#  define CO_URING_SQPOLL
+#endif
+
+namespace co
+{
+namespace
+{
+// Requests larger than this are truncated, callers handle partial IO
+static const uint64_t _maxBytes = 1u << 30;
+
+// Completion queue checks before waiting for the kernel submission thread
+static const size_t _spinCount = 1000;
+
+#ifdef CO_URING_SQPOLL
+// The ring owning the submission thread shared by all rings, kept until
+// co::exit. -2 if the kernel can't poll for us.
+lunchbox::Lock _sqPollLock;
+int _sqPollFD = -1;
+
+int _getSQPollFD( const uint32_t sqPollIdle )
+{
+    lunchbox::ScopedMutex<> mutex( _sqPollLock );
+    if( _sqPollFD != -1 )
+        return _sqPollFD;
+
+    io_uring_params params;
+    ::memset( &params, 0, sizeof( params ));
+    params.flags = IORING_SETUP_SQPOLL;
+    params.sq_thread_idle = sqPollIdle;
+
+    const int fd = int( ::syscall( __NR_io_uring_setup, 1, &params ));
+    // older kernels poll only for registered files
+    if( fd >= 0 && ( params.features & IORING_FEAT_SQPOLL_NONFIXED ))
+        _sqPollFD = fd;
+    else
+    {
+        LBINFO << "io_uring submission polling not available" << std::endl;
+        if( fd >= 0 )
+            ::close( fd );
+        _sqPollFD = -2;
+    }
+    return _sqPollFD;
+}
+#endif
+
+inline uint32_t _loadAcquire( const uint32_t* value )
+    { return __atomic_load_n( value, __ATOMIC_ACQUIRE ); }
+
+inline void _storeRelease( uint32_t* value, const uint32_t data )
+    { __atomic_store_n( value, data, __ATOMIC_RELEASE ); }
+
+inline uint32_t* _offset( void* base, const uint32_t offset )
+    { return reinterpret_cast< uint32_t* >(
+            static_cast< uint8_t* >( base ) + offset ); }
+
+int _enter( const int fd, const uint32_t toSubmit, const uint32_t minComplete,
+            const uint32_t flags, const void* arg = 0, const size_t size = 0 )
+{
+    return int( ::syscall( __NR_io_uring_enter, fd, toSubmit, minComplete,
+                           flags, arg, size ));
+}
+}
+
+URing::URing()
+    : _fd( -1 )
+    , _entries( 0 )
+    , _queued( 0 )
+    , _pending( 0 )
+    , _extArg( false )
+    , _sqRing( MAP_FAILED )
+    , _sqRingSize( 0 )
+    , _cqRing( MAP_FAILED )
+    , _cqRingSize( 0 )
+    , _sqes( 0 )
+    , _sqesSize( 0 )
+    , _sqHead( 0 )
+    , _sqTail( 0 )
+    , _sqMask( 0 )
+    , _sqArray( 0 )
+    , _sqFlags( 0 )
+    , _cqHead( 0 )
+    , _cqTail( 0 )
+    , _cqMask( 0 )
+    , _cqes( 0 )
+{}
+
+URing::~URing()
+{
+    exit();
+}
+
+bool URing::init( const uint32_t entries, const uint32_t sqPollIdle )
+{
+    LBASSERT( !isValid( ));
+    LBASSERT( sqPollIdle > 0 );
+#ifdef CO_URING_SQPOLL
+    const int sqPollFD = _getSQPollFD( sqPollIdle );
+    if( sqPollFD < 0 )
+        return false;
+
+    io_uring_params params;
+    ::memset( &params, 0, sizeof( params ));
+    params.flags = IORING_SETUP_SQPOLL | IORING_SETUP_ATTACH_WQ;
+    params.sq_thread_idle = sqPollIdle;
+    params.wq_fd = uint32_t( sqPollFD );
+
+    _fd = int( ::syscall( __NR_io_uring_setup, entries, &params ));
+    if( _fd < 0 )
+    {
+        LBINFO << "io_uring not available: " << lunchbox::sysError
+               << std::endl;
+        _fd = -1;
+        return false;
+    }
+
+#ifdef IORING_FEAT_EXT_ARG
+    _extArg = params.features & IORING_FEAT_EXT_ARG;
+#endif
+    _entries = params.sq_entries;
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof( uint32_t );
+    _cqRingSize = params.cq_off.cqes +
+                  params.cq_entries * sizeof( io_uring_cqe );
+    const bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if( singleMap )
+        _sqRingSize = _cqRingSize = std::max( _sqRingSize, _cqRingSize );
+
+    _sqRing = ::mmap( 0, _sqRingSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING );
+    if( _sqRing == MAP_FAILED )
+    {
+        LBWARN << "Can't map io_uring submission queue: "
+               << lunchbox::sysError << std::endl;
+        exit();
+        return false;
+    }
+
+    if( singleMap )
+        _cqRing = _sqRing;
+    else
+    {
+        _cqRing = ::mmap( 0, _cqRingSize, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING );
+        if( _cqRing == MAP_FAILED )
+        {
+            LBWARN << "Can't map io_uring completion queue: "
+                   << lunchbox::sysError << std::endl;
+            exit();
+            return false;
+        }
+    }
+
+    _sqesSize = params.sq_entries * sizeof( io_uring_sqe );
+    void* sqes = ::mmap( 0, _sqesSize, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES );
+    if( sqes == MAP_FAILED )
+    {
+        LBWARN << "Can't map io_uring submission entries: "
+               << lunchbox::sysError << std::endl;
+        exit();
+        return false;
+    }
+    _sqes = static_cast< io_uring_sqe* >( sqes );
+
+    _sqHead = _offset( _sqRing, params.sq_off.head );
+    _sqTail = _offset( _sqRing, params.sq_off.tail );
+    _sqMask = _offset( _sqRing, params.sq_off.ring_mask );
+    _sqArray = _offset( _sqRing, params.sq_off.array );
+    _sqFlags = _offset( _sqRing, params.sq_off.flags );
+    _cqHead = _offset( _cqRing, params.cq_off.head );
+    _cqTail = _offset( _cqRing, params.cq_off.tail );
+    _cqMask = _offset( _cqRing, params.cq_off.ring_mask );
+    _cqes = reinterpret_cast< io_uring_cqe* >( _offset( _cqRing,
+                                                       params.cq_off.cqes ));
+    return true;
+#else
+    (void)entries;
+    (void)sqPollIdle;
+    return false;
+#endif
+}
+
+void URing::exitSQPoll()
+{
+#ifdef CO_URING_SQPOLL
+    // attached rings keep the kernel thread running until they are closed
+    lunchbox::ScopedMutex<> mutex( _sqPollLock );
+    if( _sqPollFD >= 0 )
+        ::close( _sqPollFD );
+    _sqPollFD = -1;
+#endif
+}
+
+void URing::exit()
+{
+    if( _sqes )
+        ::munmap( _sqes, _sqesSize );
+    if( _cqRing != MAP_FAILED && _cqRing != _sqRing )
+        ::munmap( _cqRing, _cqRingSize );
+    if( _sqRing != MAP_FAILED )
+        ::munmap( _sqRing, _sqRingSize );
+    if( _fd >= 0 )
+        ::close( _fd ); // cancels all outstanding requests
+
+    _fd = -1;
+    _entries = 0;
+    _queued = 0;
+    _pending = 0;
+    _extArg = false;
+    _sqRing = _cqRing = MAP_FAILED;
+    _sqes = 0;
+}
+
+io_uring_sqe* URing::_getSQE()
+{
+    if( !isValid( ))
+        return 0;
+
+    const uint32_t tail = *_sqTail;
+    if( tail - _loadAcquire( _sqHead ) >= _entries )
+        return 0;
+
+    const uint32_t index = tail & *_sqMask;
+    io_uring_sqe* sqe = &_sqes[ index ];
+    ::memset( sqe, 0, sizeof( io_uring_sqe ));
+    _sqArray[ index ] = index;
+    return sqe;
+}
+
+bool URing::prepare( const uint8_t opcode, const int fd, const void* buffer,
+                     const uint64_t bytes, const uint64_t userData )
+{
+    io_uring_sqe* sqe = _getSQE();
+    if( !sqe )
+        return false;
+
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->off = uint64_t( -1 ); // use and advance the current file position
+    sqe->addr = uint64_t( reinterpret_cast< uintptr_t >( buffer ));
+    sqe->len = uint32_t( std::min( bytes, _maxBytes ));
+    sqe->user_data = userData;
+
+    _storeRelease( _sqTail, *_sqTail + 1 );
+    ++_queued;
+    return true;
+}
+
+bool URing::prepareCancel( const uint64_t userData )
+{
+    io_uring_sqe* sqe = _getSQE();
+    if( !sqe )
+        return false;
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = userData;
+    sqe->user_data = 0;
+
+    _storeRelease( _sqTail, *_sqTail + 1 );
+    ++_queued;
+    return true;
+}
+
+bool URing::_needsWakeup() const
+{
+    // order the tail update before reading the flags, see io_uring_enter(2)
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    return __atomic_load_n( _sqFlags, __ATOMIC_RELAXED ) &
+           IORING_SQ_NEED_WAKEUP;
+}
+
+bool URing::submit()
+{
+    if( _queued == 0 )
+        return true;
+
+    // the kernel thread picks up the requests, unless it went to sleep
+    _pending += _queued;
+    _queued = 0;
+    while( _needsWakeup() && _enter( _fd, 0, 0, IORING_ENTER_SQ_WAKEUP ) < 0 )
+    {
+        if( errno == EINTR || errno == EAGAIN )
+            continue;
+        LBWARN << "io_uring wakeup failed: " << lunchbox::sysError
+               << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int URing::reap( uint64_t& userData, int32_t& result, const int timeout )
+{
+    lunchbox::Clock clock;
+    while( isValid( ))
+    {
+        const uint32_t head = *_cqHead;
+        if( head != _loadAcquire( _cqTail ))
+        {
+            const io_uring_cqe& cqe = _cqes[ head & *_cqMask ];
+            userData = cqe.user_data;
+            result = cqe.res;
+            _storeRelease( _cqHead, head + 1 );
+            if( _pending > 0 )
+                --_pending;
+            return 1;
+        }
+
+        if( timeout == 0 )
+            return 0;
+
+        int remaining = -1;
+        if( timeout > 0 )
+        {
+            remaining = timeout - int( clock.getTime64( ));
+            if( remaining <= 0 )
+                return 0;
+        }
+
+        const int waited = _wait( remaining );
+        if( waited <= 0 )
+            return waited;
+    }
+    return -1;
+}
+
+int URing::_wait( const int timeout )
+{
+    if( !submit( ))
+        return -1;
+    for( size_t i = 0; i < _spinCount; ++i )
+        if( *_cqHead != _loadAcquire( _cqTail ))
+            return 1;
+
+    uint32_t flags = IORING_ENTER_GETEVENTS;
+    if( _needsWakeup( ))
+        flags |= IORING_ENTER_SQ_WAKEUP;
+
+    int result = 0;
+    if( timeout < 0 )
+        result = _enter( _fd, 0, 1, flags );
+    else if( _extArg )
+    {
+#ifdef IORING_FEAT_EXT_ARG
+        __kernel_timespec ts;
+        ts.tv_sec = timeout / 1000;
+        ts.tv_nsec = ( timeout % 1000 ) * 1000000;
+
+        io_uring_getevents_arg arg;
+        ::memset( &arg, 0, sizeof( arg ));
+        arg.ts = uint64_t( reinterpret_cast< uintptr_t >( &ts ));
+        result = _enter( _fd, 0, 1, flags | IORING_ENTER_EXT_ARG,
+                         &arg, sizeof( arg ));
+#endif
+    }
+    else
+    {
+        struct pollfd fds[1];
+        fds[0].fd = _fd;
+        fds[0].events = POLLIN;
+        const int res = ::poll( fds, 1, timeout );
+        if( res == 0 )
+            return 0;
+        if( res < 0 && errno != EINTR )
+        {
+            LBWARN << "io_uring wait failed: " << lunchbox::sysError
+                   << std::endl;
+            return -1;
+        }
+        return 1;
+    }
+
+    if( result < 0 )
+    {
+        if( errno == ETIME )
+            return 0;
+        if( errno == EINTR || errno == EAGAIN || errno == EBUSY )
+            return 1;
+        LBWARN << "io_uring wait failed: " << lunchbox::sysError
+               << std::endl;
+        return -1;
+    }
+    return 1;
+}
+
+}
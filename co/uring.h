@@ -0,0 +1,151 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_URING_H
+#define CO_URING_H
+
+#include <lunchbox/types.h>
+
+#include <cstddef>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace co
+{
+    /**
+     * @internal A minimal io_uring submission and completion queue pair.
+     *
+     * Implemented directly on top of the io_uring system calls. Not thread
+     * safe: one thread prepares and submits requests, and one thread reaps
+     * completions. The ring file descriptor becomes readable when completions
+     * are pending, and can therefore be used as a connection notifier.
+     *
+     * Requests are submitted by a kernel thread shared by all rings, which
+     * picks them up without any system call while it is busy. Without
+     * submission queue polling each request would need a system call, just
+     * like plain IO, and rings are therefore not set up.
+     */
+    class URing
+    {
+    public:
+        URing();
+        ~URing();
+
+        /**
+         * Set up the ring.
+         *
+         * @param entries the submission queue depth.
+         * @param sqPollIdle the idle time in ms after which the shared kernel
+         *                   submission thread sleeps.
+         * @return false if the kernel does not support io_uring with
+         *         submission queue polling.
+         */
+        bool init( const uint32_t entries, const uint32_t sqPollIdle );
+
+        /** Release the shared kernel submission thread, called by co::exit. */
+        static void exitSQPoll();
+
+        /** Cancel all outstanding requests and tear down the ring. */
+        void exit();
+
+        /** @return true if the ring is set up. */
+        bool isValid() const { return _fd >= 0; }
+
+        /** @return the ring file descriptor. */
+        int getFD() const { return _fd; }
+
+        /** @return the number of submitted but not yet reaped requests. */
+        uint32_t getPending() const { return _pending; }
+
+        /**
+         * Queue a read or write request for the next submit().
+         *
+         * @param opcode IORING_OP_READ or IORING_OP_WRITE.
+         * @param fd the file descriptor to operate on.
+         * @param buffer the data to read into or write from.
+         * @param bytes the maximum number of bytes to transfer.
+         * @param userData the identifier returned by reap().
+         * @return false if the submission queue is full.
+         */
+        bool prepare( const uint8_t opcode, const int fd, const void* buffer,
+                      const uint64_t bytes, const uint64_t userData );
+
+        /**
+         * Queue the cancellation of the request with the given identifier.
+         *
+         * The cancellation itself completes with a zero identifier, user
+         * requests should therefore use non-zero identifiers.
+         */
+        bool prepareCancel( const uint64_t userData );
+
+        /**
+         * Submit all queued requests.
+         *
+         * Uses no system call if the kernel submission thread is awake, and
+         * one to wake it up otherwise.
+         */
+        bool submit();
+
+        /**
+         * Reap one completion.
+         *
+         * Submits queued requests first.
+         *
+         * @param userData returns the identifier of the completed request.
+         * @param result returns the result, a negative errno on failure.
+         * @param timeout the time to wait in ms, 0 to poll, -1 to wait
+         *                indefinitely.
+         * @return 1 if a completion was reaped, 0 on timeout, -1 on error.
+         */
+        int reap( uint64_t& userData, int32_t& result, const int timeout );
+
+    private:
+        int _fd;
+        uint32_t _entries;
+        uint32_t _queued;
+        uint32_t _pending;
+        bool _extArg;  //!< the kernel supports waiting with a timeout
+
+        void* _sqRing;
+        size_t _sqRingSize;
+        void* _cqRing;
+        size_t _cqRingSize;
+        io_uring_sqe* _sqes;
+        size_t _sqesSize;
+
+        uint32_t* _sqHead;
+        uint32_t* _sqTail;
+        uint32_t* _sqMask;
+        uint32_t* _sqArray;
+        uint32_t* _sqFlags;
+        uint32_t* _cqHead;
+        uint32_t* _cqTail;
+        uint32_t* _cqMask;
+        io_uring_cqe* _cqes;
+
+        io_uring_sqe* _getSQE();
+        bool _needsWakeup() const;
+        int _wait( const int timeout );
+
+        URing( const URing& );
+        URing& operator = ( const URing& );
+    };
+}
+
+#endif //CO_URING_H
@@ -0,0 +1,130 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "varint.h"
+
+#include <string.h>
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || \
+                             ( defined( __i386__ ) && defined( __SSE2__ )))
+#  define CO_VARINT_X86
+#  include <immintrin.h>
+#elif defined( __GNUC__ ) && defined( __BYTE_ORDER__ ) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#  define CO_VARINT_SWAR
+#endif
+
+namespace co
+{
+namespace
+{
+size_t _decodeScalar( const uint8_t* in, const uint64_t size,
+                      uint64_t& value )
+{
+    const uint64_t maxSize = size < VARINT_MAXSIZE ? size : VARINT_MAXSIZE;
+    uint64_t result = 0;
+    for( uint64_t i = 0; i < maxSize; ++i )
+    {
+        result |= uint64_t( in[i] & 0x7f ) << ( 7 * i );
+        if( !( in[i] & 0x80 ))
+        {
+            value = result;
+            return size_t( i + 1 );
+        }
+    }
+    return 0;
+}
+
+#if defined( CO_VARINT_X86 ) || defined( CO_VARINT_SWAR )
+#  define CO_VARINT_FAST
+// The fast path decodes varints of up to eight bytes, i.e., values below 2^56,
+// from one eight byte load.
+static const uint64_t _fastSize = 8;
+
+inline uint64_t _load( const uint8_t* in )
+{
+    uint64_t word;
+    ::memcpy( &word, in, sizeof( word ));
+    return word;
+}
+
+/** @return the size of the varint at in, 0 if it is longer than 8 bytes. */
+inline size_t _getSize( const uint8_t* in )
+{
+#  ifdef CO_VARINT_X86
+    const __m128i data = _mm_loadl_epi64(
+        reinterpret_cast< const __m128i* >( in ));
+    const unsigned ends = ~unsigned( _mm_movemask_epi8( data )) & 0xffu;
+    return ends ? size_t( __builtin_ctz( ends )) + 1 : 0;
+#  else
+    const uint64_t ends = ~_load( in ) & 0x8080808080808080ull;
+    return ends ? size_t( __builtin_ctzll( ends ) / 8 ) + 1 : 0;
+#  endif
+}
+
+/** Gather the seven bit groups of the first size bytes of word. */
+inline uint64_t _gather( uint64_t word, const size_t size )
+{
+    if( size < 8 )
+        word &= ( uint64_t( 1 ) << ( 8 * size )) - 1;
+#  ifdef __BMI2__
+    return _pext_u64( word, 0x7f7f7f7f7f7f7f7full );
+#  else
+    // merge neighbouring groups into 14, 28 and finally 56 bit groups
+    word &= 0x7f7f7f7f7f7f7f7full;
+    word = (( word & 0x7f007f007f007f00ull ) >> 1 ) |
+             ( word & 0x007f007f007f007full );
+    word = (( word & 0x3fff00003fff0000ull ) >> 2 ) |
+             ( word & 0x00003fff00003fffull );
+    word = (( word & 0x0fffffff00000000ull ) >> 4 ) |
+             ( word & 0x000000000fffffffull );
+    return word;
+#  endif
+}
+#endif
+}
+
+size_t encodeVarint( uint64_t value, uint8_t* out )
+{
+    size_t size = 0;
+    while( value >= 0x80 )
+    {
+        out[ size++ ] = uint8_t( value | 0x80 );
+        value >>= 7;
+    }
+    out[ size++ ] = uint8_t( value );
+    return size;
+}
+
+size_t decodeVarint( const uint8_t* in, const uint64_t size, uint64_t& value )
+{
+#ifdef CO_VARINT_FAST
+    if( size >= _fastSize )
+    {
+        const size_t varintSize = _getSize( in );
+        if( varintSize > 0 )
+        {
+            value = _gather( _load( in ), varintSize );
+            return varintSize;
+        }
+    }
+#endif
+    return _decodeScalar( in, size, value );
+}
+
+}
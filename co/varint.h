@@ -0,0 +1,66 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_VARINT_H
+#define CO_VARINT_H
+
+#include <lunchbox/types.h>
+
+namespace co
+{
+    /** @internal The maximum size of a LEB128-encoded 64 bit value. */
+    static const size_t VARINT_MAXSIZE = 10;
+
+    /** @internal Map signed values to unsigned ones, small magnitudes first. */
+    inline uint64_t zigzagEncode( const int64_t value )
+        { return ( uint64_t( value ) << 1 ) ^ uint64_t( value >> 63 ); }
+
+    /** @internal Reverse zigzagEncode(). */
+    inline int64_t zigzagDecode( const uint64_t value )
+        { return int64_t( value >> 1 ) ^ -int64_t( value & 1 ); }
+
+    /**
+     * @internal Encode a value as a LEB128 varint, seven bits per byte with
+     * the least significant group first.
+     *
+     * @param value the value to encode.
+     * @param out the output, at least VARINT_MAXSIZE bytes.
+     * @return the number of bytes written.
+     */
+    size_t encodeVarint( uint64_t value, uint8_t* out );
+
+    /**
+     * @internal Decode one LEB128 varint.
+     *
+     * Varints of up to eight bytes are decoded from a single load: the end is
+     * found with an SSE2 byte mask on x86, or with bit operations on other
+     * little endian CPUs, and the seven bit groups are gathered with BMI2, if
+     * enabled at compile time, or with a shift sequence. Longer varints,
+     * input near the end of the buffer and big endian CPUs use a scalar loop.
+     *
+     * @param in the input.
+     * @param size the number of input bytes available.
+     * @param value the decoded value.
+     * @return the number of bytes read, 0 if the input is truncated or the
+     *         varint is longer than VARINT_MAXSIZE.
+     */
+    size_t decodeVarint( const uint8_t* in, const uint64_t size,
+                         uint64_t& value );
+}
+
+#endif //CO_VARINT_H
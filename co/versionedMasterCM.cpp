@@ -27,8 +27,6 @@
 
 namespace co
 {
-typedef CommandFunc<VersionedMasterCM> CmdFunc;
-
 VersionedMasterCM::VersionedMasterCM( Object* object )
         : ObjectCM( object )
         , _version( VERSION_NONE )
@@ -38,19 +36,19 @@ VersionedMasterCM::VersionedMasterCM( Object* object )
     LBASSERT( object->getLocalNode( ));
 
     // sync commands are send to all instances, even the master gets it
-    object->registerCommand( CMD_OBJECT_INSTANCE,
-                             CmdFunc( this, &VersionedMasterCM::_cmdDiscard ),
-                             0 );
-    object->registerCommand( CMD_OBJECT_DELTA,
-                             CmdFunc( this, &VersionedMasterCM::_cmdDiscard ),
-                             0 );
-
-    object->registerCommand( CMD_OBJECT_SLAVE_DELTA,
-                            CmdFunc( this, &VersionedMasterCM::_cmdSlaveDelta ),
-                             0 );
-    object->registerCommand( CMD_OBJECT_MAX_VERSION,
-                            CmdFunc( this, &VersionedMasterCM::_cmdMaxVersion ),
-                             0 );
+    object->registerCommand< VersionedMasterCM,
+                             &VersionedMasterCM::_cmdDiscard >(
+        CMD_OBJECT_INSTANCE, this, 0 );
+    object->registerCommand< VersionedMasterCM,
+                             &VersionedMasterCM::_cmdDiscard >(
+        CMD_OBJECT_DELTA, this, 0 );
+
+    object->registerCommand< VersionedMasterCM,
+                             &VersionedMasterCM::_cmdSlaveDelta >(
+        CMD_OBJECT_SLAVE_DELTA, this, 0 );
+    object->registerCommand< VersionedMasterCM,
+                             &VersionedMasterCM::_cmdMaxVersion >(
+        CMD_OBJECT_MAX_VERSION, this, 0 );
 }
 
 VersionedMasterCM::~VersionedMasterCM()
@@ -30,8 +30,6 @@
 
 namespace co
 {
-typedef CommandFunc< VersionedSlaveCM > CmdFunc;
-
 VersionedSlaveCM::VersionedSlaveCM( Object* object, uint32_t masterInstanceID )
         : ObjectCM( object )
         , _version( VERSION_NONE )
@@ -44,10 +42,10 @@ VersionedSlaveCM::VersionedSlaveCM( Object* object, uint32_t masterInstanceID )
 {
     LBASSERT( object );
 
-    object->registerCommand( CMD_OBJECT_INSTANCE,
-                             CmdFunc( this, &VersionedSlaveCM::_cmdData ), 0 );
-    object->registerCommand( CMD_OBJECT_DELTA,
-                             CmdFunc( this, &VersionedSlaveCM::_cmdData ), 0 );
+    object->registerCommand< VersionedSlaveCM, &VersionedSlaveCM::_cmdData >(
+        CMD_OBJECT_INSTANCE, this, 0 );
+    object->registerCommand< VersionedSlaveCM, &VersionedSlaveCM::_cmdData >(
+        CMD_OBJECT_DELTA, this, 0 );
 }
 
 VersionedSlaveCM::~VersionedSlaveCM()
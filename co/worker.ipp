@@ -45,6 +45,21 @@ template< class Q > void WorkerThread< Q >::run()
                 break;
 
             _commands.pump();
+
+            // preempt the remaining batch by more urgent commands
+            if( i + 1 != commands.end( ))
+            {
+                const CommandPriority priority = ( i + 1 )->getPriority();
+                for( ICommand urgent = _commands.tryPopUrgent( priority );
+                     urgent.isValid();
+                     urgent = _commands.tryPopUrgent( priority ))
+                {
+                    if( !urgent( ))
+                    {
+                        LBABORT( "Error handling " << urgent );
+                    }
+                }
+            }
         }
     }
 
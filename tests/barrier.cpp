@@ -20,6 +20,7 @@
 #include <co/barrier.h>
 #include <co/connection.h>
 #include <co/connectionDescription.h>
+#include <co/global.h>
 #include <co/init.h>
 #include <co/node.h>
 #include <lunchbox/monitor.h>
@@ -89,13 +90,20 @@ int main( int argc, char **argv )
     lunchbox::RNG rng;
     _port =(rng.get<uint16_t>() % 60000) + 1024;
 
-    NodeThread server( true );
-    NodeThread node( false );
-
-    server.start();
-    node.start();
-    server.join();
-    node.join();
+    // run on the command thread and on the command thread pool
+    for( int32_t poolSize = 0; poolSize <= 2; poolSize += 2 )
+    {
+        co::Global::setIAttribute( co::Global::IATTR_COMMAND_POOL_SIZE,
+                                   poolSize );
+        NodeThread server( true );
+        NodeThread node( false );
+
+        server.start();
+        node.start();
+        server.join();
+        node.join();
+        _port += 2;
+    }
 
     co::exit();
     return EXIT_SUCCESS;
@@ -0,0 +1,78 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <co/chunkStore.h> // private header
+
+#include <string.h>
+
+// Tests that identical chunks of similar data are stored once, and that the
+// data is restored unchanged from its chunks.
+
+#define N_CHUNKS 10
+#define SIZE ( N_CHUNKS * co::ChunkStore::CHUNK_SIZE + 42 )
+
+namespace
+{
+bool _equals( const co::ChunkStore& store, const co::ChunkStore::Chunks& chunks,
+              const lunchbox::Bufferb& data )
+{
+    lunchbox::Bufferb buffer;
+    store.copy( chunks, buffer );
+    return buffer.getSize() == data.getSize() &&
+           ::memcmp( buffer.getData(), data.getData(), data.getSize( )) == 0;
+}
+}
+
+int main( int, char** )
+{
+    lunchbox::Bufferb first;
+    first.resize( SIZE );
+    for( uint64_t i = 0; i < SIZE; ++i )
+        first[ i ] = uint8_t( i * 7 + ( i >> 16 ) * 31 );
+
+    co::ChunkStore store;
+    co::ChunkStore::Chunks firstChunks;
+    store.insert( first.getData(), first.getSize(), firstChunks );
+    TEST( firstChunks.size() == N_CHUNKS + 1 );
+    TEST( store.getNumChunks() == N_CHUNKS + 1 );
+    TEST( store.getSize() == SIZE );
+    TEST( _equals( store, firstChunks, first ));
+
+    // a second version changing one byte only adds one chunk
+    lunchbox::Bufferb second( first );
+    second[ SIZE / 2 ] ^= 0xff;
+
+    co::ChunkStore::Chunks secondChunks;
+    store.insert( second.getData(), second.getSize(), secondChunks );
+    TEST( store.getNumChunks() == N_CHUNKS + 2 );
+    TEST( store.getSize() == SIZE + co::ChunkStore::CHUNK_SIZE );
+    TEST( _equals( store, secondChunks, second ));
+    TEST( _equals( store, firstChunks, first ));
+
+    // releasing the first version keeps the shared chunks
+    store.release( firstChunks );
+    TEST( firstChunks.empty( ));
+    TEST( store.getNumChunks() == N_CHUNKS + 1 );
+    TEST( store.getSize() == SIZE );
+    TEST( _equals( store, secondChunks, second ));
+
+    store.release( secondChunks );
+    TEST( store.getNumChunks() == 0 );
+    TEST( store.getSize() == 0 );
+    return EXIT_SUCCESS;
+}
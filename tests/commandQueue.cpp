@@ -0,0 +1,162 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests the priority and deadline scheduling of the CommandQueue
+
+// https://github.com/Eyescale/Equalizer/issues/100
+#pragma warning( disable: 4407 )
+
+#include <test.h>
+#include <co/buffer.h>
+#include <co/bufferCache.h>
+#include <co/commandFunc.h>
+#include <co/commandQueue.h>
+#include <co/iCommand.h>
+#include <co/localNode.h>
+#include <co/oCommand.h>
+#include <lunchbox/sleep.h>
+#include <lunchbox/thread.h>
+
+enum
+{
+    CMD_LOW = co::CMD_NODE_CUSTOM,
+    CMD_NORMAL,
+    CMD_HIGH,
+    CMD_DEADLINE
+};
+
+class QueueNode : public co::LocalNode
+{
+public:
+    QueueNode()
+        {
+            typedef co::CommandFunc< QueueNode > CmdFunc;
+            const CmdFunc func( this, &QueueNode::cmd );
+            registerCommand( CMD_LOW, func, &queue, co::COMMANDPRIORITY_LOW );
+            registerCommand( CMD_NORMAL, func, &queue );
+            registerCommand( CMD_HIGH, func, &queue, co::COMMANDPRIORITY_HIGH );
+            registerCommand( CMD_DEADLINE, func, &queue,
+                             co::COMMANDPRIORITY_LOW, 1 /*ms*/ );
+        }
+
+    bool cmd( co::ICommand& ) { return true; }
+
+    void push( co::ICommand& command, const uint32_t cmd )
+        {
+            command.setCommand( cmd );
+            TEST( dispatchCommand( command ));
+        }
+
+    co::CommandQueue queue;
+};
+
+static const size_t nProducers = 4;
+static const size_t nCommands = 10000;
+
+class Producer : public lunchbox::Thread
+{
+public:
+    Producer( co::CommandQueue& queue, const co::ICommand& command )
+        : _queue( queue ), _command( command ) {}
+
+    virtual void run()
+        {
+            for( size_t i = 0; i < nCommands; ++i )
+                _queue.push( _command );
+        }
+
+private:
+    co::CommandQueue& _queue;
+    const co::ICommand _command;
+};
+
+int main( int argc, char **argv )
+{
+    co::BufferCache cache( 10 );
+    co::LocalNodePtr localNode = new co::LocalNode;
+
+    const uint64_t size = co::OCommand::getSize();
+    co::BufferPtr buffer = cache.alloc( co::COMMAND_ALLOCSIZE );
+    buffer->resize( size );
+    reinterpret_cast< uint64_t* >( buffer->getData( ))[ 0 ] = size;
+
+    co::ICommand command( localNode, localNode, buffer, false );
+    command.setType( co::COMMANDTYPE_NODE );
+
+    lunchbox::RefPtr< QueueNode > node = new QueueNode;
+    node->push( command, CMD_LOW );
+    node->push( command, CMD_NORMAL );
+    node->push( command, CMD_HIGH );
+    node->push( command, CMD_LOW );
+    node->push( command, CMD_HIGH );
+    TEST( node->queue.getSize() == 5 );
+
+    // urgent commands only preempt less urgent classes
+    TEST( !node->queue.tryPopUrgent( co::COMMANDPRIORITY_HIGH ).isValid( ));
+    co::ICommand urgent = node->queue.tryPopUrgent( co::COMMANDPRIORITY_LOW );
+    TEST( urgent.isValid( ));
+    TEST( urgent.getCommand() == CMD_HIGH );
+
+    co::ICommands commands = node->queue.popAll();
+    TESTINFO( commands.size() == 2, commands.size( ));
+    TEST( commands[0].getCommand() == CMD_HIGH );
+    TEST( commands[1].getCommand() == CMD_NORMAL );
+
+    commands = node->queue.popAll();
+    TESTINFO( commands.size() == 2, commands.size( ));
+    TEST( commands[0].getCommand() == CMD_LOW );
+    TEST( commands[1].getCommand() == CMD_LOW );
+    TEST( node->queue.isEmpty( ));
+
+    // overdue commands are promoted
+    node->push( command, CMD_DEADLINE );
+    lunchbox::sleep( 10 );
+    node->push( command, CMD_NORMAL );
+    TEST( node->queue.pop().getCommand() == CMD_DEADLINE );
+    TEST( node->queue.pop().getCommand() == CMD_NORMAL );
+    TEST( node->queue.isEmpty( ));
+
+    // concurrent producers, single consumer
+    command.setCommand( CMD_NORMAL );
+    Producer* producers[ nProducers ];
+    for( size_t i = 0; i < nProducers; ++i )
+    {
+        producers[i] = new Producer( node->queue, command );
+        TEST( producers[i]->start( ));
+    }
+
+    size_t nPopped = 0;
+    while( nPopped < nProducers * nCommands )
+    {
+        if( nPopped % 2 )
+            nPopped += node->queue.popAll().size();
+        else
+        {
+            TEST( node->queue.pop().getCommand() == CMD_NORMAL );
+            ++nPopped;
+        }
+    }
+
+    for( size_t i = 0; i < nProducers; ++i )
+    {
+        TEST( producers[i]->join( ));
+        delete producers[i];
+    }
+    TESTINFO( nPopped == nProducers * nCommands, nPopped );
+    TEST( node->queue.isEmpty( ));
+
+    return EXIT_SUCCESS;
+}
@@ -21,9 +21,13 @@
 #include <co/connection.h>
 #include <co/connectionDescription.h>
 #include <co/connectionSet.h>
+#include <co/global.h>
 #include <co/init.h>
 
 #include <lunchbox/monitor.h>
+#include <lunchbox/rng.h>
+#include <lunchbox/sleep.h>
+#include <lunchbox/thread.h>
 #include <iostream>
 
 #define PACKETSIZE (2048)
@@ -35,6 +39,7 @@ static co::ConnectionType types[] =
     co::CONNECTIONTYPE_TCPIP,
     co::CONNECTIONTYPE_PIPE,
     co::CONNECTIONTYPE_RSP,
+    co::CONNECTIONTYPE_RELAY,
 #ifdef WIN32
     co::CONNECTIONTYPE_NAMEDPIPE,
 #endif
@@ -43,6 +48,26 @@ static co::ConnectionType types[] =
 #endif
     co::CONNECTIONTYPE_NONE // must be last
 };
+
+class Reader : public lunchbox::Thread
+{
+public:
+    Reader( co::ConnectionPtr connection, const uint64_t size )
+        : _connection( connection ), _size( size ) {}
+
+    void run() override
+    {
+        co::BufferPtr syncBuffer;
+        _connection->recvNB( &buffer, _size );
+        _connection->recvSync( syncBuffer );
+    }
+
+    co::Buffer buffer;
+
+private:
+    co::ConnectionPtr _connection;
+    const uint64_t _size;
+};
 }
 
 int main( int argc, char **argv )
@@ -54,7 +79,7 @@ int main( int argc, char **argv )
         co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
         desc->type = types[i];
 
-        if( desc->type >= co::CONNECTIONTYPE_MULTICAST )
+        if( desc->type == co::CONNECTIONTYPE_RSP )
             desc->setHostname( "239.255.12.34" );
         else
             desc->setHostname( "127.0.0.1" );
@@ -75,6 +100,7 @@ int main( int argc, char **argv )
                 break;
 
             case co::CONNECTIONTYPE_RSP:
+            case co::CONNECTIONTYPE_RELAY:
                 TESTINFO( listener->listen(), desc );
                 listener->acceptNB();
 
@@ -123,6 +149,192 @@ int main( int argc, char **argv )
         TEST( writer->getRefCount() == 1 );
     }
 
+    // io_uring-based IO where available, plain IO otherwise
+    co::Global::setIAttribute( co::Global::IATTR_URING_QUEUE_DEPTH, 8 );
+    for( size_t i = 0; i < 2; ++i )
+    {
+        co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+        desc->type = i == 0 ? co::CONNECTIONTYPE_PIPE :
+                              co::CONNECTIONTYPE_TCPIP;
+        desc->setHostname( "127.0.0.1" );
+
+        co::ConnectionPtr listener = co::Connection::create( desc );
+        co::ConnectionPtr writer;
+        co::ConnectionPtr reader;
+        if( desc->type == co::CONNECTIONTYPE_PIPE )
+        {
+            writer = listener;
+            TEST( writer->connect( ));
+            reader = writer->acceptSync();
+        }
+        else
+        {
+            TESTINFO( listener->listen(), desc );
+            listener->acceptNB();
+
+            writer = co::Connection::create( desc );
+            TEST( writer->connect( ));
+            reader = listener->acceptSync();
+            listener->close();
+        }
+        TEST( reader.isValid( ));
+
+        uint8_t out[ PACKETSIZE ];
+        for( size_t j = 0; j < PACKETSIZE; ++j )
+            out[j] = uint8_t( j );
+
+        for( size_t j = 0; j < 16; ++j )
+        {
+            co::Buffer buffer;
+            co::BufferPtr syncBuffer;
+            reader->recvNB( &buffer, PACKETSIZE );
+            TEST( writer->send( out, PACKETSIZE ));
+            TEST( reader->recvSync( syncBuffer ));
+            TEST( buffer.getSize() == PACKETSIZE );
+            TEST( ::memcmp( buffer.getData(), out, PACKETSIZE ) == 0 );
+        }
+
+        writer->close();
+        co::Buffer buffer;
+        co::BufferPtr syncBuffer;
+        reader->recvNB( &buffer, PACKETSIZE );
+        TEST( !reader->recvSync( syncBuffer ));
+        TEST( reader->isClosed( ));
+    }
+    co::Global::setIAttribute( co::Global::IATTR_URING_QUEUE_DEPTH, 0 );
+
+    // parallel send to many connections
+    co::Connections writers;
+    co::Connections readers;
+    for( size_t i = 0; i < 4; ++i )
+    {
+        co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+        desc->type = co::CONNECTIONTYPE_PIPE;
+        co::ConnectionPtr writer = co::Connection::create( desc );
+        TEST( writer->connect( ));
+        writers.push_back( writer );
+        readers.push_back( writer->acceptSync( ));
+    }
+
+    std::vector< uint8_t > data( 32768 );
+    for( size_t i = 0; i < data.size(); ++i )
+        data[i] = uint8_t( i );
+    TEST( co::Connection::send( writers, &data.front(), data.size( )));
+
+    for( size_t i = 0; i < readers.size(); ++i )
+    {
+        co::Buffer buffer;
+        co::BufferPtr syncBuffer;
+        readers[i]->recvNB( &buffer, data.size( ));
+        TEST( readers[i]->recvSync( syncBuffer ));
+        TEST( buffer.getSize() == data.size( ));
+        TEST( ::memcmp( buffer.getData(), &data.front(), data.size( )) == 0 );
+        writers[i]->close();
+    }
+
+    // socket tuning profiles
+    std::string profileString( "127.0.0.1:TCPIP:THROUGHPUT:CPU0" );
+    co::ConnectionDescriptionPtr profileDesc =
+        new co::ConnectionDescription( profileString );
+    TEST( profileDesc->profile == co::SOCKETPROFILE_THROUGHPUT );
+    TEST( profileDesc->cpu == 0 );
+
+    std::string serialized = co::serialize(
+        co::ConnectionDescriptions( 2, profileDesc ));
+    co::ConnectionDescriptions descriptions;
+    TEST( co::deserialize( serialized, descriptions ));
+    TEST( serialized.empty( ));
+    TEST( descriptions.size() == 2 );
+    TEST( *descriptions.back() == *profileDesc );
+
+    for( int i = co::SOCKETPROFILE_DEFAULT; i <= co::SOCKETPROFILE_THROUGHPUT;
+         ++i )
+    {
+        co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+        desc->setHostname( "127.0.0.1" );
+        desc->profile = co::SocketProfile( i );
+
+        co::ConnectionPtr listener = co::Connection::create( desc );
+        TESTINFO( listener->listen(), desc );
+        listener->acceptNB();
+
+        co::ConnectionDescriptionPtr writerDesc = new co::ConnectionDescription;
+        writerDesc->setHostname( "127.0.0.1" );
+        writerDesc->port = listener->getDescription()->port;
+        writerDesc->profile = desc->profile;
+        co::ConnectionPtr writer = co::Connection::create( writerDesc );
+        TEST( writer->connect( ));
+        co::ConnectionPtr reader = listener->acceptSync();
+        TEST( reader.isValid( ));
+        TEST( reader->getDescription()->profile == desc->profile );
+
+        // large enough for zero-copy sends, exceeding the socket buffers
+        std::vector< uint8_t > payload( 1048576, uint8_t( i ));
+        Reader readerThread( reader, payload.size( ));
+        readerThread.start();
+        writer->setSendQueueSize( payload.size( )); // zero-copy sends
+        TEST( writer->send( &payload.front(), payload.size( )));
+        writer->finish();
+        readerThread.join();
+        TEST( readerThread.buffer.getSize() == payload.size( ));
+        TEST( ::memcmp( readerThread.buffer.getData(), &payload.front(),
+                        payload.size( )) == 0 );
+
+        writer->close();
+        reader->close();
+        listener->close();
+    }
+
+    // relay tree repair: with a fanout of one, closing the middle member of
+    // root - middle - leaf attaches the leaf to the root
+    co::Global::setIAttribute( co::Global::IATTR_RELAY_FANOUT, 1 );
+    {
+        co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+        desc->type = co::CONNECTIONTYPE_RELAY;
+        desc->setHostname( "127.0.0.1" );
+        lunchbox::RNG rng;
+        desc->port = ( rng.get< uint16_t >() % 60000 ) + 1024;
+
+        co::ConnectionPtr root = co::Connection::create( desc );
+        co::ConnectionPtr middle = co::Connection::create( desc );
+        co::ConnectionPtr leaf = co::Connection::create( desc );
+        TEST( root->listen( ));
+        TEST( middle->listen( ));
+        TEST( leaf->listen( ));
+
+        middle->close();
+        lunchbox::sleep( 1000 ); // leaf joins the root again
+
+        uint8_t out[ PACKETSIZE ];
+        for( size_t i = 0; i < PACKETSIZE; ++i )
+            out[i] = uint8_t( i );
+        TEST( root->send( out, PACKETSIZE ));
+        lunchbox::sleep( 500 );
+
+        // readers of the leaf itself and of the root
+        co::ConnectionSet leafReaders;
+        leafReaders.addConnection( leaf->acceptSync( ));
+        leafReaders.addConnection( leaf->acceptSync( ));
+        TEST( leafReaders.select( 2000 ) == co::ConnectionSet::EVENT_DATA );
+
+        co::ConnectionPtr reader = leafReaders.getConnection();
+        co::Buffer buffer;
+        co::BufferPtr syncBuffer;
+        reader->recvNB( &buffer, PACKETSIZE );
+        TEST( reader->recvSync( syncBuffer ));
+        TEST( ::memcmp( buffer.getData(), out, PACKETSIZE ) == 0 );
+
+        const co::Connections& connections = leafReaders.getConnections();
+        while( !connections.empty( ))
+        {
+            co::ConnectionPtr connection = connections.back();
+            leafReaders.removeConnection( connection );
+            connection->close();
+        }
+        leaf->close();
+        root->close();
+    }
+
     co::exit();
     return EXIT_SUCCESS;
 }
@@ -24,8 +24,10 @@
 
 const co::uint128_t cmdID1( lunchbox::make_uint128( "cmdID1" ));
 const co::uint128_t cmdID2( lunchbox::make_uint128( "cmdID2" ));
+const co::uint128_t cmdID3( lunchbox::make_uint128( "cmdID3" ));
 lunchbox::Monitor<bool> gotCmd1;
 lunchbox::Monitor<bool> gotCmd2;
+lunchbox::Monitor<bool> gotCmd3;
 
 class MyLocalNode : public co::LocalNode
 {
@@ -44,6 +46,14 @@ public:
         TEST( command.get< std::string >() == "hello" );
         return true;
     }
+
+    bool cmdCustom3( co::CustomICommand& command )
+    {
+        TEST( command.getCommandID() == cmdID3 );
+        gotCmd3 = true;
+        TEST( command.get< std::string >() == "pool" );
+        return true;
+    }
 };
 
 typedef lunchbox::RefPtr< MyLocalNode > MyLocalNodePtr;
@@ -51,6 +61,7 @@ typedef lunchbox::RefPtr< MyLocalNode > MyLocalNodePtr;
 int main( int argc, char **argv )
 {
     TEST( co::init( argc, argv ) );
+    co::Global::setIAttribute( co::Global::IATTR_COMMAND_POOL_SIZE, 2 );
 
     co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
 
@@ -82,12 +93,18 @@ int main( int argc, char **argv )
     server->registerCommandHandler( cmdID2,
                                     boost::bind( &MyLocalNode::cmdCustom2,
                                                  server.get(), _1 ), 0 );
+    server->registerCommandHandler( cmdID3,
+                                    boost::bind( &MyLocalNode::cmdCustom3,
+                                                 server.get(), _1 ),
+                                    server->getCommandPoolQueue( ));
 
     serverProxy->send( cmdID1 );
     serverProxy->send( cmdID2 ) << std::string( "hello" );
+    serverProxy->send( cmdID3 ) << std::string( "pool" );
 
     TEST( gotCmd1.timedWaitEQ( true, 1000 ));
     TEST( gotCmd2.timedWaitEQ( true, 1000 ));
+    TEST( gotCmd3.timedWaitEQ( true, 1000 ));
 
     TEST( client->disconnect( serverProxy ));
     TEST( client->close( ));
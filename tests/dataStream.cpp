@@ -27,8 +27,11 @@
 #include <co/dataOStream.h>
 #include <co/init.h>
 
+#include <lunchbox/plugins/compressor.h>
 #include <lunchbox/thread.h>
 
+#include <limits>
+
 #include <co/objectDataOCommand.h> // private header
 #include <co/objectDataICommand.h> // private header
 
@@ -38,6 +41,26 @@
 
 static std::string _message( "So long, and thanks for all the fish" );
 
+struct Pod
+{
+    uint32_t index;
+    float value;
+};
+
+namespace co
+{
+template<> struct IsFlat< Pod > : public std::true_type {};
+}
+
+namespace lunchbox
+{
+template<> inline void byteswap( Pod& value )
+{
+    byteswap( value.index );
+    byteswap( value.value );
+}
+}
+
 class DataOStream : public co::DataOStream
 {
 public:
@@ -62,6 +85,7 @@ public:
         {
             co::ObjectDataICommand command( 0, 0, buffer, false /*swap*/ );
             TESTINFO( command.getCommand() == co::CMD_OBJECT_DELTA, command );
+            setCompact( command.isCompactData( ));
             _commands.push( command );
         }
 
@@ -78,6 +102,7 @@ protected:
                 return false;
 
             co::ObjectDataICommand command( cmd );
+            _buffer = command.getBuffer();
 
             TEST( command.getCommand() == co::CMD_OBJECT_DELTA );
 
@@ -88,10 +113,238 @@ protected:
             return true;
         }
 
+    virtual co::ConstBufferPtr getCurrentBuffer() const { return _buffer; }
+
 private:
     co::CommandQueue _commands;
+    co::ConstBufferPtr _buffer;
+};
+
+/** Reads one block of data from memory. */
+class MemoryIStream : public co::DataIStream
+{
+public:
+    MemoryIStream( const std::vector< uint8_t >& data, const bool swap,
+                   const bool compact )
+        : co::DataIStream( swap ), _data( data ), _done( false )
+        { setCompact( compact ); }
+
+    virtual size_t nRemainingBuffers() const { return _done ? 0 : 1; }
+    virtual lunchbox::uint128_t getVersion() const { return co::VERSION_NONE;}
+    virtual co::NodePtr getMaster() { return 0; }
+
+protected:
+    virtual bool getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
+                                const void** chunkData, uint64_t& size )
+        {
+            if( _done )
+                return false;
+            _done = true;
+            compressor = EQ_COMPRESSOR_NONE;
+            nChunks = 1;
+            *chunkData = &_data.front();
+            size = _data.size();
+            return true;
+        }
+
+private:
+    const std::vector< uint8_t >& _data;
+    bool _done;
+};
+
+/** Reads each block from its own buffer, as if flushed in between. */
+class SplitIStream : public co::DataIStream
+{
+public:
+    explicit SplitIStream( const std::vector< std::vector< uint8_t > >& data )
+        : co::DataIStream( false ), _data( data ), _next( 0 ) {}
+
+    virtual size_t nRemainingBuffers() const { return _data.size() - _next; }
+    virtual lunchbox::uint128_t getVersion() const { return co::VERSION_NONE;}
+    virtual co::NodePtr getMaster() { return 0; }
+
+protected:
+    virtual bool getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
+                                const void** chunkData, uint64_t& size )
+        {
+            if( _next >= _data.size( ))
+                return false;
+            compressor = EQ_COMPRESSOR_NONE;
+            nChunks = 1;
+            *chunkData = &_data[ _next ].front();
+            size = _data[ _next ].size();
+            ++_next;
+            return true;
+        }
+
+private:
+    const std::vector< std::vector< uint8_t > >& _data;
+    size_t _next;
 };
 
+/** Writes into the save buffer, without receivers. */
+class MemoryOStream : public co::DataOStream
+{
+public:
+    explicit MemoryOStream( const bool compact )
+        {
+            enableSave();
+            _setCompact( compact );
+            _enable();
+        }
+
+    std::vector< uint8_t > finish()
+        {
+            disable();
+            const lunchbox::Bufferb& buffer = getBuffer();
+            return std::vector< uint8_t >( buffer.getData(),
+                                           buffer.getData() +
+                                           buffer.getSize( ));
+        }
+
+protected:
+    virtual void sendData( const void*, const uint64_t, const bool ) {}
+};
+
+template< class T > void _appendSwapped( std::vector< uint8_t >& data,
+                                         T value )
+{
+    lunchbox::byteswap( value );
+    const uint8_t* bytes = reinterpret_cast< const uint8_t* >( &value );
+    data.insert( data.end(), bytes, bytes + sizeof( T ));
+}
+
+/** Odd sizes exercise the scalar tails of the vectorized kernels. */
+void _testSwapping( const size_t num )
+{
+    std::vector< uint8_t > data;
+    for( size_t i = 0; i < num; ++i )
+        _appendSwapped( data, uint16_t( i ));
+    for( size_t i = 0; i < num; ++i )
+        _appendSwapped( data, uint32_t( i ) * 65537u );
+    for( size_t i = 0; i < num; ++i )
+        _appendSwapped( data, double( i ) + .5 );
+    for( size_t i = 0; i < num; ++i )
+        _appendSwapped( data, co::uint128_t( i, i * 3 ));
+    for( size_t i = 0; i < num; ++i )
+        _appendSwapped( data, uint32_t( i ));
+
+    MemoryIStream stream( data, true /*swap*/, false /*compact*/ );
+    std::vector< uint16_t > shorts( num );
+    std::vector< uint32_t > ints( num );
+    std::vector< double > doubles( num );
+    std::vector< co::uint128_t > ids( num );
+    stream >> co::Array< uint16_t >( &shorts.front(), num )
+           >> co::Array< uint32_t >( &ints.front(), num )
+           >> co::Array< double >( &doubles.front(), num )
+           >> co::Array< co::uint128_t >( &ids.front(), num );
+
+    // foreign-endian views are swapped into a copy
+    const co::ArrayView< uint32_t > view = stream.readView< uint32_t >( num );
+    TEST( view.getSize() == num );
+    TEST( view.getBuffer( ));
+
+    for( size_t i = 0; i < num; ++i )
+    {
+        TESTINFO( shorts[i] == uint16_t( i ), shorts[i] << " != " << i );
+        TESTINFO( ints[i] == uint32_t( i ) * 65537u, ints[i] );
+        TESTINFO( doubles[i] == double( i ) + .5, doubles[i] );
+        TESTINFO( ids[i] == co::uint128_t( i, i * 3 ), ids[i] );
+        TESTINFO( view[i] == uint32_t( i ), view[i] );
+    }
+}
+
+template< class T > std::vector< uint8_t > _toBytes( const T& value )
+{
+    const uint8_t* bytes = reinterpret_cast< const uint8_t* >( &value );
+    return std::vector< uint8_t >( bytes, bytes + sizeof( T ));
+}
+
+/** Flat sets and maps written item by item span several buffers. */
+void _testSplitContainers()
+{
+    std::vector< std::vector< uint8_t > > data;
+    data.push_back( _toBytes( uint64_t( 3 )));
+    for( uint32_t i = 0; i < 3; ++i )
+        data.push_back( _toBytes( i * 7 ));
+    data.push_back( _toBytes( uint64_t( 2 )));
+    for( uint16_t i = 0; i < 2; ++i )
+    {
+        data.push_back( _toBytes( i ));
+        data.push_back( _toBytes( float( i ) + .5f ));
+    }
+
+    SplitIStream stream( data );
+    stde::hash_set< uint32_t > set;
+    stde::hash_map< uint16_t, float > map;
+    stream >> set >> map;
+
+    TEST( set.size() == 3 );
+    for( uint32_t i = 0; i < 3; ++i )
+        TEST( set.find( i * 7 ) != set.end( ));
+    TEST( map.size() == 2 );
+    for( uint16_t i = 0; i < 2; ++i )
+        TEST( map[ i ] == float( i ) + .5f );
+}
+
+/** Streams the same values in both encodings. */
+void _testCompact()
+{
+    const co::UUID id( 0x0123456789abcdefull, 0xfedcba9876543210ull );
+    co::ObjectVersions versions;
+    for( uint32_t i = 0; i < 100; ++i )
+        versions.push_back( co::ObjectVersion( id, co::uint128_t( i )));
+    std::map< std::string, int32_t > map;
+    map[ _message ] = -42;
+    const std::vector< uint32_t > ints( 100, 0xffffffffu );
+
+    size_t sizes[2] = { 0, 0 };
+    for( size_t i = 0; i < 2; ++i )
+    {
+        const bool compact = i == 1;
+        MemoryOStream os( compact );
+        TEST( os.isCompact() == compact );
+        os << int16_t( -2 ) << uint32_t( 300 ) << int64_t( -1234567890123ll )
+           << std::numeric_limits< uint64_t >::max() << true << 1.5f
+           << co::uint128_t( 0, 42 ) << id << versions << _message << map
+           << ints;
+        const std::vector< uint8_t > data = os.finish();
+        sizes[i] = data.size();
+
+        MemoryIStream is( data, false /*swap*/, compact );
+        int16_t i16 = 0;
+        uint32_t u32 = 0;
+        int64_t i64 = 0;
+        uint64_t u64 = 0;
+        bool flag = false;
+        float f = 0.f;
+        co::uint128_t version;
+        co::UUID uuid;
+        co::ObjectVersions versions2;
+        std::string message;
+        std::map< std::string, int32_t > map2;
+        std::vector< uint32_t > ints2;
+        is >> i16 >> u32 >> i64 >> u64 >> flag >> f >> version >> uuid
+           >> versions2 >> message >> map2 >> ints2;
+
+        TEST( is.isCompact() == compact );
+        TESTINFO( i16 == -2, i16 );
+        TESTINFO( u32 == 300, u32 );
+        TESTINFO( i64 == -1234567890123ll, i64 );
+        TESTINFO( u64 == std::numeric_limits< uint64_t >::max(), u64 );
+        TEST( flag );
+        TEST( f == 1.5f );
+        TESTINFO( version == co::uint128_t( 0, 42 ), version );
+        TESTINFO( uuid == id, uuid );
+        TEST( versions2 == versions );
+        TEST( message == _message );
+        TEST( map2 == map );
+        TEST( ints2 == ints );
+        TEST( !is.hasData( ));
+    }
+    TESTINFO( sizes[1] < sizes[0], sizes[1] << " >= " << sizes[0] );
+}
+
 namespace co
 {
 namespace DataStreamTest
@@ -128,11 +381,32 @@ protected:
             stream << doubles;
             stream << _message;
 
+            std::vector< Pod > pods( CONTAINER_SIZE );
+            std::map< uint32_t, double > map;
+            std::set< uint64_t > set;
+            stde::hash_map< uint16_t, float > hashMap;
+            std::map< std::string, uint32_t > stringMap;
+            for( size_t i = 0; i < CONTAINER_SIZE; ++i )
+            {
+                pods[i].index = uint32_t( i );
+                pods[i].value = float( i );
+                map[ uint32_t( i ) ] = double( i );
+                set.insert( i * 3 );
+                hashMap[ uint16_t( i ) ] = float( i );
+            }
+            stringMap[ _message ] = 42;
+            stream << pods << map << set << hashMap << stringMap;
+
             char blob[128];
             for( size_t i=0; i < 128; ++i )
                 blob[ i ] = char( i );
             stream << co::Array< void >( blob, 128 );
 
+            std::vector< uint32_t > ints( CONTAINER_SIZE );
+            for( size_t i = 0; i < CONTAINER_SIZE; ++i )
+                ints[i] = uint32_t( i );
+            stream << ints;
+
             stream.disable();
         }
 
@@ -154,8 +428,8 @@ int main( int argc, char **argv )
     co::DataStreamTest::Sender sender( connection->acceptSync( ));
     TEST( sender.start( ));
 
-    ::DataIStream stream;
     co::BufferCache bufferCache( 200 );
+    ::DataIStream stream; // holds a buffer, destroy before the cache
     bool receiving = true;
     const size_t minSize = co::COMMAND_MINSIZE;
     const size_t cacheSize = co::COMMAND_ALLOCSIZE;
@@ -221,14 +495,46 @@ int main( int argc, char **argv )
     TESTINFO( message == _message,
               '\'' <<  message << "' != '" << _message << '\'' );
 
+    std::vector< Pod > pods;
+    std::map< uint32_t, double > map;
+    std::set< uint64_t > set;
+    stde::hash_map< uint16_t, float > hashMap;
+    std::map< std::string, uint32_t > stringMap;
+    stream >> pods >> map >> set >> hashMap >> stringMap;
+    TEST( pods.size() == CONTAINER_SIZE );
+    TEST( map.size() == CONTAINER_SIZE );
+    TEST( set.size() == CONTAINER_SIZE );
+    TEST( hashMap.size() == CONTAINER_SIZE );
+    for( size_t i = 0; i < CONTAINER_SIZE; ++i )
+    {
+        TEST( pods[i].index == i && pods[i].value == float( i ));
+        TEST( map[ uint32_t( i ) ] == double( i ));
+        TEST( set.find( i * 3 ) != set.end( ));
+        TEST( hashMap[ uint16_t( i ) ] == float( i ));
+    }
+    TEST( stringMap.size() == 1 && stringMap[ _message ] == 42 );
+
     char blob[128] = { 0 };
     stream >> co::Array< void >( blob, 128 );
     for( size_t i=0; i < 128; ++i )
         TEST( blob[ i ] == char( i ));
 
+    co::ArrayView< uint32_t > ints;
+    stream >> ints;
+    TEST( ints.getSize() == CONTAINER_SIZE );
+    TEST( ints.getBuffer( ));
+    for( size_t i = 0; i < CONTAINER_SIZE; ++i )
+        TEST( ints[i] == i );
+
     TEST( sender.join( ));
     connection->close();
 
+    _testSwapping( 1 );
+    _testSwapping( 1001 );
+    _testSwapping( LB_1MB / 8 + 3 );
+    _testCompact();
+    _testSplitContainers();
+
     co::exit();
     return EXIT_SUCCESS;
 }
@@ -26,16 +26,27 @@
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/vector.hpp>
 
+enum Format
+{
+    FORMAT_RECEIVERS, // selected from the receiving nodes
+    FORMAT_PORTABLE,
+    FORMAT_NATIVE
+};
+
 template< typename T >
 class Object : public co::Object
 {
 public:
     Object()
         : _value()
+        , _format( FORMAT_RECEIVERS )
+        , _native( false )
     {}
 
-    Object( T value )
+    Object( T value, const Format format )
         : _value( value )
+        , _format( format )
+        , _native( false )
     {}
 
     T getValue() const
@@ -43,10 +54,17 @@ public:
         return _value;
     }
 
+    /** @return true if the last data was written in the native format. */
+    bool isNative() const { return _native; }
+
 protected:
+    virtual ChangeType getChangeType() const { return INSTANCE; }
+
     virtual void getInstanceData( co::DataOStream& os )
     {
-        co::DataOStreamArchive archive( os );
+        _native = _format == FORMAT_RECEIVERS ? os.isNativeArchive() :
+                                                _format == FORMAT_NATIVE;
+        co::DataOStreamArchive archive( os, _native );
         archive << _value;
     }
 
@@ -58,13 +76,16 @@ protected:
 
 private:
     T _value;
+    const Format _format;
+    bool _native;
 };
 
 template< typename T >
 void testObjectSerialization( co::LocalNodePtr server,
-                              co::LocalNodePtr client, const T& value )
+                              co::LocalNodePtr client, const T& value,
+                              const Format format )
 {
-    Object<T> object( value );
+    Object<T> object( value, format );
     TEST( client->registerObject( &object ) );
 
     Object<T> remoteObject;
@@ -72,6 +93,13 @@ void testObjectSerialization( co::LocalNodePtr server,
 
     TEST( object.getValue() == remoteObject.getValue() );
 
+    // the initial data has no receivers, commits go to the mapped node
+    const co::uint128_t version = object.commit();
+    TEST( version != co::VERSION_NONE );
+    TEST( remoteObject.sync( version ) == version );
+    TEST( object.getValue() == remoteObject.getValue() );
+    TEST( object.isNative() == ( format != FORMAT_PORTABLE ));
+
     server->unmapObject( &remoteObject );
     client->deregisterObject( &object );
 }
@@ -103,12 +131,28 @@ int main( int argc, char **argv )
     TEST( client->listen( ));
     TEST( client->connect( serverProxy ));
 
-    testObjectSerialization( server, client, 42 );
-    testObjectSerialization( server, client, 5.f );
-    testObjectSerialization( server, client, false );
-    testObjectSerialization( server, client, std::string( "blablub" ));
-    testObjectSerialization( server, client, co::uint128_t( 12345, 54321 ));
-    testObjectSerialization( server, client, std::vector< int >( 9 ));
+    // both nodes run this version on the same host
+    co::NodePtr clientProxy = server->getNode( client->getNodeID( ));
+    TEST( serverProxy->isNativeArchive( ));
+    TEST( clientProxy->isNativeArchive( ));
+
+    for( int i = FORMAT_RECEIVERS; i <= FORMAT_NATIVE; ++i )
+    {
+        const Format format = Format( i );
+        testObjectSerialization( server, client, 42, format );
+        testObjectSerialization( server, client, 5.f, format );
+        testObjectSerialization( server, client, false, format );
+        testObjectSerialization( server, client, true, format );
+        testObjectSerialization( server, client, -1234567890123ll, format );
+        testObjectSerialization( server, client, -1234567890l, format );
+        testObjectSerialization( server, client, 4000000000ul, format );
+        testObjectSerialization( server, client, std::string( "blablub" ),
+                                 format );
+        testObjectSerialization( server, client,
+                                 co::uint128_t( 12345, 54321 ), format );
+        testObjectSerialization( server, client, std::vector< int >( 9 ),
+                                 format );
+    }
 
     TEST( client->disconnect( serverProxy ));
     TEST( client->close( ));
@@ -0,0 +1,356 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Measures DataOStream and DataIStream container (de)serialization speed
+// and the streamed bytes over container types and sizes, in the fixed and
+// the compact encoding.
+// Usage: ./dataStreamperf
+
+#include <test.h>
+
+#include <co/buffer.h>
+#include <co/bufferCache.h>
+#include <co/commandQueue.h>
+#include <co/connection.h>
+#include <co/connectionDescription.h>
+#include <co/dataIStream.h>
+#include <co/dataOStream.h>
+#include <co/init.h>
+
+#include <lunchbox/clock.h>
+#include <lunchbox/monitor.h>
+#include <lunchbox/thread.h>
+
+#include <co/objectDataOCommand.h> // private header
+#include <co/objectDataICommand.h> // private header
+
+#include <iomanip>
+#include <iostream>
+
+// number of elements streamed per container type and size
+#define NELEMS LB_1MB
+
+struct Pod
+{
+    uint32_t index;
+    float value;
+};
+
+namespace co
+{
+template<> struct IsFlat< Pod > : public std::true_type {};
+}
+
+namespace lunchbox
+{
+template<> inline void byteswap( Pod& value )
+{
+    byteswap( value.index );
+    byteswap( value.value );
+}
+}
+
+namespace
+{
+lunchbox::Monitor< size_t > _stage;
+
+void _fill( std::vector< uint32_t >& value, const size_t size )
+{
+    for( size_t i = 0; i < size; ++i )
+        value.push_back( uint32_t( i ));
+}
+
+void _fill( std::vector< Pod >& value, const size_t size )
+{
+    value.resize( size );
+    for( size_t i = 0; i < size; ++i )
+    {
+        value[i].index = uint32_t( i );
+        value[i].value = float( i );
+    }
+}
+
+void _fill( std::vector< std::string >& value, const size_t size )
+{
+    for( size_t i = 0; i < size; ++i )
+        value.push_back( "element" );
+}
+
+void _fill( std::map< uint32_t, float >& value, const size_t size )
+{
+    for( size_t i = 0; i < size; ++i )
+        value[ uint32_t( i ) ] = float( i );
+}
+
+void _fill( std::vector< co::ObjectVersion >& value, const size_t size )
+{
+    for( size_t i = 0; i < size; ++i )
+        value.push_back( co::ObjectVersion( co::UUID( true ),
+                                            co::uint128_t( i )));
+}
+
+void _fill( std::set< uint64_t >& value, const size_t size )
+{
+    for( size_t i = 0; i < size; ++i )
+        value.insert( i );
+}
+
+void _fill( stde::hash_map< uint32_t, double >& value, const size_t size )
+{
+    for( size_t i = 0; i < size; ++i )
+        value[ uint32_t( i ) ] = double( i );
+}
+
+/**
+ * Runs the visitor on all container types and sizes in both encodings, in the
+ * same order.
+ */
+template< class V > void _visit( V& visitor )
+{
+    for( size_t i = 0; i < 2; ++i )
+    {
+        const bool compact = i == 1;
+        for( size_t size = 16; size <= LB_64KB; size *= 64 )
+        {
+            visitor.template run< std::vector< uint32_t > >(
+                "vector<uint32_t>", size, compact );
+            visitor.template run< std::vector< Pod > >( "vector<Pod>", size,
+                                                        compact );
+            visitor.template run< std::vector< std::string > >(
+                "vector<string>", size, compact );
+            visitor.template run< std::vector< co::ObjectVersion > >(
+                "vector<ObjectVersion>", size, compact );
+            visitor.template run< std::map< uint32_t, float > >(
+                "map<uint32_t,float>", size, compact );
+            visitor.template run< std::set< uint64_t > >( "set<uint64_t>",
+                                                          size, compact );
+            visitor.template run< stde::hash_map< uint32_t, double > >(
+                "hash_map<uint32_t,double>", size, compact );
+        }
+    }
+}
+
+class DataOStream : public co::DataOStream
+{
+public:
+    DataOStream() : nBytes( 0 ) {}
+
+    uint64_t nBytes; //!< sent data bytes, without command headers
+
+protected:
+    virtual void sendData( const void* buffer, const uint64_t size,
+                           const bool last )
+        {
+            nBytes += size;
+            co::ObjectDataOCommand( getConnections(), co::CMD_OBJECT_DELTA,
+                                    co::COMMANDTYPE_OBJECT, co::UUID(), 0,
+                                    co::uint128_t(), 0, size, last, this );
+        }
+};
+
+class DataIStream : public co::DataIStream
+{
+public:
+    DataIStream() : co::DataIStream( false /*swap*/ ){}
+
+    void addDataCommand( co::ConstBufferPtr buffer )
+        {
+            co::ObjectDataICommand command( 0, 0, buffer, false /*swap*/ );
+            setCompact( command.isCompactData( ));
+            _commands.push( command );
+        }
+
+    virtual size_t nRemainingBuffers() const { return _commands.getSize(); }
+    virtual lunchbox::uint128_t getVersion() const { return co::VERSION_NONE;}
+    virtual co::NodePtr getMaster() { return 0; }
+
+protected:
+    virtual bool getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
+                                const void** chunkData, uint64_t& size )
+        {
+            co::ICommand cmd = _commands.tryPop();
+            if( !cmd.isValid( ))
+                return false;
+
+            co::ObjectDataICommand command( cmd );
+            size = command.getDataSize();
+            compressor = command.getCompressor();
+            nChunks = command.getChunks();
+            *chunkData = command.getRemainingBuffer( size );
+            return true;
+        }
+
+private:
+    co::CommandQueue _commands;
+};
+
+/** Receives the commands of one stream. */
+void _receive( co::ConnectionPtr connection, ::DataIStream& stream,
+               co::BufferCache& bufferCache )
+{
+    bool receiving = true;
+    while( receiving )
+    {
+        co::BufferPtr buffer = bufferCache.alloc( co::COMMAND_ALLOCSIZE );
+        connection->recvNB( buffer, co::COMMAND_MINSIZE );
+        TEST( connection->recvSync( buffer ));
+
+        co::ICommand command( 0, 0, buffer, false );
+        if( command.getSize() > buffer->getMaxSize( ))
+        {
+            co::BufferPtr newBuffer = bufferCache.alloc( command.getSize( ));
+            newBuffer->replace( *buffer );
+            command = co::ICommand( 0, 0, newBuffer, false );
+            buffer = newBuffer;
+        }
+        if( command.getSize() > buffer->getSize( ))
+        {
+            connection->recvNB( buffer, command.getSize() - buffer->getSize( ));
+            TEST( connection->recvSync( buffer ));
+        }
+
+        TEST( command.getCommand() == co::CMD_OBJECT_DELTA );
+        stream.addDataCommand( buffer );
+        receiving = !co::ObjectDataICommand( command ).isLast();
+    }
+}
+
+class Reader
+{
+public:
+    Reader( co::ConnectionPtr connection )
+        : _connection( connection ), _bufferCache( 200 ) {}
+
+    template< class C > void run( const char*, const size_t size,
+                                  const bool compact )
+        {
+            ++_stage; // let the writer start
+            ::DataIStream stream;
+            _receive( _connection, stream, _bufferCache );
+
+            C value;
+            lunchbox::Clock clock;
+            for( size_t i = 0; i < NELEMS / size; ++i )
+                stream >> value;
+            times.push_back( clock.getTimef( ));
+            TEST( value.size() == size );
+            TEST( stream.isCompact() == compact );
+        }
+
+    std::vector< float > times;
+
+private:
+    co::ConnectionPtr _connection;
+    co::BufferCache _bufferCache;
+};
+
+class Printer
+{
+public:
+    Printer( const std::vector< float >& writeTimes,
+             const std::vector< float >& readTimes,
+             const std::vector< uint64_t >& bytes )
+        : _writeTimes( writeTimes ), _readTimes( readTimes ), _bytes( bytes )
+        , _index( 0 ) {}
+
+    template< class C > void run( const char* name, const size_t size,
+                                  const bool compact )
+        {
+            const float mItems = NELEMS / 1000.f; // MItems/s * ms
+            std::cout << std::setw( 26 ) << name << std::setw( 6 ) << size
+                      << ( compact ? " compact" : "   fixed" )
+                      << std::setw( 10 ) << mItems / _writeTimes[ _index ]
+                      << " MItems/s write" << std::setw( 10 )
+                      << mItems / _readTimes[ _index ] << " MItems/s read"
+                      << std::setw( 8 ) << std::setprecision( 3 )
+                      << float( _bytes[ _index ] ) / float( NELEMS )
+                      << " bytes/item" << std::endl;
+            ++_index;
+        }
+
+private:
+    const std::vector< float >& _writeTimes;
+    const std::vector< float >& _readTimes;
+    const std::vector< uint64_t >& _bytes;
+    size_t _index;
+};
+}
+
+namespace co
+{
+namespace DataStreamTest
+{
+class Sender : public lunchbox::Thread
+{
+public:
+    Sender( co::ConnectionPtr connection )
+        : _connection( connection ), _nCases( 0 ) {}
+
+    template< class C > void run( const char*, const size_t size,
+                                  const bool compact )
+        {
+            C value;
+            _fill( value, size );
+            _stage.waitGE( ++_nCases );
+
+            ::DataOStream stream;
+            stream._setupConnection( _connection );
+            stream._setCompact( compact );
+            stream._enable();
+
+            lunchbox::Clock clock;
+            for( size_t i = 0; i < NELEMS / size; ++i )
+                stream << value;
+            stream.disable();
+            times.push_back( clock.getTimef( ));
+            bytes.push_back( stream.nBytes );
+        }
+
+    std::vector< float > times;
+    std::vector< uint64_t > bytes;
+
+protected:
+    void run() override { _visit( *this ); }
+
+private:
+    co::ConnectionPtr _connection;
+    size_t _nCases;
+};
+}
+}
+
+int main( int argc, char **argv )
+{
+    co::init( argc, argv );
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_PIPE;
+    co::ConnectionPtr connection = co::Connection::create( desc );
+
+    TEST( connection->connect( ));
+    co::DataStreamTest::Sender sender( connection->acceptSync( ));
+    TEST( sender.start( ));
+
+    Reader reader( connection );
+    _visit( reader );
+    TEST( sender.join( ));
+
+    Printer printer( sender.times, reader.times, sender.bytes );
+    _visit( printer );
+
+    connection->close();
+    co::exit();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+/* Copyright (c) 2013, Stefan.Eilemann@epfl.ch
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Measures the number of commands dispatched per second, directly through a
+// CommandFunc or a compile-time bound handler, and through a command queue,
+// compared to the previous dispatch with separate handler, queue and
+// scheduling tables.
+// Usage: ./dispatcherperf [numCommands]
+
+#include <test.h>
+
+#include <co/buffer.h>
+#include <co/bufferCache.h>
+#include <co/commandQueue.h>
+#include <co/iCommand.h>
+#include <co/init.h>
+#include <co/localNode.h>
+#include <co/oCommand.h>
+
+#include <lunchbox/clock.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace
+{
+enum
+{
+    CMD_DIRECT = co::CMD_NODE_CUSTOM,
+    CMD_BOUND,
+    CMD_QUEUED,
+    CMD_URGENT
+};
+
+/**
+ * The dispatch used before the flat command table, with parallel handler,
+ * queue and scheduling tables, as reference for the current dispatch. The
+ * checks of the previous Dispatcher::dispatchCommand() are kept.
+ */
+class PreviousDispatcher
+{
+public:
+    void registerCommand( const uint32_t command,
+                          const co::Dispatcher::Func& func,
+                          co::CommandQueue* queue,
+                          const co::CommandPriority priority =
+                              co::COMMANDPRIORITY_NORMAL )
+    {
+        if( _fTable.size() <= command )
+        {
+            _fTable.resize( command + 1, func );
+            _qTable.resize( command + 1, 0 );
+            _pTable.resize( command + 1,
+                            std::make_pair( co::COMMANDPRIORITY_NORMAL, 0u ));
+        }
+        _fTable[ command ] = func;
+        _qTable[ command ] = queue;
+        _pTable[ command ] = std::make_pair( priority, 0u );
+    }
+
+    bool dispatchCommand( co::ICommand& command )
+    {
+        LBASSERT( command.isValid( ));
+
+        LBVERB << "dispatch " << command << " on previous dispatcher"
+               << std::endl;
+
+        const uint32_t which = command.getCommand();
+#ifndef NDEBUG
+        if( which >= _qTable.size( ))
+        {
+            LBABORT( "ICommand " << command
+                     << " higher than number of registered command handlers ("
+                     << _qTable.size() << ")" << std::endl );
+            return false;
+        }
+#endif
+
+        co::CommandQueue* queue = _qTable[ which ];
+        if( queue )
+        {
+            command.setDispatchFunction( _fTable[ which ] );
+            command.setPriority( _pTable[ which ].first,
+                                 _pTable[ which ].second );
+            queue->push( command );
+            return true;
+        }
+        // else
+
+        LBCHECK( _fTable[ which ]( command ));
+        return true;
+    }
+
+private:
+    std::vector< co::Dispatcher::Func > _fTable;
+    std::vector< co::CommandQueue* > _qTable;
+    std::vector< std::pair< co::CommandPriority, uint32_t > > _pTable;
+};
+
+class PerfNode : public co::LocalNode
+{
+public:
+    PerfNode() : nHandled( 0 )
+    {
+        registerCommand( CMD_DIRECT,
+                         co::CommandFunc< PerfNode >( this,
+                                                      &PerfNode::_cmdCount ),
+                         0 );
+        registerCommand< PerfNode, &PerfNode::_cmdCount >( CMD_BOUND, 0 );
+        registerCommand( CMD_QUEUED, &PerfNode::_cmdCount, &queue );
+        registerCommand( CMD_URGENT, &PerfNode::_cmdCount, &queue,
+                         co::COMMANDPRIORITY_HIGH );
+
+        const co::CommandFunc< PerfNode > func( this, &PerfNode::_cmdCount );
+        previous.registerCommand( CMD_DIRECT, func, 0 );
+        previous.registerCommand( CMD_BOUND, func, 0 );
+        previous.registerCommand( CMD_QUEUED, func, &queue );
+        previous.registerCommand( CMD_URGENT, func, &queue,
+                                  co::COMMANDPRIORITY_HIGH );
+    }
+
+    void drain()
+    {
+        while( !queue.isEmpty( ))
+        {
+            co::ICommands commands = queue.popAll();
+            for( co::ICommandsIter i = commands.begin(); i != commands.end();
+                 ++i )
+            {
+                TEST( (*i)( ));
+            }
+        }
+    }
+
+    co::CommandQueue queue;
+    PreviousDispatcher previous;
+    size_t nHandled;
+
+private:
+    bool _cmdCount( co::ICommand& ) { ++nHandled; return true; }
+};
+
+/** @return the time in ms to dispatch and handle nCommands. */
+float _run( PerfNode& node, co::ICommand& command, const uint32_t cmd,
+            const bool prioritized, const bool usePrevious,
+            const size_t nCommands )
+{
+    static const size_t batchSize = 1000; // queued commands between drains
+
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < nCommands; ++i )
+    {
+        const bool urgent = prioritized && i % 2;
+        command.setCommand( urgent ? uint32_t( CMD_URGENT ) : cmd );
+        if( usePrevious )
+        {
+            TEST( node.previous.dispatchCommand( command ));
+        }
+        else // skip the LocalNode command type dispatch
+        {
+            TEST( node.co::Dispatcher::dispatchCommand( command ));
+        }
+        if( ( i + 1 ) % batchSize == 0 )
+            node.drain();
+    }
+    node.drain();
+    return clock.getTimef();
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+    const size_t nCommands = argc > 1 ? std::atoi( argv[1] ) : 1000000;
+
+    co::BufferCache cache( 10 );
+    lunchbox::RefPtr< PerfNode > node = new PerfNode;
+    const uint64_t size = co::OCommand::getSize();
+    co::BufferPtr buffer = cache.alloc( co::COMMAND_ALLOCSIZE );
+    buffer->resize( size );
+    reinterpret_cast< uint64_t* >( buffer->getData( ))[ 0 ] = size;
+
+    co::ICommand command( node, node, buffer, false );
+    command.setType( co::COMMANDTYPE_NODE );
+
+    // The previous dispatch has no compile-time bound handlers, its 'Bound'
+    // run uses the CommandFunc as before.
+    static const char* const names[] = { "Direct", "Bound", "Queued",
+                                         "Prioritized" };
+    static const uint32_t commands[] = { CMD_DIRECT, CMD_BOUND, CMD_QUEUED,
+                                         CMD_QUEUED };
+    for( size_t i = 0; i < 4; ++i )
+    {
+        const float previousTime = _run( *node, command, commands[i], i == 3,
+                                         true, nCommands );
+        const float time = _run( *node, command, commands[i], i == 3, false,
+                                 nCommands );
+        std::cout << names[i] << ": " << nCommands / time << " commands/ms ("
+                  << nCommands << " in " << time << " ms), previous dispatch "
+                  << nCommands / previousTime << " commands/ms, speedup "
+                  << previousTime / time << std::endl;
+    }
+
+    TESTINFO( node->nHandled == 8 * nCommands, node->nHandled );
+    command.clear();
+    buffer = 0;
+    node = 0;
+    TEST( co::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@eyescale.ch>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <co/init.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/thread.h>
+
+#include <co/leftRight.h> // private header
+
+#include <vector>
+
+// Tests that readers of a LeftRight see complete modifications, and never see
+// items after they have been removed.
+
+#define N_READERS 4
+#define RUNTIME 2000
+#define N_ITEMS 64
+
+namespace
+{
+struct Item
+{
+    Item() : valid( true ) {}
+    volatile bool valid;
+};
+typedef std::vector< Item* > Items;
+
+co::LeftRight< Items > _items;
+lunchbox::a_int32_t _running( 1 );
+
+struct AddItem
+{
+    explicit AddItem( Item* item_ ) : item( item_ ) {}
+    void operator()( Items& items ) const { items.push_back( item ); }
+    Item* const item;
+};
+
+struct RemoveItem
+{
+    void operator()( Items& items ) const { items.erase( items.begin( )); }
+};
+
+class Reader : public lunchbox::Thread
+{
+public:
+    Reader() : nReads( 0 ) {}
+
+    size_t nReads;
+
+protected:
+    virtual void run()
+    {
+        while( _running != 0 )
+        {
+            const co::LeftRight< Items >::Reader items( _items );
+            for( Items::const_iterator i = items->begin();
+                 i != items->end(); ++i )
+            {
+                TEST( (*i)->valid );
+            }
+            ++nReads;
+        }
+    }
+};
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+    Reader readers[ N_READERS ];
+    for( size_t i = 0; i < N_READERS; ++i )
+        TEST( readers[i].start( ));
+
+    Items items;
+    size_t nWrites = 0;
+    lunchbox::Clock clock;
+    while( clock.getTime64() < RUNTIME )
+    {
+        Item* item = new Item;
+        _items.modify( AddItem( item ));
+        items.push_back( item );
+        TEST( _items->size() == items.size( ));
+
+        if( items.size() < N_ITEMS )
+            continue;
+
+        // no reader uses the removed item anymore
+        _items.modify( RemoveItem( ));
+        Item* removed = items.front();
+        items.erase( items.begin( ));
+        removed->valid = false;
+        delete removed;
+        ++nWrites;
+    }
+
+    _running = 0;
+    size_t nReads = 0;
+    for( size_t i = 0; i < N_READERS; ++i )
+    {
+        TEST( readers[i].join( ));
+        nReads += readers[i].nReads;
+    }
+
+    for( Items::const_iterator i = items.begin(); i != items.end(); ++i )
+        delete *i;
+
+    std::cout << nWrites / RUNTIME << " writes, " << nReads / RUNTIME
+              << " reads/ms" << std::endl;
+
+    TEST( co::exit( ));
+    return EXIT_SUCCESS;
+}
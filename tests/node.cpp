@@ -20,6 +20,7 @@
 
 #include <co/connection.h>
 #include <co/connectionDescription.h>
+#include <co/global.h>
 #include <co/iCommand.h>
 #include <co/init.h>
 #include <co/node.h>
@@ -74,17 +75,17 @@ protected:
             return true;
         }
 
+public:
+    void reset() { _messagesLeft = NMESSAGES; }
+
 private:
     unsigned _messagesLeft;
 };
 
-int main( int argc, char **argv )
+namespace
+{
+void _testSend( const uint16_t port )
 {
-    co::init( argc, argv );
-
-    lunchbox::RNG rng;
-    const uint16_t port = (rng.get<uint16_t>() % 60000) + 1024;
-
     lunchbox::RefPtr< Server > server = new Server;
     co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
 
@@ -107,18 +108,35 @@ int main( int argc, char **argv )
     TEST( client->listen( ));
     TEST( client->connect( serverProxy ));
 
-    lunchbox::Clock clock;
-    for( unsigned i = 0; i < NMESSAGES; ++i )
-        serverProxy->send( co::CMD_NODE_CUSTOM ) << message;
-    const float time = clock.getTimef();
-
-    const size_t size = NMESSAGES * ( co::OCommand::getSize() +
-                                      message.length() - 7 );
-    std::cout << "Send " << size << " bytes using " << NMESSAGES
-              << " commands in " << time << "ms" << " ("
-              << size / 1024. * 1000.f / time << " KB/s)" << std::endl;
-
-    monitor.waitEQ( true );
+    for( size_t mode = 0; mode < 4; ++mode )
+    {
+        const bool batching = mode & 1;
+        const bool async = mode & 2;
+        monitor = false;
+        server->reset();
+        serverProxy->setSendBatching( batching );
+        serverProxy->setAsyncSend( async );
+        TEST( serverProxy->isSendBatching() == batching );
+        TEST( serverProxy->isAsyncSend() == async );
+
+        lunchbox::Clock clock;
+        for( unsigned i = 0; i < NMESSAGES; ++i )
+            serverProxy->send( co::CMD_NODE_CUSTOM ) << message;
+        serverProxy->flushSendBatch();
+        const float time = clock.getTimef();
+
+        const size_t size = NMESSAGES * ( co::OCommand::getSize() +
+                                          message.length() - 7 );
+        std::cout << "Send " << size << " bytes using " << NMESSAGES
+                  << ( batching ? " batched" : "" ) << ( async ? " async" : "" )
+                  << " commands in " << time
+                  << "ms" << " (" << size / 1024. * 1000.f / time << " KB/s)"
+                  << std::endl;
+
+        monitor.waitEQ( true );
+    }
+    serverProxy->setSendBatching( false );
+    serverProxy->setAsyncSend( false );
 
     TEST( client->disconnect( serverProxy ));
     TEST( client->close( ));
@@ -127,10 +145,27 @@ int main( int argc, char **argv )
     TESTINFO( serverProxy->getRefCount() == 1, serverProxy->getRefCount( ));
     TESTINFO( client->getRefCount() == 1, client->getRefCount( ));
     TESTINFO( server->getRefCount() == 1, server->getRefCount( ));
+}
+}
+
+int main( int argc, char **argv )
+{
+    co::init( argc, argv );
+
+    lunchbox::RNG rng;
+    const uint16_t port = (rng.get<uint16_t>() % 60000) + 1024;
 
-    serverProxy = 0;
-    client      = 0;
-    server      = 0;
+    // default two-read receive, and read ahead to parse many commands per
+    // receive
+    static const int32_t receiveBufferSizes[] = { 0, 65536 };
+    for( size_t i = 0; i < 2; ++i )
+    {
+        std::cout << "Receive buffer size " << receiveBufferSizes[ i ]
+                  << std::endl;
+        co::Global::setIAttribute( co::Global::IATTR_NODE_RECEIVE_BUFFER_SIZE,
+                                   receiveBufferSizes[ i ] );
+        _testSend( port + uint16_t( i ));
+    }
 
     co::exit();
     return EXIT_SUCCESS;
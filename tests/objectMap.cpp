@@ -43,10 +43,43 @@ protected:
 typedef TestObject Foo;
 typedef TestObject Bar;
 
+class Baz : public co::Serializable
+{
+public:
+    Baz() {}
+
+    void setMessage( const std::string& message_ )
+    {
+        message = message_;
+        setDirty( DIRTY_MESSAGE );
+    }
+
+    std::string message;
+
+protected:
+    enum DirtyBits
+    {
+        DIRTY_MESSAGE = co::Serializable::DIRTY_CUSTOM << 0
+    };
+
+    virtual void serialize( co::DataOStream& os, const uint64_t dirtyBits )
+    {
+        if( dirtyBits & DIRTY_MESSAGE )
+            os << message;
+    }
+
+    virtual void deserialize( co::DataIStream& is, const uint64_t dirtyBits )
+    {
+        if( dirtyBits & DIRTY_MESSAGE )
+            is >> message;
+    }
+};
+
 enum ObjectType
 {
     TYPE_FOO = co::OBJECTTYPE_CUSTOM,
-    TYPE_BAR
+    TYPE_BAR,
+    TYPE_BAZ
 };
 
 static Foo* clientFoo = 0;
@@ -118,6 +151,13 @@ int main( int argc, char **argv )
         TEST( client->listen( ));
         TEST( client->connect( serverProxy ));
 
+        // compact object data, announced in the connect handshake
+        co::NodePtr clientProxy = server->getNode( client->getNodeID( ));
+        TEST( clientProxy );
+        TEST( !clientProxy->isCompactData( ));
+        clientProxy->setCompactData( true );
+        TEST( clientProxy->isCompactData( ));
+
         // init
         TEST( server->registerObject( &server->objectMap ));
         TEST( client->mapObject( &client->objectMap, &server->objectMap ));
@@ -156,6 +196,31 @@ int main( int argc, char **argv )
         client->objectMap.sync( server->objectMap.commit( ));
         TEST( clientBar.message == "hello again" );
 
+        // Test commit() of Serializable masters
+        Baz masterBaz;
+        TEST( server->objectMap.register_( &masterBaz, TYPE_BAZ ));
+        client->objectMap.sync( server->objectMap.commit( ));
+
+        Baz clientBaz;
+        TEST( client->objectMap.map( masterBaz.getID(),
+                                     &clientBaz ) == &clientBaz );
+        masterBaz.setMessage( "hello baz" );
+        client->objectMap.sync( server->objectMap.commit( ));
+        TEST( clientBaz.message == "hello baz" );
+        TEST( masterBaz.getVersion() == clientBaz.getVersion( ));
+
+        // Test commit() of Serializable masters with dirty tracking
+        server->objectMap.setDirtyTracking( true );
+        TEST( server->objectMap.isDirtyTracking( ));
+        masterBaz.setMessage( "tracked baz" );
+        client->objectMap.sync( server->objectMap.commit( ));
+        TEST( clientBaz.message == "tracked baz" );
+        TEST( masterBaz.getVersion() == clientBaz.getVersion( ));
+        server->objectMap.setDirtyTracking( false );
+
+        TEST( client->objectMap.unmap( &clientBaz ));
+        TEST( server->objectMap.deregister( &masterBaz ));
+
         // Test unmap()
         TEST( client->objectMap.unmap( clientFoo ));
 
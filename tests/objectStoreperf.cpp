@@ -0,0 +1,119 @@
+/* Copyright (c) 2013, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Measures the object command dispatch rate of a local node over the number of
+// registered objects. Each command is sent to a random registered object and
+// looked up by the object store in the receiver thread.
+// Usage: ./objectStoreperf
+
+#include <test.h>
+
+#include <co/commands.h>
+#include <co/iCommand.h>
+#include <co/init.h>
+#include <co/localNode.h>
+#include <co/object.h>
+#include <co/objectOCommand.h>
+
+#include <lunchbox/clock.h>
+#include <lunchbox/monitor.h>
+#include <lunchbox/rng.h>
+
+#include <iomanip>
+#include <iostream>
+
+// registered objects in the last run
+#define NOBJECTS 100000
+
+// commands sent per run
+#define NCOMMANDS 200000
+
+namespace
+{
+static const uint32_t CMD_OBJECT_PING = co::CMD_OBJECT_CUSTOM;
+
+lunchbox::Monitor< uint32_t > _received( 0 );
+
+class Object : public co::Object
+{
+public:
+    Object()
+    {
+        // handled directly in the receiver thread
+        registerCommand( CMD_OBJECT_PING, &Object::_cmdPing, 0 );
+    }
+
+protected:
+    virtual ChangeType getChangeType() const { return STATIC; }
+    virtual void getInstanceData( co::DataOStream& ) {}
+    virtual void applyInstanceData( co::DataIStream& ) {}
+
+private:
+    bool _cmdPing( co::ICommand& )
+    {
+        ++_received;
+        return true;
+    }
+};
+typedef std::vector< Object* > Objects;
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+    co::LocalNodePtr node = new co::LocalNode;
+    TEST( node->listen( ));
+
+    Objects objects;
+    lunchbox::RNG rng;
+    lunchbox::Clock clock;
+
+    for( size_t nObjects = 1; nObjects <= NOBJECTS; nObjects *= 10 )
+    {
+        while( objects.size() < nObjects )
+        {
+            Object* object = new Object;
+            TEST( node->registerObject( object ));
+            objects.push_back( object );
+        }
+
+        const uint32_t received = _received.get();
+        clock.reset();
+        for( size_t i = 0; i < NCOMMANDS; ++i )
+        {
+            Object* object = objects[ rng.get< uint32_t >() % nObjects ];
+            object->send( node.get(), CMD_OBJECT_PING );
+        }
+        _received.waitGE( received + NCOMMANDS );
+        const float time = clock.getTimef();
+
+        std::cout << std::setw( 7 ) << nObjects << " objects: "
+                  << std::setw( 10 ) << NCOMMANDS / time * 1000.f
+                  << " commands/s" << std::endl;
+    }
+
+    for( Objects::const_iterator i = objects.begin(); i != objects.end(); ++i )
+    {
+        node->deregisterObject( *i );
+        delete *i;
+    }
+
+    TEST( node->close( ));
+    node = 0;
+    TEST( co::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -15,7 +15,8 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
-// Tests network throughput
+// Tests network throughput, or sweeps the socket tuning profiles over a
+// local connection, measuring throughput and round trip latency.
 // Usage: see 'netPerf -h'
 
 #define LB_RELEASE_ASSERT
@@ -291,6 +292,118 @@ private:
     bool _useThreads;
 };
 
+/** Receives a number of packets, optionally echoing each one. */
+class Sink : public lunchbox::Thread
+{
+public:
+    Sink( co::ConnectionPtr connection, const size_t packetSize,
+          const size_t nPackets, const bool echo )
+            : _connection( connection )
+            , _packetSize( packetSize )
+            , _nPackets( nPackets )
+            , _echo( echo )
+        {}
+
+    void run() override
+        {
+            co::Buffer buffer;
+            co::BufferPtr syncBuffer;
+            for( size_t i = 0; i < _nPackets; ++i )
+            {
+                buffer.setSize( 0 );
+                _connection->recvNB( &buffer, _packetSize );
+                if( !_connection->recvSync( syncBuffer ))
+                    return;
+                if( _echo && !_connection->send( buffer.getData(),
+                                                 buffer.getSize( )))
+                {
+                    return;
+                }
+            }
+        }
+
+private:
+    co::ConnectionPtr _connection;
+    const size_t _packetSize;
+    const size_t _nPackets;
+    const bool _echo;
+};
+
+static const size_t _nRoundTrips = 10000;
+static const size_t _pingSize = 64;
+
+bool _sweep( co::ConnectionDescriptionPtr description, const size_t packetSize,
+             const size_t nPackets )
+{
+    static const co::SocketProfile profiles[] = { co::SOCKETPROFILE_DEFAULT,
+                                                  co::SOCKETPROFILE_LATENCY,
+                                                co::SOCKETPROFILE_THROUGHPUT };
+    const size_t nProfiles = sizeof( profiles ) / sizeof( profiles[0] );
+
+    for( size_t i = 0; i < nProfiles; ++i )
+    {
+        description->profile = profiles[i];
+        co::ConnectionPtr listener = co::Connection::create( description );
+        if( !listener || !listener->listen( ))
+        {
+            LBERROR << "Can't listen on " << *description << std::endl;
+            return false;
+        }
+        listener->acceptNB();
+
+        std::string data = listener->getDescription()->toString();
+        co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+        desc->fromString( data );
+        co::ConnectionPtr client = co::Connection::create( desc );
+        if( !client || !client->connect( ))
+        {
+            LBERROR << "Can't connect to " << *desc << std::endl;
+            return false;
+        }
+        co::ConnectionPtr server = listener->acceptSync();
+        LBASSERT( server );
+
+        // latency: ping-pong of small packets
+        Sink echo( server, _pingSize, _nRoundTrips, true );
+        echo.start();
+
+        uint8_t ping[ _pingSize ] = { 0 };
+        co::Buffer pong;
+        co::BufferPtr syncBuffer;
+        lunchbox::Clock clock;
+        for( size_t j = 0; j < _nRoundTrips; ++j )
+        {
+            pong.setSize( 0 );
+            client->recvNB( &pong, _pingSize );
+            LBCHECK( client->send( ping, _pingSize ));
+            LBCHECK( client->recvSync( syncBuffer ));
+        }
+        const float latency = clock.getTimef() * 1000.f / _nRoundTrips;
+        echo.join();
+
+        // throughput: stream large packets
+        Sink sink( server, packetSize, nPackets, false );
+        sink.start();
+
+        lunchbox::Buffer< uint8_t > buffer;
+        buffer.resize( packetSize );
+        clock.reset();
+        for( size_t j = 0; j < nPackets; ++j )
+            LBCHECK( client->send( buffer.getData(), buffer.getSize( )));
+        sink.join();
+        const float time = clock.getTimef();
+
+        std::cout << profiles[i] << ": "
+                  << packetSize * nPackets / 1024.f / 1024.f * 1000.f / time
+                  << " MB/s, " << latency << " us round trip" << std::endl;
+
+        client->close();
+        server->close();
+        listener->close();
+    }
+    return true;
+}
+
 }
 
 int main( int argc, char **argv )
@@ -302,6 +415,7 @@ int main( int argc, char **argv )
     description->port = 4242;
 
     bool isClient     = true;
+    bool isSweep      = false;
     bool useThreads   = false;
     size_t packetSize = 1048576;
     size_t nPackets   = 0xffffffffu;
@@ -317,6 +431,10 @@ int main( int argc, char **argv )
         TCLAP::ValueArg< std::string > serverArg( "s", "server",
                                                   "run as server", true, "",
                                                   "IP[:port][:protocol]" );
+        TCLAP::ValueArg< std::string > sweepArg( "a", "sweep",
+                        "measure all socket profiles over a local connection",
+                                                 true, "",
+                                                 "IP[:port][:CPUn]" );
         TCLAP::SwitchArg threadedArg( "t", "threaded",
                           "Run each receive in a separate thread (server only)",
                                       command, false );
@@ -334,10 +452,19 @@ int main( int argc, char **argv )
                                 "wait time (ms) between receives (server only)",
                                             false, 0, "unsigned", command );
 
-        command.xorAdd( clientArg, serverArg );
+        std::vector< TCLAP::Arg* > modes;
+        modes.push_back( &clientArg );
+        modes.push_back( &serverArg );
+        modes.push_back( &sweepArg );
+        command.xorAdd( modes );
         command.parse( argc, argv );
 
-        if( clientArg.isSet( ))
+        if( sweepArg.isSet( ))
+        {
+            isSweep = true;
+            description->fromString( sweepArg.getValue( ));
+        }
+        else if( clientArg.isSet( ))
             description->fromString( clientArg.getValue( ));
         else if( serverArg.isSet( ))
         {
@@ -365,6 +492,17 @@ int main( int argc, char **argv )
         return EXIT_FAILURE;
     }
 
+    if( isSweep )
+    {
+        // a finite default amount of data for each profile
+        const size_t nSweepPackets = nPackets == 0xffffffffu ?
+                                LB_MAX( LB_1GB / packetSize, size_t( 1 )) :
+                                     nPackets;
+        const bool ok = _sweep( description, packetSize, nSweepPackets );
+        LBCHECK( co::exit( ));
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     // run
     co::ConnectionPtr connection = co::Connection::create( description );
     if( !connection )
@@ -0,0 +1,272 @@
+/* Copyright (c) 2013, Stefan.Eilemann@epfl.ch
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Measures RSP throughput and repeat ratio of one writer and many readers in
+// one process, using the loopback interface and simulated datagram loss. The
+// loss simulation needs a library built with COLLAGE_RSP_SIMULATE_LOSS.
+// Optionally protects the data with forward error correction parities.
+// Usage: see 'coRSPperf -h'
+
+#include <co/co.h>
+#include <co/rspConnection.h>
+#include <lunchbox/sleep.h>
+#include <tclap/CmdLine.h>
+#include <iostream>
+
+namespace
+{
+class Reader : public lunchbox::Thread
+{
+public:
+    Reader( co::ConnectionPtr connection, const uint64_t size,
+            const uint64_t packetSize )
+        : _connection( connection )
+        , _size( size )
+        , _packetSize( packetSize )
+        , _time( 0.f )
+    {}
+
+    void run() override
+    {
+        lunchbox::Clock clock;
+        co::Buffer buffer;
+        co::BufferPtr syncBuffer;
+
+        for( uint64_t left = _size; left > 0; )
+        {
+            const uint64_t bytes = LB_MIN( left, _packetSize );
+            buffer.setSize( 0 );
+            _connection->recvNB( &buffer, bytes );
+            if( !_connection->recvSync( syncBuffer ))
+            {
+                LBERROR << "Read error, " << left << " bytes left"
+                        << std::endl;
+                return;
+            }
+            left -= bytes;
+        }
+        _time = clock.getTimef();
+    }
+
+    float getTime() const { return _time; }
+
+private:
+    co::ConnectionPtr _connection;
+    const uint64_t _size;
+    const uint64_t _packetSize;
+    float _time;
+};
+
+co::RSPConnection* _getRSP( co::ConnectionPtr connection )
+{
+    return static_cast< co::RSPConnection* >( connection.get( ));
+}
+
+bool _run( const size_t nReaders, const uint64_t size,
+           const uint64_t packetSize, const int32_t control,
+           const int32_t loss, const int32_t fec,
+           co::ConstConnectionDescriptionPtr base )
+{
+    co::Global::setIAttribute( co::Global::IATTR_RSP_RATE_CONTROL, control );
+    co::Global::setIAttribute( co::Global::IATTR_RSP_SIMULATED_LOSS, loss );
+    co::Global::setIAttribute( co::Global::IATTR_RSP_FEC_GROUP_SIZE, fec );
+
+    // writer is the first member, all members receive each other
+    co::Connections members;
+    for( size_t i = 0; i <= nReaders; ++i )
+    {
+        co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+        desc->type = co::CONNECTIONTYPE_RSP;
+        desc->bandwidth = base->bandwidth;
+        desc->setHostname( base->getHostname( ));
+        desc->setInterface( base->getInterface( ));
+        co::ConnectionPtr connection = co::Connection::create( desc );
+        if( !connection || !connection->listen( ))
+        {
+            LBERROR << "Can't set up RSP connection " << *desc << std::endl;
+            return false;
+        }
+        members.push_back( connection );
+    }
+    lunchbox::sleep( 1000 ); // let all members discover each other
+
+    const uint16_t writerID = _getRSP( members.front( ))->getID();
+    co::Connections children;
+    std::vector< Reader* > readers;
+    for( co::ConnectionsIter i = members.begin(); i != members.end(); ++i )
+    {
+        for( size_t j = 0; j <= nReaders; ++j )
+        {
+            co::ConnectionPtr child = (*i)->acceptSync();
+            if( !child )
+            {
+                LBERROR << "Missing RSP group member" << std::endl;
+                return false;
+            }
+            children.push_back( child );
+
+            // the writer also has to consume its own data
+            if( _getRSP( child )->getID() == writerID )
+            {
+                readers.push_back( new Reader( child, size, packetSize ));
+                readers.back()->start();
+            }
+        }
+    }
+
+    co::ConnectionPtr writer = members.front();
+    std::vector< uint8_t > data( packetSize );
+    lunchbox::Clock clock;
+    for( uint64_t left = size; left > 0; )
+    {
+        const uint64_t bytes = LB_MIN( left, packetSize );
+        if( !writer->send( &data.front(), bytes ))
+        {
+            LBERROR << "Write error, " << left << " bytes left" << std::endl;
+            return false;
+        }
+        left -= bytes;
+    }
+    writer->finish();
+    const float time = clock.getTimef();
+
+    const float mBytes = float( size ) / 1024.f / 1024.f;
+    const co::RSPConnection* rsp = _getRSP( writer );
+    uint64_t nRebuilt = 0;
+    for( size_t i = 1; i < members.size(); ++i )
+        nRebuilt += _getRSP( members[i] )->getNumRebuilt();
+
+    std::cout << ( control ? "equation" : "nack    " ) << " loss " << loss
+              << " permille, fec " << fec << ", " << nReaders << " readers: "
+              << mBytes * 1000.f / time << " MB/s, "
+              << rsp->getNumDatagrams() << " datagrams, "
+              << rsp->getNumRepeats() << " repeats ("
+              << 100.f * float( rsp->getNumRepeats( )) /
+                 float( LB_MAX( rsp->getNumDatagrams(), 1u ))
+              << "%), " << rsp->getNumParities() << " parities, " << nRebuilt
+              << " rebuilt, final rate " << rsp->getSendRate() << " KB/s"
+              << std::endl;
+
+    for( size_t i = 0; i < readers.size(); ++i )
+    {
+        readers[i]->join();
+        std::cout << "  reader " << i << ": "
+                  << mBytes * 1000.f / readers[i]->getTime() << " MB/s"
+                  << std::endl;
+        delete readers[i];
+    }
+
+    children.clear();
+    for( co::ConnectionsIter i = members.begin(); i != members.end(); ++i )
+        (*i)->close();
+    return true;
+}
+}
+
+int main( int argc, char **argv )
+{
+    if( !co::init( argc, argv ))
+        return EXIT_FAILURE;
+
+    size_t nReaders = 3;
+    uint64_t size = LB_100MB;
+    uint64_t packetSize = LB_1MB;
+    int32_t control = -1;
+#ifdef CO_RSP_SIMULATE_LOSS
+    int32_t loss = 10;
+#else
+    int32_t loss = 0;
+#endif
+    int32_t fec = 0;
+    co::ConnectionDescriptionPtr description = new co::ConnectionDescription;
+    description->type = co::CONNECTIONTYPE_RSP;
+    description->setHostname( "239.255.42.44" );
+    description->setInterface( "127.0.0.1" );
+
+    try // command line parsing
+    {
+        TCLAP::CmdLine command(
+            "rspperf - Collage RSP multicast benchmark tool", ' ',
+            co::Version::getString( ));
+        TCLAP::ValueArg< size_t > readersArg( "r", "readers",
+                                              "number of readers", false,
+                                              nReaders, "unsigned", command );
+        TCLAP::ValueArg< uint64_t > sizeArg( "s", "size",
+                                             "total bytes to send", false,
+                                             size, "unsigned", command );
+        TCLAP::ValueArg< uint64_t > packetArg( "p", "packetSize",
+                                               "bytes per send", false,
+                                               packetSize, "unsigned",
+                                               command );
+        TCLAP::ValueArg< int32_t > controlArg( "c", "control",
+                         "rate control, 0: nack-based, 1: equation-based, "
+                         "default: both", false, control, "int", command );
+        TCLAP::ValueArg< int32_t > lossArg( "l", "loss",
+                           "simulated loss of data datagrams in permille",
+                                            false, loss, "int", command );
+        TCLAP::ValueArg< int32_t > fecArg( "f", "fec",
+                         "data datagrams per FEC parity datagram, 0: no FEC",
+                                           false, fec, "int", command );
+        TCLAP::ValueArg< std::string > groupArg( "g", "group",
+                                                 "multicast group address",
+                                                 false,
+                                                 description->getHostname(),
+                                                 "IP", command );
+        TCLAP::ValueArg< std::string > interfaceArg( "i", "interface",
+                                                     "multicast interface",
+                                                     false,
+                                                    description->getInterface(),
+                                                     "IP", command );
+        TCLAP::ValueArg< int32_t > bandwidthArg( "b", "bandwidth",
+                                                 "maximum rate in KB/s", false,
+                                                 0, "int", command );
+        command.parse( argc, argv );
+
+        nReaders = std::max( readersArg.getValue(), size_t( 1 ));
+        size = std::max( sizeArg.getValue(), uint64_t( 1 ));
+        packetSize = std::max( packetArg.getValue(), uint64_t( 1 ));
+        control = controlArg.getValue();
+        loss = lossArg.getValue();
+#ifndef CO_RSP_SIMULATE_LOSS
+        if( loss > 0 )
+        {
+            LBWARN << "Library built without COLLAGE_RSP_SIMULATE_LOSS, "
+                   << "ignoring simulated loss" << std::endl;
+            loss = 0;
+        }
+#endif
+        fec = fecArg.getValue();
+        description->setHostname( groupArg.getValue( ));
+        description->setInterface( interfaceArg.getValue( ));
+        description->bandwidth = bandwidthArg.getValue();
+    }
+    catch( TCLAP::ArgException& exception )
+    {
+        LBERROR << "Command line parse error: " << exception.error()
+                << " for argument " << exception.argId() << std::endl;
+
+        co::exit();
+        return EXIT_FAILURE;
+    }
+
+    bool ok = true;
+    for( int32_t i = 0; i <= 1 && ok; ++i )
+        if( control < 0 || control == i )
+            ok = _run( nReaders, size, packetSize, i, loss, fec,
+                       description );
+
+    return co::exit() && ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}